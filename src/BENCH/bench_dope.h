@@ -0,0 +1,201 @@
+/**
+ * @file bench_dope.h
+ * @brief DOPE executor instructions per second: switch, threaded and fused
+ * @defgroup dope_benches DOPE Benchmarks
+ * @{
+ */
+#ifndef BENCH_DOPE_H
+#define BENCH_DOPE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_macros.h"
+#include "../DOPE/dope_compile.h"
+#include "../DOPE/dope_exec.h"
+#include "../DOPE/dope_optimize.h"
+#include "../FILEUTIL/file_map.h"
+#include "../STRUTIL/str_view.h"
+
+/// @brief Array of all DOPE benchmarks
+#define DOPE_BENCHES &bench_dope_dispatch
+
+#ifndef DOPE_TEST_PROGRAMS
+#define DOPE_TEST_PROGRAMS  "../bin/dope_test.txt"  ///< Set by CMake to the source tree's copy
+#endif
+#define BENCH_DOPE_MAX_PROGRAMS 16
+#define BENCH_DOPE_ANSWERS      256                 ///< Input lines, so J loops run for a while
+#define BENCH_DOPE_OUTPUT       (MEM_SIZE_64K)
+
+/// @brief Compute bound loop next to the I/O heavy test programs, where dispatch dominates
+static const char bench_dope_counting_loop[] =
+    "1'*'I'2'X\n"
+    "2'-'X'I'Y\n"
+    "3'+'I'1'I\n"
+    "4'C'I'1000'1'0\n";
+
+typedef struct {
+    char name[24];
+    const char* source;
+    uint32_t size;
+    dope_program_t* program;
+    dope_program_t* fused;      ///< Same source after dope_optimize()
+} bench_dope_program_t;
+
+static char bench_dope_answers[BENCH_DOPE_ANSWERS * 4];
+
+/**
+ * @brief Compiles source text held in memory
+ */
+static dope_program_t* bench_dope_compile(mem_arena_t* arena, const char* source, uint32_t size) {
+    dope_diagnostic_t diagnostic;
+    file_line_stream_t* lines = file_line_stream_create(arena, file_source_memory(arena, source, size));
+    dope_program_t* program = dope_compile(arena, lines, &diagnostic);
+    BENCH_CHECK(program, "compile error %s at line %lu", dope_compile_message(diagnostic.error), (unsigned long)diagnostic.source_line);
+    return program;
+}
+
+/**
+ * @brief Compiles a program twice, plain and optimized
+ */
+static bool bench_dope_prepare(mem_arena_t* arena, bench_dope_program_t* program) {
+    program->program = bench_dope_compile(arena, program->source, program->size);
+    program->fused = bench_dope_compile(arena, program->source, program->size);
+    if (!program->program || !program->fused) {
+        return false;
+    }
+    dope_optimize(program->fused);
+    return true;
+}
+
+/**
+ * @brief Splits the test file at blank lines, one program per paragraph
+ */
+static uint16_t bench_dope_split(mem_arena_t* arena, const file_map_t* map, bench_dope_program_t* programs) {
+    uint16_t count = 0;
+    const char* start = NULL;
+    uint32_t i;
+    for (i = 0; i <= map->line_count && count < BENCH_DOPE_MAX_PROGRAMS - 1; ++i) {
+        file_line_view_t line = { NULL, 0 };
+        if (i < map->line_count) {
+            line = file_map_line(map, i);
+        }
+        if (i < map->line_count && !str_view_is_blank(line)) {
+            if (!start) {
+                start = line.ptr;
+            }
+            continue;
+        }
+        if (start) {
+            bench_dope_program_t* program = &programs[count];
+            const char* end = i < map->line_count ? line.ptr : map->data + map->size;
+            sprintf(program->name, "test program %u", (unsigned)(count + 1));
+            program->source = start;
+            program->size = (uint32_t)(end - start);
+            if (bench_dope_prepare(arena, program)) {
+                ++count;
+            }
+            start = NULL;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief One run on a fresh machine; the run arena is emptied again afterwards
+ */
+static dope_status_t bench_dope_run(mem_arena_t* run_arena, const dope_program_t* program, FILE* output, dope_dispatch_t dispatch, uint32_t* instructions) {
+    mem_size_t used = mem_arena_used(run_arena);
+    file_source_t* input = file_source_memory(run_arena, bench_dope_answers, (uint32_t)strlen(bench_dope_answers));
+    dope_machine_t* machine = dope_exec_create(run_arena, program, input, output);
+    dope_status_t status = dope_exec_run_dispatch(machine, dispatch);
+    *instructions = dope_exec_instructions(machine);
+    mem_arena_dealloc(run_arena, mem_arena_used(run_arena) - used);
+    return status;
+}
+
+/**
+ * @brief Both loops, fused or not, must print the same text, stop the same way and count the same
+ */
+static void bench_dope_compare(mem_arena_t* run_arena, const bench_dope_program_t* program) {
+    static char outputs[4][BENCH_DOPE_OUTPUT];
+    dope_status_t status[4];
+    uint32_t instructions[4];
+    int i;
+    for (i = 0; i < 4; ++i) {
+        memset(outputs[i], 0, BENCH_DOPE_OUTPUT);
+        FILE* output = fmemopen(outputs[i], BENCH_DOPE_OUTPUT - 1, "w");
+        status[i] = bench_dope_run(run_arena, i < 2 ? program->program : program->fused, output,
+                                   i % 2 ? DOPE_DISPATCH_THREADED : DOPE_DISPATCH_SWITCH, &instructions[i]);
+        fclose(output);
+    }
+    for (i = 1; i < 4; ++i) {
+        BENCH_CHECK(status[0] == status[i] && instructions[0] == instructions[i] && !strcmp(outputs[0], outputs[i]),
+                    "%s: %s%s run differs from plain switch", program->name, i < 2 ? "" : "fused ", i % 2 ? "threaded" : "switch");
+    }
+}
+
+void bench_dope_dispatch(void) {
+    printf("dope dispatch (%s)\n", DOPE_EXEC_HAS_THREADED ? "switch vs threaded" : "switch only");
+
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, MEM_SIZE_64K);
+    mem_arena_t* run_arena = mem_arena_create(MEM_ARENA_POLICY_C, MEM_SIZE_16K);
+    FILE* sink = fopen("/dev/null", "w");
+    int i;
+    for (i = 0; i < BENCH_DOPE_ANSWERS; ++i) {
+        strcat(bench_dope_answers, i % 2 ? "10\n" : "7\n");
+    }
+
+    bench_dope_program_t programs[BENCH_DOPE_MAX_PROGRAMS];
+    uint16_t count = 0;
+    file_map_t* map = file_map_readonly(arena, DOPE_TEST_PROGRAMS);
+    if (map) {
+        count = bench_dope_split(arena, map, programs);
+    } else {
+        printf("  %s not found, synthetic loop only\n", DOPE_TEST_PROGRAMS);
+    }
+    strcpy(programs[count].name, "counting loop");
+    programs[count].source = bench_dope_counting_loop;
+    programs[count].size = (uint32_t)strlen(bench_dope_counting_loop);
+    if (bench_dope_prepare(arena, &programs[count])) {
+        ++count;
+    }
+
+    for (i = 0; i < count; ++i) {
+        const dope_program_t* program = programs[i].program;
+        uint32_t instructions;
+        double switch_time, threaded_time, fused_time;
+        char label[48];
+
+        bench_dope_compare(run_arena, &programs[i]);
+        bench_dope_run(run_arena, program, sink, DOPE_DISPATCH_SWITCH, &instructions);
+        if (!instructions) continue;
+
+        BENCH_MEASURE(switch_time, instructions, bench_dope_run(run_arena, program, sink, DOPE_DISPATCH_SWITCH, &instructions));
+        snprintf(label, sizeof(label), "%.23s, switch", programs[i].name);
+        BENCH_REPORT(label, switch_time);
+#if DOPE_EXEC_HAS_THREADED
+        BENCH_MEASURE(threaded_time, instructions, bench_dope_run(run_arena, program, sink, DOPE_DISPATCH_THREADED, &instructions));
+        snprintf(label, sizeof(label), "%.23s, threaded", programs[i].name);
+        BENCH_REPORT(label, threaded_time);
+        printf("  %-34s %10.2fx (%lu instructions per run)\n", "threaded speedup", switch_time / threaded_time, (unsigned long)instructions);
+#else
+        threaded_time = switch_time;
+#endif
+        BENCH_MEASURE(fused_time, instructions, bench_dope_run(run_arena, programs[i].fused, sink, DOPE_DISPATCH_THREADED, &instructions));
+        snprintf(label, sizeof(label), "%.23s, fused", programs[i].name);
+        BENCH_REPORT(label, fused_time);
+        printf("  %-34s %10.2fx\n", "fused speedup", threaded_time / fused_time);
+    }
+
+    if (map) {
+        file_map_close(map);
+    }
+    fclose(sink);
+    mem_arena_delete(run_arena);
+    mem_arena_delete(arena);
+}
+
+#endif
+
+/** @} */ // end of dope_benches group
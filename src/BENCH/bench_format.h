@@ -0,0 +1,156 @@
+/**
+ * @file bench_format.h
+ * @brief str_number_format against printf
+ * @defgroup format_benches Format Benchmarks
+ * @{
+ */
+#ifndef BENCH_FORMAT_H
+#define BENCH_FORMAT_H
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_macros.h"
+#include "../STRUTIL/str_number.h"
+
+/// @brief Array of all format benchmarks
+#define FORMAT_BENCHES &bench_format_shortest, \
+                       &bench_format_fixed
+
+#define BENCH_FORMAT_COUNT      4096
+#define BENCH_FORMAT_DECIMALS   5
+
+static double bench_format_values[BENCH_FORMAT_COUNT];
+
+/**
+ * @brief Print-like values: loop counters, short decimals, quotients and arbitrary doubles
+ */
+static void bench_format_corpus(void) {
+    srand(1964);
+    int i;
+    for (i = 0; i < BENCH_FORMAT_COUNT; ++i) {
+        uint64_t bits;
+        switch (i % 4) {
+            case 0: bench_format_values[i] = rand() % 1000; break;
+            case 1: bench_format_values[i] = (rand() % 100000) / 100.0; break;
+            case 2: bench_format_values[i] = (double)rand() / (rand() % 977 + 1); break;
+            default:
+                do {
+                    bits = ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+                    memcpy(&bench_format_values[i], &bits, sizeof(double));
+                } while (!isfinite(bench_format_values[i]));
+                break;
+        }
+    }
+}
+
+/**
+ * @brief What str_number_format promises, built from printf alone
+ */
+static void bench_format_reference(double value, char* text) {
+    char probe[STR_NUMBER_FORMAT_SIZE];
+    int precision;
+    if (value == 0) {
+        strcpy(text, signbit(value) ? "-0" : "0");
+        return;
+    }
+    for (precision = 1; precision < STR_NUMBER_MAX_DIGITS; ++precision) {
+        sprintf(probe, "%.*e", precision - 1, value);
+        if (strtod(probe, NULL) == value) {
+            break;
+        }
+    }
+    sprintf(probe, "%.*e", precision - 1, value);
+    int leading = atoi(strchr(probe, 'e') + 1);
+    if (leading < -4 || leading >= 16) {
+        strcpy(text, probe);
+    } else {
+        sprintf(text, "%.*f", precision - 1 - leading > 0 ? precision - 1 - leading : 0, value);
+    }
+}
+
+void bench_format_shortest(void) {
+    printf("number format shortest (%d values)\n", BENCH_FORMAT_COUNT);
+    bench_format_corpus();
+
+    char text[STR_NUMBER_FORMAT_SIZE], reference[STR_NUMBER_FORMAT_SIZE];
+    int i;
+    for (i = 0; i < BENCH_FORMAT_COUNT; ++i) {
+        double value = bench_format_values[i];
+        str_number_format(value, text, sizeof(text));
+        bench_format_reference(value, reference);
+        BENCH_CHECK(strcmp(text, reference) == 0, "%.17g formatted as %s, printf %s", value, text, reference);
+        BENCH_CHECK(strtod(text, NULL) == value, "%.17g does not round-trip through %s", value, text);
+    }
+
+    volatile size_t sink = 0;
+    double per_op;
+    BENCH_MEASURE(per_op, BENCH_FORMAT_COUNT, {
+        for (i = 0; i < BENCH_FORMAT_COUNT; ++i) {
+            sink += (size_t)sprintf(text, "%g", bench_format_values[i]);
+        }
+    });
+    BENCH_REPORT("sprintf %g (6 digits, lossy)", per_op);
+    double reference_per_op = per_op;
+
+    BENCH_MEASURE(per_op, BENCH_FORMAT_COUNT, {
+        for (i = 0; i < BENCH_FORMAT_COUNT; ++i) {
+            bench_format_reference(bench_format_values[i], text);
+            sink += text[0];
+        }
+    });
+    BENCH_REPORT("sprintf shortest round-trip", per_op);
+
+    BENCH_MEASURE(per_op, BENCH_FORMAT_COUNT, {
+        for (i = 0; i < BENCH_FORMAT_COUNT; ++i) {
+            sink += str_number_format(bench_format_values[i], text, sizeof(text));
+        }
+    });
+    BENCH_REPORT("str_number_format", per_op);
+    printf("  speedup over %%g %.1fx\n", reference_per_op / per_op);
+    (void)sink;
+}
+
+void bench_format_fixed(void) {
+    printf("number format fixed, %d decimals (%d values)\n", BENCH_FORMAT_DECIMALS, BENCH_FORMAT_COUNT);
+    bench_format_corpus();
+
+    char text[64], reference[64];
+    int i;
+    for (i = 0; i < BENCH_FORMAT_COUNT; ++i) {
+        double value = bench_format_values[i];
+        if (fabs(value) > 1e30) {
+            continue;                                   // keep the corpus to printable widths
+        }
+        str_number_format_fixed(value, BENCH_FORMAT_DECIMALS, text, sizeof(text));
+        sprintf(reference, "%+.*f", BENCH_FORMAT_DECIMALS, value);
+        BENCH_CHECK(strcmp(text, reference) == 0, "%.17g formatted as %s, printf %s", value, text, reference);
+    }
+
+    volatile size_t sink = 0;
+    double per_op;
+    BENCH_MEASURE(per_op, BENCH_FORMAT_COUNT, {
+        for (i = 0; i < BENCH_FORMAT_COUNT; i += 4) {   // the three print-like quarters of the corpus
+            sink += (size_t)sprintf(text, "%+.*f", BENCH_FORMAT_DECIMALS, bench_format_values[i]);
+            sink += (size_t)sprintf(text, "%+.*f", BENCH_FORMAT_DECIMALS, bench_format_values[i + 1]);
+            sink += (size_t)sprintf(text, "%+.*f", BENCH_FORMAT_DECIMALS, bench_format_values[i + 2]);
+        }
+    });
+    BENCH_REPORT("sprintf %+.5f", per_op * 4 / 3);
+    double reference_per_op = per_op;
+
+    BENCH_MEASURE(per_op, BENCH_FORMAT_COUNT, {
+        for (i = 0; i < BENCH_FORMAT_COUNT; i += 4) {
+            sink += str_number_format_fixed(bench_format_values[i], BENCH_FORMAT_DECIMALS, text, sizeof(text));
+            sink += str_number_format_fixed(bench_format_values[i + 1], BENCH_FORMAT_DECIMALS, text, sizeof(text));
+            sink += str_number_format_fixed(bench_format_values[i + 2], BENCH_FORMAT_DECIMALS, text, sizeof(text));
+        }
+    });
+    BENCH_REPORT("str_number_format_fixed", per_op * 4 / 3);
+    printf("  speedup %.1fx\n", reference_per_op / per_op);
+    (void)sink;
+}
+
+#endif
+
+/** @} */ // end of format_benches group
@@ -0,0 +1,57 @@
+/**
+ * @file bench_macros.h
+ * @brief Minimal host benchmark harness
+ * @defgroup bench_macros Benchmark Macros
+ * @{
+ */
+#ifndef BENCH_MACROS_H
+#define BENCH_MACROS_H
+
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_MIN_SECONDS   0.25    ///< Each measurement repeats until it has run this long
+
+/// @brief One benchmark case, see the *_BENCHES lists
+typedef void (*bench_case_t)(void);
+
+/// @brief Set by a case whose fast path disagrees with its reference, makes bench_main fail
+static int bench_failures = 0;
+
+static double bench_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Times the body (the variadic argument, so it may contain commas), which performs
+ *        OPS operations, until BENCH_MIN_SECONDS have passed
+ * @param SECONDS_PER_OP double lvalue receiving the mean time per operation
+ */
+#define BENCH_MEASURE(SECONDS_PER_OP, OPS, ...)                               \
+    do {                                                                        \
+        unsigned long bench_rounds_ = 0;                                        \
+        double bench_start_ = bench_now(), bench_elapsed_;                      \
+        do {                                                                    \
+            __VA_ARGS__;                                                        \
+            ++bench_rounds_;                                                    \
+        } while ((bench_elapsed_ = bench_now() - bench_start_) < BENCH_MIN_SECONDS); \
+        (SECONDS_PER_OP) = bench_elapsed_ / ((double)bench_rounds_ * (double)(OPS)); \
+    } while (0)
+
+#define BENCH_REPORT(NAME, SECONDS_PER_OP) \
+    printf("  %-34s %10.2f ns/op %10.2f Mop/s\n", NAME, (SECONDS_PER_OP) * 1e9, 1e-6 / (SECONDS_PER_OP))
+
+#define BENCH_CHECK(cond, ...)                                                  \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            ++bench_failures;                                                   \
+            printf("  MISMATCH: " __VA_ARGS__);                                 \
+            printf("\n");                                                       \
+        }                                                                       \
+    } while (0)
+
+#endif
+
+/** @} */ // end of bench_macros group
@@ -0,0 +1,15 @@
+#include "bench_dope.h"
+#include "bench_format.h"
+#include "bench_number.h"
+
+int main(void) {
+    bench_case_t benches[] = { NUMBER_BENCHES, FORMAT_BENCHES, DOPE_BENCHES };
+    size_t i;
+    for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        benches[i]();
+    }
+    if (bench_failures) {
+        printf("%d mismatches\n", bench_failures);
+    }
+    return bench_failures != 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file bench_number.h
+ * @brief str_number_parse against strtod
+ * @defgroup number_benches Number Benchmarks
+ * @{
+ */
+#ifndef BENCH_NUMBER_H
+#define BENCH_NUMBER_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "bench_macros.h"
+#include "../STRUTIL/str_number.h"
+
+/// @brief Array of all number benchmarks
+#define NUMBER_BENCHES &bench_number_parse
+
+#define BENCH_NUMBER_COUNT  4096
+
+static char bench_number_text[BENCH_NUMBER_COUNT][32];
+static size_t bench_number_length[BENCH_NUMBER_COUNT];
+
+/**
+ * @brief Operand-like literals: mostly small integers and short decimals, some exponents
+ */
+static void bench_number_corpus(void) {
+    srand(1962);
+    int i;
+    for (i = 0; i < BENCH_NUMBER_COUNT; ++i) {
+        char* text = bench_number_text[i];
+        switch (i % 8) {
+            case 0: case 1: case 2: sprintf(text, "%d", rand() % 100); break;
+            case 3: sprintf(text, "%d", rand()); break;
+            case 4: case 5: sprintf(text, "%d.%d", rand() % 1000, rand() % 100000); break;
+            case 6: sprintf(text, "-%d.%05d", rand() % 10, rand() % 100000); break;
+            default: sprintf(text, "%d.%de%d", rand() % 10, rand() % 1000, rand() % 40 - 20); break;
+        }
+        bench_number_length[i] = strlen(text);
+    }
+}
+
+void bench_number_parse(void) {
+    printf("number parse (%d operand literals)\n", BENCH_NUMBER_COUNT);
+    bench_number_corpus();
+
+    int i;
+    for (i = 0; i < BENCH_NUMBER_COUNT; ++i) {
+        double fast = 0, reference = strtod(bench_number_text[i], NULL);
+        size_t consumed = str_number_parse(bench_number_text[i], bench_number_length[i], &fast);
+        BENCH_CHECK(consumed == bench_number_length[i] && memcmp(&fast, &reference, sizeof(double)) == 0,
+                    "%s parsed as %.17g, strtod %.17g", bench_number_text[i], fast, reference);
+    }
+
+    volatile double sink = 0;
+    double per_op;
+    BENCH_MEASURE(per_op, BENCH_NUMBER_COUNT, {
+        double sum = 0;
+        for (i = 0; i < BENCH_NUMBER_COUNT; ++i) {
+            sum += strtod(bench_number_text[i], NULL);
+        }
+        sink += sum;
+    });
+    BENCH_REPORT("strtod", per_op);
+    double reference_per_op = per_op;
+
+    BENCH_MEASURE(per_op, BENCH_NUMBER_COUNT, {
+        double sum = 0, value;
+        for (i = 0; i < BENCH_NUMBER_COUNT; ++i) {
+            str_number_parse(bench_number_text[i], bench_number_length[i], &value);
+            sum += value;
+        }
+        sink += sum;
+    });
+    BENCH_REPORT("str_number_parse", per_op);
+    printf("  speedup %.1fx\n", reference_per_op / per_op);
+    (void)sink;
+}
+
+#endif
+
+/** @} */ // end of number_benches group
@@ -0,0 +1,585 @@
+#include "dope_batch.h"
+#include "dope_cache.h"
+#include "dope_constants.h"
+#include "../CONTRACT/contract.h"
+#include "../DOS/dos_error_messages.h"
+#include "../DOS/dos_last_error.h"
+#include "../DOS/dos_services_files.h"
+#include "../DOS/dos_services_files_constants.h"
+#include "../FILEUTIL/file_line_stream.h"
+#include "../FILEUTIL/file_utils.h"
+#include "../MEM/mem_constants.h"
+#include "../STRUTIL/str_scan.h"
+#include "../STRUTIL/str_view.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef __DOS__
+#include <dirent.h>
+#include <errno.h>
+#include <fnmatch.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../DOS/dos_services_host.h"
+#define DOPE_BATCH_PATH_SEPARATOR   '/'
+#else
+#define DOPE_BATCH_PATH_SEPARATOR   '\\'
+#endif
+#define DOPE_BATCH_MAX_FIELDS       3       // program, answers, output
+#define DOPE_BATCH_SCAN_BUFFER      512     // answers line count read size
+#define DOPE_BATCH_CACHE_LOCKS      16      // .DPC writers are serialized per path hash
+
+typedef struct {
+    struct private_dope_batch_t* batch;
+    mem_arena_t* arena;
+#ifndef __DOS__
+    pthread_t thread;
+#endif
+} dope_batch_worker_t;
+
+typedef struct private_dope_batch_t {
+    mem_arena_t* arena;
+    dope_batch_worker_t workers[DOPE_BATCH_MAX_WORKERS];
+    uint8_t worker_count;
+    const dope_batch_job_t* jobs;   ///< Current run
+    dope_batch_result_t* results;
+    uint16_t count;
+    uint16_t next;                  ///< Next unclaimed job
+    dope_budget_t budget;           ///< Of every run
+#ifndef __DOS__
+    pthread_mutex_t lock;
+    pthread_mutex_t cache_locks[DOPE_BATCH_CACHE_LOCKS];
+#endif
+} dope_batch_t;
+
+/**
+ * @brief Whether replaying an answers file keeps the run within limit bytes
+ * @details A replay indexes every line with a 4 byte offset, plus a sentinel, and
+ *          under DOS also holds the file's bytes in the arena, so the lines are
+ *          counted first: a file of blank lines costs four times its size in offsets.
+ *          MEM_SIZE_1K covers the map, the source and the machine.
+ */
+static bool dope_batch_fits(mem_arena_t* arena, const char* path_name, mem_size_t limit) {
+    dos_file_handle_t fhandle = dos_open_file(path_name, ACCESS_READ_ONLY | DENY_WRITE);
+    if (!fhandle) {
+        return true;                                // file_source_replay() reports the error
+    }
+    char buffer[DOPE_BATCH_SCAN_BUFFER];
+    uint32_t size = 0, lines = 1;                   // a last line without '\n' counts too
+    uint16_t bytes_read;
+    while ((bytes_read = dos_read_file(fhandle, buffer, sizeof(buffer))) != 0) {
+        size += bytes_read;
+        lines += str_scan_positions(buffer, bytes_read, '\n', NULL, 0);
+    }
+    dos_close_file(fhandle);
+    uint32_t needed = (lines + 1) * sizeof(uint32_t) + sizeof(uint32_t) + MEM_SIZE_1K;
+#ifdef __DOS__
+    needed += size;
+#endif
+    mem_size_t used = mem_arena_used(arena);
+    return used < limit && needed <= limit - used;
+}
+
+/**
+ * @brief Gets a job's program through its .DPC cache, compiling and saving it if stale
+ * @details Jobs of one program always take the same lock, so two workers never
+ *          write the same cache at once; other programs load in parallel.
+ */
+static dope_program_t* dope_batch_program(dope_batch_worker_t* worker, const char* path_name, dope_diagnostic_t* diagnostic) {
+#ifndef __DOS__
+    uint8_t stripe = 0;
+    const char* c;
+    for (c = path_name; *c; ++c) {
+        stripe = (uint8_t)(stripe * 31 + (uint8_t)*c);
+    }
+    pthread_mutex_t* lock = &worker->batch->cache_locks[stripe % DOPE_BATCH_CACHE_LOCKS];
+    pthread_mutex_lock(lock);
+#endif
+    dope_program_t* program = dope_cache_open(worker->arena, path_name, diagnostic);
+#ifndef __DOS__
+    pthread_mutex_unlock(lock);
+#endif
+    return program;
+}
+
+/**
+ * @brief Compiles and runs one job into its result slot
+ */
+static void dope_batch_job(dope_batch_worker_t* worker, dope_batch_result_t* result) {
+    const dope_batch_job_t* job = result->job;
+    mem_arena_t* arena = worker->arena;
+    mem_size_t used = mem_arena_used(arena);
+    if (used) {
+        mem_arena_dealloc(arena, used);
+    }
+    dos_last_error_clear();
+
+    dope_diagnostic_t diagnostic;
+    dope_program_t* program = dope_batch_program(worker, job->program, &diagnostic);
+    if (!program && diagnostic.error == DOPE_COMPILE_NO_MEMORY) {
+        result->status = DOPE_STATUS_MEMORY_LIMIT;          // e.g. one huge line: this job's problem only
+        result->source_line = diagnostic.source_line;
+        return;
+    }
+    if (!program) {
+        result->error = diagnostic.error;
+        result->source_line = diagnostic.source_line;
+        if (diagnostic.error == DOPE_COMPILE_UNREADABLE) {  // only then is the DOS error the cause
+            result->err_code = dos_last_error_code();
+        }
+        return;
+    }
+
+    const dope_budget_t* budget = &worker->batch->budget;
+    mem_size_t limit = mem_arena_capacity(arena);
+    if (budget->arena_bytes && budget->arena_bytes < limit) {
+        limit = budget->arena_bytes;
+    }
+    file_source_t* input = NULL;
+    if (job->answers) {
+        if (!dope_batch_fits(arena, job->answers, limit)) {
+            result->status = DOPE_STATUS_MEMORY_LIMIT;      // would not even load
+            return;
+        }
+        input = file_source_replay(arena, job->answers);
+        if (!input && dos_last_error_code() == DOS_INSUFFICIENT_MEMORY) {
+            result->status = DOPE_STATUS_MEMORY_LIMIT;
+            return;
+        }
+        if (!input) {
+            result->err_code = dos_last_error_code();
+            return;
+        }
+    }
+    FILE* output = fopen(job->output, "w");
+    if (!output) {
+        result->err_code = DOS_ACCESS_DENIED;
+    } else {
+        dope_machine_t* machine = dope_exec_create(arena, program, input, output);
+        if (!machine) {
+            result->status = DOPE_STATUS_MEMORY_LIMIT;
+        } else {
+            dope_exec_set_budget(machine, budget);
+            result->status = dope_exec_run(machine);
+            result->line = dope_exec_line(machine);
+            result->instructions = dope_exec_instructions(machine);
+        }
+        fclose(output);
+    }
+    if (input) {
+        file_source_close(input);
+    }
+}
+
+/**
+ * @brief Claims the next job of the run, false when none are left
+ */
+static bool dope_batch_claim(dope_batch_t* batch, uint16_t* index) {
+#ifndef __DOS__
+    pthread_mutex_lock(&batch->lock);
+#endif
+    bool claimed = batch->next < batch->count;
+    if (claimed) {
+        *index = batch->next++;
+    }
+#ifndef __DOS__
+    pthread_mutex_unlock(&batch->lock);
+#endif
+    return claimed;
+}
+
+static void* dope_batch_worker(void* context) {
+    dope_batch_worker_t* worker = (dope_batch_worker_t*)context;
+    uint16_t index;
+    while (dope_batch_claim(worker->batch, &index)) {
+        dope_batch_job(worker, &worker->batch->results[index]);
+    }
+    return NULL;
+}
+
+dope_batch_t* dope_batch_create(mem_arena_t* arena, uint8_t workers, mem_size_t run_arena_size) {
+    require_address(arena, "NULL memory arena!");
+    require(run_arena_size > 0, "ZERO run arena size!");
+
+#ifndef __DOS__
+    if (!workers) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = (uint8_t)(cpus > DOPE_BATCH_MAX_WORKERS ? DOPE_BATCH_MAX_WORKERS : cpus > 0 ? cpus : 1);
+    }
+#else
+    workers = 1;                                    // no threads under DOS
+#endif
+    require_range(workers <= DOPE_BATCH_MAX_WORKERS, "Too many batch workers!");
+
+    dope_batch_t* batch = (dope_batch_t*)mem_arena_alloc_aligned(arena, sizeof(dope_batch_t), sizeof(void*) * 2);
+    require_mem(batch, "NULL batch pool - arena alloc fail!");
+    memset(batch, 0, sizeof(dope_batch_t));
+    batch->arena = arena;
+    batch->worker_count = workers;
+    uint8_t i;
+    for (i = 0; i < workers; ++i) {
+        batch->workers[i].batch = batch;
+        batch->workers[i].arena = mem_arena_create(MEM_ARENA_POLICY_C, run_arena_size);
+        require_mem(batch->workers[i].arena, "NULL worker arena - create fail!");
+    }
+#ifndef __DOS__
+    pthread_mutex_init(&batch->lock, NULL);
+    for (i = 0; i < DOPE_BATCH_CACHE_LOCKS; ++i) {
+        pthread_mutex_init(&batch->cache_locks[i], NULL);
+    }
+#endif
+    return batch;
+}
+
+dope_batch_result_t* dope_batch_run(dope_batch_t* batch, const dope_batch_job_t* jobs, uint16_t count) {
+    require_address(batch, "NULL batch pool!");
+    require_address(jobs, "NULL jobs!");
+
+    dope_batch_result_t* results = (dope_batch_result_t*)mem_arena_calloc(batch->arena, (mem_size_t)count * sizeof(dope_batch_result_t) + 1);
+    require_mem(results, "NULL batch results - arena alloc fail!");
+    uint16_t i;
+    for (i = 0; i < count; ++i) {
+        require_address(jobs[i].program, "NULL program path!");
+        require_address(jobs[i].output, "NULL output path!");
+        results[i].job = &jobs[i];
+    }
+    batch->jobs = jobs;
+    batch->results = results;
+    batch->count = count;
+    batch->next = 0;
+
+#ifndef __DOS__
+    uint8_t started = batch->worker_count < count ? batch->worker_count : (uint8_t)count;
+    uint8_t w;
+    for (w = 0; w < started; ++w) {
+        require_not_busy(pthread_create(&batch->workers[w].thread, NULL, dope_batch_worker, &batch->workers[w]) == 0,
+                         "Batch worker create fail!");
+    }
+    for (w = 0; w < started; ++w) {
+        pthread_join(batch->workers[w].thread, NULL);
+    }
+#else
+    dope_batch_worker(&batch->workers[0]);
+#endif
+    return results;
+}
+
+void dope_batch_set_budget(dope_batch_t* batch, const dope_budget_t* budget) {
+    require_address(batch, "NULL batch pool!");
+    if (budget) {
+        batch->budget = *budget;
+    } else {
+        memset(&batch->budget, 0, sizeof(dope_budget_t));
+    }
+}
+
+uint8_t dope_batch_workers(const dope_batch_t* batch) {
+    require_address(batch, "NULL batch pool!");
+    return batch->worker_count;
+}
+
+void dope_batch_delete(dope_batch_t* batch) {
+    require_address(batch, "NULL batch pool!");
+
+    uint8_t i;
+    for (i = 0; i < batch->worker_count; ++i) {
+        mem_arena_delete(batch->workers[i].arena);
+        batch->workers[i].arena = NULL;
+    }
+#ifndef __DOS__
+    pthread_mutex_destroy(&batch->lock);
+    for (i = 0; i < DOPE_BATCH_CACHE_LOCKS; ++i) {
+        pthread_mutex_destroy(&batch->cache_locks[i]);
+    }
+#endif
+    batch->worker_count = 0;
+}
+
+/**
+ * @brief Copies base[0, base_length) and path into the arena, base only for a relative path
+ */
+static const char* dope_batch_path(mem_arena_t* arena, const char* base, size_t base_length, str_view_t path) {
+    bool absolute = path.length && (path.ptr[0] == '/' || path.ptr[0] == '\\' || (path.length > 1 && path.ptr[1] == ':'));
+    if (absolute) {
+        base_length = 0;
+    }
+    char* joined = (char*)mem_arena_alloc(arena, (mem_size_t)(base_length + path.length + 1));
+    require_mem(joined, "NULL batch path - arena alloc fail!");
+    memcpy(joined, base, base_length);
+    memcpy(joined + base_length, path.ptr, path.length);
+    joined[base_length + path.length] = '\0';
+    return joined;
+}
+
+/**
+ * @brief Copies path with its extension replaced into the arena
+ * @note prog.dop gets prog.ans, in the case of its own extension, for hosts with case sensitive names
+ */
+static const char* dope_batch_sidecar(mem_arena_t* arena, const char* path_name, const char* extension) {
+    size_t capacity = strlen(path_name) + strlen(extension) + 2;
+    char* sidecar = (char*)mem_arena_alloc(arena, (mem_size_t)capacity);
+    require_mem(sidecar, "NULL batch path - arena alloc fail!");
+    bool lower = islower((unsigned char)*file_get_extension(path_name));
+    file_replace_extension(path_name, extension, sidecar, capacity);
+    if (lower) {
+        char* c;
+        for (c = sidecar + strlen(sidecar) - strlen(extension); *c; ++c) {
+            *c = (char)tolower((unsigned char)*c);
+        }
+    }
+    return sidecar;
+}
+
+/**
+ * @brief Length of the directory part of a path, separator included
+ */
+static size_t dope_batch_directory_length(const char* path_name) {
+    size_t length = 0;
+    size_t i;
+    for (i = 0; path_name[i]; ++i) {
+        if (path_name[i] == '/' || path_name[i] == '\\' || path_name[i] == ':') {
+            length = i + 1;
+        }
+    }
+    return length;
+}
+
+/**
+ * @brief Walk over the programs of a directory
+ * @details DOS searches through INT 21h 4Eh/4Fh. Hosts read the directory themselves:
+ *          the DTA record only holds 8.3 names and dos_find_next() skips longer
+ *          ones, which would silently drop alice_smith.dop from a batch.
+ */
+typedef struct {
+#ifndef __DOS__
+    DIR* dir;
+#else
+    dos_file_find_t entry;
+    dos_error_code_t err_code;
+    char name[DOS_FILE_NAME_SIZE];  ///< Current name, the entry already holds the next
+#endif
+} dope_batch_scan_t;
+
+/**
+ * @brief Starts a walk over the files matching spec
+ * @param spec DIR\*.DOP
+ * @param base_length Length of the DIR\ part
+ * @return false if the directory cannot be searched (see dos_last_error())
+ */
+static bool dope_batch_scan_open(dope_batch_scan_t* scan, const char* spec, size_t base_length) {
+#ifndef __DOS__
+    char directory[PATH_MAX];
+    if (base_length >= sizeof(directory)) {
+        dos_last_error_set(DOS_PATH_NOT_FOUND, __func__, spec, 0);
+        return false;
+    }
+    memcpy(directory, spec, base_length);
+    directory[base_length] = '\0';
+    scan->dir = opendir(base_length ? directory : ".");
+    if (!scan->dir) {
+        dos_last_error_set(dos_host_error_code(errno), __func__, spec, 0);
+        return false;
+    }
+    return true;
+#else
+    (void)base_length;
+    scan->err_code = dos_find_first(spec, 0, &scan->entry);
+    if (scan->err_code == DOS_FILE_NOT_FOUND || scan->err_code == DOS_NO_MORE_FILES) {
+        dos_last_error_clear();                     // an empty directory is not an error, a missing one is
+        return true;
+    }
+    return !scan->err_code;
+#endif
+}
+
+/**
+ * @brief Gets the name of the next matching file, NULL at the end
+ * @note The name is valid until the next call
+ */
+static const char* dope_batch_scan_next(dope_batch_scan_t* scan) {
+#ifndef __DOS__
+    struct dirent* dirent;
+    struct stat st;
+    while ((dirent = readdir(scan->dir)) != NULL) {
+        if (dirent->d_name[0] != '.'
+            && fnmatch(DOPE_BATCH_PROGRAMS, dirent->d_name, FNM_CASEFOLD) == 0
+            && fstatat(dirfd(scan->dir), dirent->d_name, &st, 0) == 0 && S_ISREG(st.st_mode)) {
+            return dirent->d_name;
+        }
+    }
+    return NULL;
+#else
+    if (scan->err_code) {
+        return NULL;
+    }
+    strcpy(scan->name, scan->entry.name);
+    scan->err_code = dos_find_next(&scan->entry);
+    return scan->name;
+#endif
+}
+
+static void dope_batch_scan_close(dope_batch_scan_t* scan) {
+#ifndef __DOS__
+    closedir(scan->dir);
+#else
+    while (!scan->err_code) {                       // finish the search so nothing stays open
+        scan->err_code = dos_find_next(&scan->entry);
+    }
+#endif
+}
+
+uint16_t dope_batch_directory(mem_arena_t* arena, const char* directory, dope_batch_job_t** jobs) {
+    require_address(arena, "NULL memory arena!");
+    require_address(directory, "NULL directory!");
+    require_address(jobs, "NULL jobs!");
+
+    // DIR\ + *.DOP: the directory part doubles as the base of every program path
+    size_t base_length = strlen(directory);
+    char* spec = (char*)mem_arena_alloc(arena, (mem_size_t)(base_length + sizeof(DOPE_BATCH_PROGRAMS) + 1));
+    require_mem(spec, "NULL batch path - arena alloc fail!");
+    memcpy(spec, directory, base_length);
+    if (base_length && dope_batch_directory_length(directory) != base_length) {
+        spec[base_length++] = DOPE_BATCH_PATH_SEPARATOR;
+    }
+    strcpy(spec + base_length, DOPE_BATCH_PROGRAMS);
+
+    dope_batch_scan_t scan;
+    const char* name;
+    uint16_t count = 0;
+    *jobs = NULL;
+    if (!dope_batch_scan_open(&scan, spec, base_length)) {
+        return 0;
+    }
+    while (dope_batch_scan_next(&scan)) {
+        ++count;
+    }
+    dope_batch_scan_close(&scan);
+    if (!count) {
+        return 0;
+    }
+
+    *jobs = (dope_batch_job_t*)mem_arena_calloc(arena, (mem_size_t)count * sizeof(dope_batch_job_t));
+    require_mem(*jobs, "NULL batch jobs - arena alloc fail!");
+    uint16_t i = 0;
+    if (!dope_batch_scan_open(&scan, spec, base_length)) {
+        return 0;
+    }
+    while (i < count && (name = dope_batch_scan_next(&scan)) != NULL) {
+        dope_batch_job_t* job = &(*jobs)[i++];
+        job->program = dope_batch_path(arena, spec, base_length, str_view_from_cstr(name));
+        job->output = dope_batch_sidecar(arena, job->program, DOPE_BATCH_OUTPUT);
+        const char* answers = dope_batch_sidecar(arena, job->program, DOPE_BATCH_ANSWERS);
+        dos_file_handle_t fhandle = dos_open_file(answers, ACCESS_READ_ONLY | DENY_WRITE);
+        if (fhandle) {
+            dos_close_file(fhandle);
+            job->answers = answers;
+        }
+    }
+    dope_batch_scan_close(&scan);
+    dos_last_error_clear();                         // a missing PROG.ANS is not an error
+    return i;
+}
+
+uint16_t dope_batch_manifest(mem_arena_t* arena, const char* path_name, dope_batch_job_t** jobs) {
+    require_address(arena, "NULL memory arena!");
+    require_address(path_name, "NULL path name!");
+    require_address(jobs, "NULL jobs!");
+
+    size_t base_length = dope_batch_directory_length(path_name);
+    file_line_view_t line;
+    str_view_t fields[DOPE_BATCH_MAX_FIELDS];
+    uint16_t count = 0;
+    uint16_t pass;
+    *jobs = NULL;
+    for (pass = 0; pass < 2; ++pass) {              // count, then fill
+        file_line_stream_t* lines = file_line_stream_open(arena, path_name, DOPE_SOURCE_BUFFER);
+        if (!lines) {
+            return 0;
+        }
+        uint16_t i = 0;
+        while (file_line_stream_next(lines, &line)) {
+            size_t field_count = str_view_tokenize(str_view_before(line, DOPE_COMMENT), DOPE_BATCH_SEPARATOR, fields, DOPE_BATCH_MAX_FIELDS);
+            if (!field_count || !fields[0].length) {
+                continue;
+            }
+            if (pass) {
+                dope_batch_job_t* job = &(*jobs)[i];
+                job->program = dope_batch_path(arena, path_name, base_length, fields[0]);
+                if (field_count > 1 && fields[1].length) {
+                    job->answers = dope_batch_path(arena, path_name, base_length, fields[1]);
+                }
+                if (field_count > 2 && fields[2].length) {
+                    job->output = dope_batch_path(arena, path_name, base_length, fields[2]);
+                } else {
+                    job->output = dope_batch_sidecar(arena, job->answers ? job->answers : job->program, DOPE_BATCH_OUTPUT);
+                }
+            }
+            if (++i == count && pass) {
+                break;
+            }
+        }
+        file_line_stream_close(lines);
+        count = i;
+        if (!pass) {
+            if (!count) {
+                return 0;
+            }
+            *jobs = (dope_batch_job_t*)mem_arena_calloc(arena, (mem_size_t)count * sizeof(dope_batch_job_t));
+            require_mem(*jobs, "NULL batch jobs - arena alloc fail!");
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Writes a field, quoted if it holds the separator
+ */
+static void dope_batch_field(FILE* summary, const char* text) {
+    if (text && strchr(text, DOPE_BATCH_SEPARATOR)) {
+        fprintf(summary, "\"%s\"%c", text, DOPE_BATCH_SEPARATOR);
+    } else {
+        fprintf(summary, "%s%c", text ? text : "", DOPE_BATCH_SEPARATOR);
+    }
+}
+
+bool dope_batch_summary(const dope_batch_result_t* results, uint16_t count, const char* path_name) {
+    require_address(results, "NULL batch results!");
+    require_address(path_name, "NULL path name!");
+
+    FILE* summary = fopen(path_name, "w");
+    if (!summary) {
+        return false;
+    }
+    fprintf(summary, "program%canswers%coutput%cresult%cline%cinstructions\n",
+            DOPE_BATCH_SEPARATOR, DOPE_BATCH_SEPARATOR, DOPE_BATCH_SEPARATOR, DOPE_BATCH_SEPARATOR, DOPE_BATCH_SEPARATOR);
+    uint16_t i;
+    for (i = 0; i < count; ++i) {
+        const dope_batch_result_t* result = &results[i];
+        dope_batch_field(summary, result->job->program);
+        dope_batch_field(summary, result->job->answers);
+        dope_batch_field(summary, result->job->output);
+        unsigned long line = result->line;
+        if (result->err_code) {                     // "02  File not found " -> "File not found"
+            str_view_t message = str_view_trim(str_view_from_cstr(
+                result->err_code < sizeof(dos_error_messages) / sizeof(dos_error_messages[0]) ? dos_error_messages[result->err_code] : "Unknown error"));
+            while (message.length && message.ptr[0] >= '0' && message.ptr[0] <= '9') {
+                message = str_view_make(message.ptr + 1, message.length - 1);
+            }
+            message = str_view_trim(message);
+            fprintf(summary, "%.*s", (int)message.length, message.ptr);
+            line = 0;
+        } else if (result->error) {
+            fprintf(summary, "%s", dope_compile_message(result->error));
+            line = result->source_line;
+        } else {
+            fprintf(summary, "%s", dope_exec_status_message(result->status));
+        }
+        fprintf(summary, "%c%lu%c%lu\n", DOPE_BATCH_SEPARATOR, line, DOPE_BATCH_SEPARATOR, (unsigned long)result->instructions);
+    }
+    bool written = !ferror(summary);
+    return fclose(summary) == 0 && written;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file dope_batch.h
+ * @brief Batch runner: many DOPE programs, each in its own machine and arena, on a worker pool
+ * @defgroup dope_batch DOPE Batch Runner
+ * @{
+ */
+#ifndef DOPE_BATCH_H
+#define DOPE_BATCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dope_compile.h"
+#include "dope_exec.h"
+#include "../DOS/dos_services_types.h"
+#include "../MEM/mem_arena.h"
+
+#define DOPE_BATCH_MAX_WORKERS      16
+#define DOPE_BATCH_PROGRAMS         "*.DOP"     ///< What a directory batch runs
+#define DOPE_BATCH_ANSWERS          "ANS"       ///< PROG.ANS feeds PROG.DOP in a directory batch
+#define DOPE_BATCH_OUTPUT           "OUT"       ///< Output goes to ANSWERS.OUT, or PROG.OUT without answers
+#define DOPE_BATCH_SEPARATOR        ','         ///< Manifest and summary fields
+
+/**
+ * @brief One run: a program, what it reads and where its output goes
+ */
+typedef struct {
+    const char* program;
+    const char* answers;        ///< NULL = no input, the first J or A ends the run
+    const char* output;
+} dope_batch_job_t;
+
+/**
+ * @brief How one run went
+ */
+typedef struct {
+    const dope_batch_job_t* job;
+    dos_error_code_t err_code;      ///< DOS_SUCCESS, or why a file could not be read or written
+    dope_compile_error_t error;     ///< DOPE_COMPILE_OK, or why the program never ran
+    uint32_t source_line;           ///< of the compile error
+    dope_status_t status;           ///< why the run stopped (compiled programs only)
+    uint8_t line;                   ///< DOPE line the run stopped on, 0 = ran past the end
+    uint32_t instructions;
+} dope_batch_result_t;
+
+/**
+ * @brief Opaque batch pool
+ *
+ * @details Each worker owns one C-policy arena. A job loads its program from the
+ * .DPC cache (see dope_cache_open()), or compiles, optimizes and caches it, and runs
+ * it out of that arena, which is emptied before the next job, so a run
+ * sees nothing of the ones before it and workers never contend on allocation.
+ * Workers claim the next job from a shared counter and write its result to that
+ * job's slot: a worker stuck on a long program simply claims nothing more while the
+ * others drain the queue, and results come back in job order whatever finishes first.
+ * DOS builds run the same code on the calling thread with one worker.
+ * A job that fills its arena - a huge source line, answers file or input line -
+ * stops with DOPE_STATUS_MEMORY_LIMIT; it never takes the batch down with it.
+ */
+typedef struct private_dope_batch_t dope_batch_t;
+
+/**
+ * @brief Creates the pool and its worker arenas
+ * @param arena Arena for the pool and run results
+ * @param workers Worker count, 0 = one per online CPU (capped at DOPE_BATCH_MAX_WORKERS)
+ * @param run_arena_size Bytes one run may use for its program, machine and I/O buffers
+ * @return Pool handle
+ */
+dope_batch_t* dope_batch_create(mem_arena_t* arena, uint8_t workers, mem_size_t run_arena_size);
+
+/**
+ * @brief Runs a batch of jobs concurrently
+ * @param batch Pool handle
+ * @param jobs Jobs to run
+ * @param count Number of jobs
+ * @return count results in job order, allocated from the pool's arena
+ */
+dope_batch_result_t* dope_batch_run(dope_batch_t* batch, const dope_batch_job_t* jobs, uint16_t count);
+
+/**
+ * @brief Limits every run of the following batches
+ * @param batch Pool handle
+ * @param budget Limits, copied; NULL removes them
+ *
+ * @details A runaway program costs its worker at most the budget, then the run
+ * stops with a limit status and the worker moves on. arena_bytes above the run
+ * arena size has no effect: the run arena is the limit then. An answers file too
+ * big to load within the limit stops the run before it starts.
+ */
+void dope_batch_set_budget(dope_batch_t* batch, const dope_budget_t* budget);
+
+/**
+ * @brief Gets the number of workers
+ */
+uint8_t dope_batch_workers(const dope_batch_t* batch);
+
+/**
+ * @brief Deletes the worker arenas
+ * @param batch Pool handle
+ */
+void dope_batch_delete(dope_batch_t* batch);
+
+/**
+ * @brief Makes one job per program in a directory
+ * @param arena Arena for the jobs and their paths
+ * @param directory Directory holding PROG.DOP files
+ * @param jobs Receives the jobs
+ * @return Number of jobs, 0 if there are none or the directory cannot be searched (see dos_last_error())
+ *
+ * @details PROG.DOP reads PROG.ANS when there is one and writes PROG.OUT.
+ */
+uint16_t dope_batch_directory(mem_arena_t* arena, const char* directory, dope_batch_job_t** jobs);
+
+/**
+ * @brief Makes one job per line of a manifest
+ * @param arena Arena for the jobs and their paths
+ * @param path_name Manifest file
+ * @param jobs Receives the jobs
+ * @return Number of jobs, 0 if there are none or the manifest cannot be read (see dos_last_error())
+ *
+ * @details Relative paths are relative to the manifest. Blank lines and anything after
+ * a '#' are ignored; answers and output may be left out:
+ * @code
+ * | Manifest line                    | Runs                                        |
+ * |----------------------------------|---------------------------------------------|
+ * | SORT.DOP                         | SORT.DOP, no input, output to SORT.OUT      |
+ * | SORT.DOP,ALICE.ANS               | ALICE.ANS as input, output to ALICE.OUT     |
+ * | SORT.DOP,BOB.ANS,RESULTS\BOB.TXT | BOB.ANS as input, output to RESULTS\BOB.TXT |
+ * @endcode
+ */
+uint16_t dope_batch_manifest(mem_arena_t* arena, const char* path_name, dope_batch_job_t** jobs);
+
+/**
+ * @brief Writes one CSV row per run
+ * @param results Results of dope_batch_run()
+ * @param count Number of results
+ * @param path_name Summary file, replaced if it exists
+ * @return false if the summary cannot be written
+ *
+ * @details Columns are program, answers, output, result, line and instructions.
+ * The result is the run status, the compile error, or the file error, in words;
+ * line is where the run stopped, or the source line of a compile error.
+ */
+bool dope_batch_summary(const dope_batch_result_t* results, uint16_t count, const char* path_name);
+
+#endif
+
+/** @} */ // end of dope_batch group
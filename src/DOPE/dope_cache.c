@@ -0,0 +1,311 @@
+#include "dope_cache.h"
+#include "dope_optimize.h"
+#include "../CONTRACT/contract.h"
+#include "../DOS/dos_error_messages.h"
+#include "../DOS/dos_last_error.h"
+#include "../DOS/dos_services_files.h"
+#include "../FILEUTIL/file_utils.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#define DOPE_CACHE_HASH_BUFFER  512
+#define DOPE_CACHE_FNV_OFFSET   2166136261UL
+#define DOPE_CACHE_FNV_PRIME    16777619UL
+
+/**
+ * @brief Continues an FNV-1a hash over some bytes
+ */
+static uint32_t dope_cache_fnv(uint32_t hash, const void* bytes, uint16_t nbytes) {
+    const uint8_t* byte = (const uint8_t*)bytes;
+    uint16_t i;
+    for (i = 0; i < nbytes; ++i) {
+        hash = (hash ^ byte[i]) * DOPE_CACHE_FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief FNV-1a over the rest of an open file
+ */
+static uint32_t dope_cache_hash(dos_file_handle_t fhandle) {
+    char buffer[DOPE_CACHE_HASH_BUFFER];
+    uint32_t hash = DOPE_CACHE_FNV_OFFSET;
+    uint16_t bytes_read;
+    while ((bytes_read = dos_read_file(fhandle, buffer, sizeof(buffer))) != 0) {
+        hash = dope_cache_fnv(hash, buffer, bytes_read);
+    }
+    return hash;
+}
+
+/**
+ * @brief Body layout, doubles first so they stay aligned
+ */
+static uint16_t dope_cache_layout(const dope_cache_header_t* header, uint16_t* code, uint16_t* loops, uint16_t* lines, uint16_t* text) {
+    *code = header->constant_count * sizeof(double);
+    *loops = *code + header->count * sizeof(dope_instruction_t);
+    *lines = *loops + header->loop_count * sizeof(dope_loop_t);
+    *text = *lines + DOPE_LINE_TABLE_SIZE;
+    return *text + header->text_size;
+}
+
+/**
+ * @brief FNV-1a over the header, its own hash field zeroed, and then the body
+ */
+static uint32_t dope_cache_hash_program(const dope_cache_header_t* header, const dope_program_t* program) {
+    dope_cache_header_t hashed = *header;
+    uint16_t code, loops, lines, text;
+    dope_cache_layout(header, &code, &loops, &lines, &text);
+    hashed.body_hash = 0;
+    uint32_t hash = dope_cache_fnv(DOPE_CACHE_FNV_OFFSET, &hashed, sizeof(hashed));
+    hash = dope_cache_fnv(hash, program->constants, code);
+    hash = dope_cache_fnv(hash, program->code, (uint16_t)(loops - code));
+    hash = dope_cache_fnv(hash, program->loops, (uint16_t)(lines - loops));
+    hash = dope_cache_fnv(hash, program->lines, DOPE_LINE_TABLE_SIZE);
+    return dope_cache_fnv(hash, program->text, program->text_size);
+}
+
+/**
+ * @brief Size and hash of the source
+ * @return false if the source cannot be opened
+ */
+static bool dope_cache_identify(const char* path_name, dope_cache_header_t* header) {
+    dos_file_handle_t fhandle = dos_open_file(path_name, ACCESS_READ_ONLY | DENY_WRITE);
+    if (!fhandle) {
+        return false;
+    }
+    header->source_size = (dos_file_size_t)dos_move_file_pointer(fhandle, 0, FSEEK_END);
+    dos_move_file_pointer(fhandle, 0, FSEEK_SET);
+    header->source_hash = dope_cache_hash(fhandle);
+    dos_close_file(fhandle);
+    return true;
+}
+
+/// Operand kinds each opcode reads: r register, j jump target, t text, l loop frame
+static const char dope_cache_signatures[DOPE_OP_COUNT][DOPE_MAX_OPERANDS + 1] = {
+    "rrr", "rrr", "rrr", "rrr",
+    "rr", "rr", "rr", "rr",
+    "r", "", "r", "tr",
+    "j", "rrjj", "rrrl", "l",
+    "rr", "rrr", "rrr", "rrr",
+    "rrr", "r"
+};
+
+/**
+ * @brief Checks that an operand is what its opcode reads and points inside the program
+ */
+static bool dope_cache_operand_valid(const dope_program_t* program, char signature, const dope_operand_t* operand) {
+    switch (signature) {
+        case 'r': return operand->kind == DOPE_OPERAND_REGISTER && operand->value < program->register_count;
+        case 'j': return operand->kind == DOPE_OPERAND_TARGET && operand->value <= program->count;
+        case 't': return operand->kind == DOPE_OPERAND_TEXT && (uint32_t)operand->value + operand->letter <= program->text_size;
+        case 'l': return operand->kind == DOPE_OPERAND_LOOP && operand->value < program->loop_count;
+    }
+    return false;
+}
+
+/**
+ * @brief Checks that the lines a superinstruction runs on are still there
+ * @details A follower may itself have been fused since (P into PN), so it is
+ *          matched by the operands it holds, not by its opcode.
+ */
+static bool dope_cache_followers_valid(const dope_program_t* program, uint16_t i) {
+    const dope_instruction_t* code = program->code;
+    uint8_t next = i + 1 < program->count ? code[i + 1].opcode : DOPE_OP_COUNT;
+    uint8_t after = i + 2 < program->count ? code[i + 2].opcode : DOPE_OP_COUNT;
+    bool prints = next == DOPE_OP_PRINT || next == DOPE_OP_PRINT_NEWLINE;
+
+    switch (code[i].opcode) {
+        case DOPE_OP_ADD_COMPARE: return next == DOPE_OP_COMPARE;
+        case DOPE_OP_ADD_JUMP: return next == DOPE_OP_JUMP;
+        case DOPE_OP_ADD_PRINT: return prints;
+        case DOPE_OP_ADD_PRINT_COMPARE: return prints && after == DOPE_OP_COMPARE;
+        case DOPE_OP_PRINT_NEWLINE: return next == DOPE_OP_NEWLINE;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks everything the executor indexes with, so a damaged cache is recompiled
+ *        instead of running off the register file or the handler table
+ */
+static bool dope_cache_valid(const dope_program_t* program) {
+    uint16_t i;
+    uint8_t j;
+    if (!program->count || program->scalar_count > program->variable_count
+        || program->variable_count > DOPE_VARIABLE_LETTERS * DOPE_VARIABLE_SUFFIXES + program->loop_count
+        || program->register_count != program->variable_count + program->constant_count) {
+        return false;
+    }
+    for (i = 0; i < program->count; ++i) {
+        const dope_instruction_t* instruction = &program->code[i];
+        if (instruction->opcode >= DOPE_OP_COUNT || !instruction->line || instruction->line > DOPE_MAX_LINE_NUMBER
+            || program->lines[instruction->line] != i || !dope_cache_followers_valid(program, i)) {
+            return false;
+        }
+        const char* signature = dope_cache_signatures[instruction->opcode];
+        for (j = 0; signature[j]; ++j) {
+            if (!dope_cache_operand_valid(program, signature[j], &instruction->operands[j])) {
+                return false;
+            }
+        }
+    }
+    for (i = 0; i < program->loop_count; ++i) {
+        const dope_loop_t* loop = &program->loops[i];
+        if (loop->counter >= program->variable_count || loop->body > program->count || loop->exit > program->count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Gives back everything allocated since the arena held used bytes
+ */
+static void dope_cache_release(mem_arena_t* arena, mem_size_t used) {
+    mem_size_t taken = mem_arena_used(arena) - used;
+    if (taken) {
+        mem_arena_dealloc(arena, taken);
+    }
+}
+
+void dope_cache_path(const char* path_name, char* cache) {
+    file_replace_extension(path_name, DOPE_CACHE_EXTENSION, cache, DOPE_CACHE_MAX_PATH);
+}
+
+dope_program_t* dope_cache_load(mem_arena_t* arena, const char* path_name) {
+    require_address(arena, "NULL memory arena!");
+    require_address(path_name, "NULL path name!");
+
+    dope_cache_header_t current;
+    if (!dope_cache_identify(path_name, &current)) {
+        return NULL;
+    }
+
+    char cache[DOPE_CACHE_MAX_PATH];
+    dope_cache_path(path_name, cache);
+    dos_file_handle_t fhandle = dos_open_file(cache, ACCESS_READ_ONLY | DENY_WRITE);
+    if (!fhandle) {
+        return NULL;
+    }
+    dope_cache_header_t header;
+    uint16_t code, loops, lines, text;
+    uint16_t bytes_read = dos_read_file(fhandle, (char*)&header, sizeof(header));
+    if (bytes_read != sizeof(header)
+        || memcmp(header.magic, DOPE_CACHE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != DOPE_CACHE_VERSION
+        || header.record_size != sizeof(dope_instruction_t)
+        || header.source_size != current.source_size
+        || header.source_hash != current.source_hash
+        || header.count > DOPE_MAX_LINE_NUMBER || header.loop_count > header.count
+        || header.constant_count > DOPE_MAX_CONSTANTS || header.text_size > DOPE_MAX_TEXT
+        || header.body_size != dope_cache_layout(&header, &code, &loops, &lines, &text)) {
+        dos_close_file(fhandle);                    // missing, foreign or stale
+        return NULL;
+    }
+
+    mem_size_t used = mem_arena_used(arena);       // alignment padding included in the roll back
+    char* body = (char*)mem_arena_alloc_aligned(arena, header.body_size, sizeof(double));
+    dope_program_t* program = body ? (dope_program_t*)mem_arena_calloc(arena, sizeof(dope_program_t)) : NULL;
+    if (!program) {
+        dos_close_file(fhandle);                    // no room: let the compiler report it
+        dope_cache_release(arena, used);
+        return NULL;
+    }
+    bool complete = dos_read_file(fhandle, body, header.body_size) == header.body_size;
+    dos_close_file(fhandle);
+
+    program->constants = (double*)body;
+    program->code = (dope_instruction_t*)(body + code);
+    program->loops = header.loop_count ? (dope_loop_t*)(body + loops) : NULL;
+    memcpy(program->lines, body + lines, DOPE_LINE_TABLE_SIZE);
+    program->text = body + text;
+    program->count = header.count;
+    program->constant_count = header.constant_count;
+    program->constant_capacity = header.constant_count;
+    program->scalar_count = header.scalar_count;
+    program->variable_count = header.variable_count;
+    program->register_count = header.register_count;
+    program->text_size = header.text_size;
+    program->loop_count = header.loop_count;
+    if (!complete || dope_cache_hash_program(&header, program) != header.body_hash
+        || !dope_cache_valid(program)) {            // truncated, damaged or forged: compile instead
+        dope_cache_release(arena, used);
+        return NULL;
+    }
+    return program;
+}
+
+dos_error_code_t dope_cache_save(const dope_program_t* program, const char* path_name) {
+    require_address(program, "NULL program!");
+    require_address(path_name, "NULL path name!");
+
+    dope_cache_header_t header;
+    memset(&header, 0, sizeof(header));
+    dos_last_error_clear();
+    if (!dope_cache_identify(path_name, &header)) {
+        return dos_last_error_code();
+    }
+    memcpy(header.magic, DOPE_CACHE_MAGIC, sizeof(header.magic));
+    header.version = DOPE_CACHE_VERSION;
+    header.record_size = sizeof(dope_instruction_t);
+    header.count = program->count;
+    header.constant_count = program->constant_count;
+    header.scalar_count = program->scalar_count;
+    header.variable_count = program->variable_count;
+    header.register_count = program->register_count;
+    header.text_size = program->text_size;
+    header.loop_count = program->loop_count;
+    uint16_t code, loops, lines, text;
+    header.body_size = dope_cache_layout(&header, &code, &loops, &lines, &text);
+    header.body_hash = dope_cache_hash_program(&header, program);
+
+    char cache[DOPE_CACHE_MAX_PATH];
+    dope_cache_path(path_name, cache);
+    dos_file_handle_t fhandle = dos_create_file(cache, CREATE_READ_WRITE);
+    if (!fhandle) {
+        return dos_last_error_code();
+    }
+    struct {
+        const void* bytes;
+        uint16_t nbytes;
+    } parts[] = {
+        { &header, sizeof(header) },
+        { program->constants, code },
+        { program->code, (uint16_t)(loops - code) },
+        { program->loops, (uint16_t)(lines - loops) },
+        { program->lines, DOPE_LINE_TABLE_SIZE },
+        { program->text, program->text_size }
+    };
+    dos_error_code_t err_code = dos_file_preallocate(fhandle, sizeof(header) + header.body_size);
+    size_t i;
+    for (i = 0; !err_code && i < sizeof(parts) / sizeof(parts[0]); ++i) {
+        if (parts[i].nbytes && dos_write_file(fhandle, (const char*)parts[i].bytes, parts[i].nbytes) != parts[i].nbytes) {
+            err_code = dos_last_error_code() ? dos_last_error_code() : DOS_INSUFFICIENT_DISK_SPACE;
+        }
+    }
+    dos_close_file(fhandle);
+    if (err_code) {
+        dos_delete_file(cache);                     // never leave a half written cache behind
+    }
+    return err_code;
+}
+
+dope_program_t* dope_cache_open(mem_arena_t* arena, const char* path_name, dope_diagnostic_t* diagnostic) {
+    require_address(diagnostic, "NULL diagnostic!");
+
+    dope_program_t* program = dope_cache_load(arena, path_name);
+    if (program) {
+        diagnostic->error = DOPE_COMPILE_OK;
+        diagnostic->source_line = 0;
+        return program;
+    }
+    dos_last_error_clear();                         // a missing or stale cache is not the compiler's error
+    program = dope_compile_file(arena, path_name, diagnostic);
+    if (program) {
+        dope_optimize(program);
+        dope_cache_save(program, path_name);
+        dos_last_error_clear();                     // the cache is only a cache
+    }
+    return program;
+}
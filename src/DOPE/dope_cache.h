@@ -0,0 +1,94 @@
+/**
+ * @file dope_cache.h
+ * @brief Compiled DOPE programs cached beside their source
+ * @defgroup dope_cache DOPE Bytecode Cache
+ * @{
+ */
+#ifndef DOPE_CACHE_H
+#define DOPE_CACHE_H
+
+#include <stdint.h>
+
+#include "dope_compile.h"
+#include "dope_types.h"
+#include "../DOS/dos_services_files_types.h"
+#include "../DOS/dos_services_types.h"
+#include "../MEM/mem_arena.h"
+
+#define DOPE_CACHE_MAGIC        "DPC1"
+#define DOPE_CACHE_VERSION      2
+#define DOPE_CACHE_EXTENSION    "DPC"       ///< Cache replaces the source's extension
+#define DOPE_CACHE_MAX_PATH     128
+
+/**
+ * @brief Cache header, also identifies the source it was compiled from
+ */
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t record_size;           ///< sizeof(dope_instruction_t), rejects caches of another build
+    dos_file_size_t source_size;
+    uint32_t source_hash;           ///< FNV-1a of the source bytes
+    uint16_t body_size;
+    uint16_t count;
+    uint16_t constant_count;
+    uint16_t scalar_count;
+    uint16_t variable_count;
+    uint16_t register_count;
+    uint16_t text_size;
+    uint8_t loop_count;
+    uint8_t reserved;
+    uint32_t body_hash;             ///< FNV-1a of this header (body_hash 0) and the body
+} dope_cache_header_t;
+
+/**
+ * @brief Loads the cached program of a source file if it is still current
+ * @param arena Arena for the program
+ * @param path_name Source file (not the cache)
+ * @return Program or NULL if there is no cache or it is stale
+ *
+ * @details The program is read back exactly as it was in memory - no text is split,
+ * no operand resolved and no jump looked up:
+ * @code
+ * | PROG.DPC                                                                        |
+ * |---------------------------------------------------------------------------------|
+ * | header | constants[] | code[] | loops[] | lines[100] | text[]                   |
+ * @endcode
+ * The header and the body take one read each. The cache is current when the source's
+ * size and hash match. The source is hashed on every load: DOS stamps only resolve
+ * 2 seconds and copies often keep them, and 99 lines hash in far less time than
+ * they compile. A body that does not match its hash, or whose opcodes, registers,
+ * jumps, loop frames or prompts point outside the program, is never run: NULL is
+ * returned and dope_cache_open() compiles the source instead.
+ */
+dope_program_t* dope_cache_load(mem_arena_t* arena, const char* path_name);
+
+/**
+ * @brief Saves a program beside its source
+ * @param program Program compiled from path_name
+ * @param path_name Source file (not the cache)
+ * @return DOS_SUCCESS or the failing call's error code
+ */
+dos_error_code_t dope_cache_save(const dope_program_t* program, const char* path_name);
+
+/**
+ * @brief Loads a current cache, or compiles and optimizes the source and saves the cache
+ * @param arena Arena for the program
+ * @param path_name Source file
+ * @param diagnostic Receives the compile error, if any
+ * @return Program or NULL on a compile error
+ *
+ * @note A cache that cannot be written (read-only media) is not an error
+ */
+dope_program_t* dope_cache_open(mem_arena_t* arena, const char* path_name, dope_diagnostic_t* diagnostic);
+
+/**
+ * @brief Makes the cache path of a source file: PROG.DOP -> PROG.DPC
+ * @param path_name Source file
+ * @param cache Receives the cache path (DOPE_CACHE_MAX_PATH bytes)
+ */
+void dope_cache_path(const char* path_name, char* cache);
+
+#endif
+
+/** @} */ // end of dope_cache group
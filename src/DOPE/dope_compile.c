@@ -0,0 +1,445 @@
+#include "dope_compile.h"
+#include "../CONTRACT/contract.h"
+#include "../DOS/dos_error_messages.h"
+#include "../FILEUTIL/file_constants.h"
+#include "../STRUTIL/str_number.h"
+#include "../STRUTIL/str_scan.h"
+#include "../STRUTIL/str_view.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * @brief Command spelling and operand signature
+ * @details One signature letter per operand: v value (literal or variable), w variable
+ *          (written), L line number, l line number or 0 for the next line, t prompt text.
+ */
+typedef struct {
+    const char* name;
+    uint8_t opcode;
+    const char* signature;
+} dope_command_t;
+
+static const dope_command_t dope_commands[] = {
+    { "+",   DOPE_OP_ADD,      "vvw"  },
+    { "-",   DOPE_OP_SUB,      "vvw"  },
+    { "*",   DOPE_OP_MUL,      "vvw"  },
+    { "/",   DOPE_OP_DIV,      "vvw"  },
+    { "EXP", DOPE_OP_EXP,      "vw"   },
+    { "LOG", DOPE_OP_LOG,      "vw"   },
+    { "SIN", DOPE_OP_SIN,      "vw"   },
+    { "SQR", DOPE_OP_SQR,      "vw"   },
+    { "P",   DOPE_OP_PRINT,    "v"    },
+    { "N",   DOPE_OP_NEWLINE,  ""     },
+    { "J",   DOPE_OP_INPUT,    "w"    },
+    { "A",   DOPE_OP_ASK,      "tw"   },
+    { "T",   DOPE_OP_JUMP,     "L"    },
+    { "C",   DOPE_OP_COMPARE,  "vvll" },
+    { "Z",   DOPE_OP_LOOP,     "vvw"  },
+    { "E",   DOPE_OP_END_LOOP, ""     }
+};
+
+#define DOPE_COMMAND_COUNT (sizeof(dope_commands) / sizeof(dope_commands[0]))
+
+static const char dope_compile_messages[][40] = {
+    "OK",
+    "Line number must be 1-99",
+    "Line number used twice",
+    "Unknown command",
+    "Wrong number of operands",
+    "Bad operand",
+    "Jump to a line that does not exist",
+    "Too many literals or too much text",
+    "Z without E or E without Z",
+    "Z nested too deep",
+    "No program lines",
+    "Cannot read the source",
+    "Not enough memory to compile"
+};
+
+/**
+ * @brief Parses an integer line number
+ * @return true if the field is an integer in [lowest, DOPE_MAX_LINE_NUMBER]
+ */
+static bool dope_compile_line_number(str_view_t field, uint8_t lowest, uint8_t* line) {
+    double value;
+    if (!field.length || str_number_parse(field.ptr, field.length, &value) != field.length) {
+        return false;
+    }
+    if (value < lowest || value > DOPE_MAX_LINE_NUMBER || value != (double)(uint8_t)value) {
+        return false;
+    }
+    *line = (uint8_t)value;
+    return true;
+}
+
+/**
+ * @brief Finds or adds a literal in the constant pool
+ * @details Literals are matched bit for bit so 0 and -0 stay distinct.
+ * @return Pool index, or -1 if the pool is full
+ */
+static int dope_compile_constant(dope_program_t* program, double value) {
+    uint16_t i;
+    for (i = 0; i < program->constant_count; ++i) {
+        if (memcmp(&program->constants[i], &value, sizeof(double)) == 0) {
+            return i;
+        }
+    }
+    if (program->constant_count == DOPE_MAX_CONSTANTS) {
+        return -1;
+    }
+    program->constants[program->constant_count] = value;
+    return program->constant_count++;
+}
+
+static bool dope_compile_variable(str_view_t field, dope_operand_t* operand) {
+    if (field.length < 1 || field.length > 2 || field.ptr[0] < 'A' || field.ptr[0] > 'Z') {
+        return false;
+    }
+    if (field.length == 2 && (field.ptr[1] < '0' || field.ptr[1] > '9')) {
+        return false;
+    }
+    operand->kind = DOPE_OPERAND_VARIABLE;
+    operand->letter = (uint8_t)(field.ptr[0] - 'A');
+    operand->value = field.length == 2 ? (uint16_t)(field.ptr[1] - '0') : DOPE_NO_SUFFIX;
+    return true;
+}
+
+static dope_compile_error_t dope_compile_operand(dope_program_t* program, char signature, str_view_t field, dope_operand_t* operand) {
+    uint8_t line;
+    double value;
+
+    switch (signature) {
+        case 'v':
+            if (field.length && str_number_parse(field.ptr, field.length, &value) == field.length) {
+                int index = dope_compile_constant(program, value);
+                if (index < 0) {
+                    return DOPE_COMPILE_TOO_BIG;
+                }
+                operand->kind = DOPE_OPERAND_CONSTANT;
+                operand->value = (uint16_t)index;
+                return DOPE_COMPILE_OK;
+            }
+            return dope_compile_variable(field, operand) ? DOPE_COMPILE_OK : DOPE_COMPILE_BAD_OPERAND;
+        case 'w':
+            return dope_compile_variable(field, operand) ? DOPE_COMPILE_OK : DOPE_COMPILE_BAD_OPERAND;
+        case 'L':
+        case 'l':
+            if (!dope_compile_line_number(field, signature == 'L' ? 1 : 0, &line)) {
+                return DOPE_COMPILE_BAD_OPERAND;
+            }
+            operand->kind = DOPE_OPERAND_LINE;
+            operand->value = line;
+            return DOPE_COMPILE_OK;
+        case 't':
+            if (field.length > UINT8_MAX) {
+                return DOPE_COMPILE_BAD_OPERAND;
+            }
+            if (program->text_size + field.length > DOPE_MAX_TEXT) {
+                return DOPE_COMPILE_TOO_BIG;
+            }
+            memcpy(program->text + program->text_size, field.ptr, field.length);
+            operand->kind = DOPE_OPERAND_TEXT;
+            operand->letter = (uint8_t)field.length;
+            operand->value = program->text_size;
+            program->text_size += (uint16_t)field.length;
+            return DOPE_COMPILE_OK;
+    }
+    ensure(0, "Unknown operand signature!");
+    return DOPE_COMPILE_BAD_OPERAND;
+}
+
+/**
+ * @brief Compiles one non-blank source line into an instruction
+ */
+static dope_compile_error_t dope_compile_instruction(dope_program_t* program, str_view_t text, dope_instruction_t* instruction) {
+    str_view_t fields[DOPE_MAX_FIELDS + 1];
+    size_t count = str_view_tokenize(text, DOPE_DELIMITER, fields, DOPE_MAX_FIELDS + 1);
+    while (count > 2 && count <= DOPE_MAX_FIELDS + 1 && !fields[count - 1].length) {
+        --count;                                        // "4'E'" has an empty last field
+    }
+    if (count > DOPE_MAX_FIELDS) {
+        return DOPE_COMPILE_OPERAND_COUNT;
+    }
+    if (!dope_compile_line_number(fields[0], 1, &instruction->line)) {
+        return DOPE_COMPILE_BAD_LINE_NUMBER;
+    }
+    if (count < 2) {
+        return DOPE_COMPILE_UNKNOWN_COMMAND;
+    }
+
+    const dope_command_t* command = NULL;
+    size_t i;
+    for (i = 0; i < DOPE_COMMAND_COUNT; ++i) {
+        if (str_view_equals_cstr(fields[1], dope_commands[i].name)) {
+            command = &dope_commands[i];
+            break;
+        }
+    }
+    if (!command) {
+        return DOPE_COMPILE_UNKNOWN_COMMAND;
+    }
+    if (count - 2 != strlen(command->signature)) {
+        return DOPE_COMPILE_OPERAND_COUNT;
+    }
+
+    memset(instruction->operands, 0, sizeof(instruction->operands));
+    instruction->opcode = command->opcode;
+    for (i = 0; i < count - 2; ++i) {
+        dope_compile_error_t error = dope_compile_operand(program, command->signature[i], fields[i + 2], &instruction->operands[i]);
+        if (error) {
+            return error;
+        }
+    }
+    return DOPE_COMPILE_OK;
+}
+
+/**
+ * @brief Inserts an instruction in line number order
+ */
+static bool dope_compile_insert(dope_program_t* program, const dope_instruction_t* instruction) {
+    uint16_t position = program->count;
+    while (position && program->code[position - 1].line >= instruction->line) {
+        if (program->code[position - 1].line == instruction->line) {
+            return false;
+        }
+        --position;
+    }
+    memmove(&program->code[position + 1], &program->code[position], (size_t)(program->count - position) * sizeof(dope_instruction_t));
+    program->code[position] = *instruction;
+    ++program->count;
+    return true;
+}
+
+/**
+ * @brief Builds the line table and turns every jump operand into an instruction index
+ * @details A target of 0 ("next line") becomes the following instruction, so C always
+ *          takes one of three direct indices and the executor never searches for a line.
+ * @return Index of the first instruction jumping to a missing line, or program->count
+ */
+static uint16_t dope_compile_resolve(dope_program_t* program) {
+    uint16_t i, j;
+    memset(program->lines, DOPE_NO_LINE, sizeof(program->lines));
+    for (i = 0; i < program->count; ++i) {
+        program->lines[program->code[i].line] = (uint8_t)i;
+    }
+    for (i = 0; i < program->count; ++i) {
+        dope_operand_t* operands = program->code[i].operands;
+        for (j = 0; j < DOPE_MAX_OPERANDS; ++j) {
+            if (operands[j].kind != DOPE_OPERAND_LINE) continue;
+            uint8_t target = operands[j].value ? program->lines[operands[j].value] : (uint8_t)(i + 1);
+            if (target == DOPE_NO_LINE) {
+                return i;
+            }
+            operands[j].kind = DOPE_OPERAND_TARGET;
+            operands[j].value = target;
+        }
+    }
+    return program->count;
+}
+
+/**
+ * @brief Pairs every Z with its E through a fixed-depth stack of open loops
+ * @param failed Receives the offending instruction on an error
+ */
+static dope_compile_error_t dope_compile_loops(mem_arena_t* arena, dope_program_t* program, uint16_t* failed) {
+    uint16_t i, starts = 0;
+    for (i = 0; i < program->count; ++i) {
+        starts += program->code[i].opcode == DOPE_OP_LOOP;
+    }
+    program->loop_count = 0;
+    *failed = 0;
+    if (starts) {
+        program->loops = (dope_loop_t*)mem_arena_alloc(arena, starts * sizeof(dope_loop_t));
+        if (!program->loops) {
+            return DOPE_COMPILE_NO_MEMORY;
+        }
+    }
+    uint8_t* open = (uint8_t*)mem_arena_alloc(arena, DOPE_MAX_LOOP_DEPTH);
+    if (!open) {
+        return DOPE_COMPILE_NO_MEMORY;
+    }
+
+    dope_compile_error_t error = DOPE_COMPILE_OK;
+    uint8_t depth = 0;
+    for (i = 0; i < program->count && !error; ++i) {
+        dope_operand_t* operands = program->code[i].operands;
+        if (program->code[i].opcode == DOPE_OP_LOOP) {
+            if (depth == DOPE_MAX_LOOP_DEPTH) {
+                error = DOPE_COMPILE_LOOP_DEPTH;
+                break;
+            }
+            open[depth++] = program->loop_count;
+            program->loops[program->loop_count].body = i + 1;
+            operands[3].kind = DOPE_OPERAND_LOOP;
+            operands[3].value = program->loop_count++;
+        } else if (program->code[i].opcode == DOPE_OP_END_LOOP) {
+            if (!depth) {
+                error = DOPE_COMPILE_UNMATCHED_LOOP;
+                break;
+            }
+            --depth;
+            program->loops[open[depth]].exit = i + 1;
+            operands[0].kind = DOPE_OPERAND_LOOP;
+            operands[0].value = open[depth];
+        }
+    }
+    if (!error && depth) {
+        error = DOPE_COMPILE_UNMATCHED_LOOP;
+        i = program->loops[open[depth - 1]].body - 1;
+    }
+    *failed = i;
+    mem_arena_dealloc(arena, DOPE_MAX_LOOP_DEPTH);          // the stack is only needed here
+    return error;
+}
+
+/**
+ * @brief Lays out the register file and turns every variable and literal into a slot
+ * @details Only names the program uses get a slot, so the machine state of a typical
+ *          program is a few dozen doubles - a handful of cache lines.
+ */
+static void dope_compile_allocate(dope_program_t* program) {
+    uint16_t scalars[DOPE_VARIABLE_LETTERS][DOPE_VARIABLE_SUFFIXES];
+    uint16_t arrays[DOPE_ARRAY_LAST - DOPE_ARRAY_FIRST + 1];
+    uint16_t i, j, array_count = 0;
+    memset(scalars, 0xFF, sizeof(scalars));
+    memset(arrays, 0xFF, sizeof(arrays));
+
+    /* scalars first, then the arrays behind them */
+    program->scalar_count = 0;
+    for (i = 0; i < program->count; ++i) {
+        const dope_operand_t* operands = program->code[i].operands;
+        for (j = 0; j < DOPE_MAX_OPERANDS; ++j) {
+            const dope_operand_t* operand = &operands[j];
+            if (operand->kind != DOPE_OPERAND_VARIABLE) continue;
+            uint8_t array = (uint8_t)(operand->letter - (DOPE_ARRAY_FIRST - 'A'));
+            if (array <= DOPE_ARRAY_LAST - DOPE_ARRAY_FIRST) {
+                if (arrays[array] == 0xFFFF) {
+                    arrays[array] = array_count++;
+                }
+            } else if (scalars[operand->letter][operand->value] == 0xFFFF) {
+                scalars[operand->letter][operand->value] = program->scalar_count++;
+            }
+        }
+    }
+    program->variable_count = program->scalar_count + array_count * DOPE_ARRAY_SIZE;
+    for (i = 0; i < program->loop_count; ++i) {
+        program->loops[i].counter = program->variable_count++;
+    }
+    program->register_count = program->variable_count + program->constant_count;
+
+    for (i = 0; i < program->count; ++i) {
+        dope_operand_t* operands = program->code[i].operands;
+        for (j = 0; j < DOPE_MAX_OPERANDS; ++j) {
+            dope_operand_t* operand = &operands[j];
+            if (operand->kind == DOPE_OPERAND_CONSTANT) {
+                operand->value = program->variable_count + operand->value;
+            } else if (operand->kind == DOPE_OPERAND_VARIABLE) {
+                uint8_t array = (uint8_t)(operand->letter - (DOPE_ARRAY_FIRST - 'A'));
+                if (array <= DOPE_ARRAY_LAST - DOPE_ARRAY_FIRST) {
+                    uint16_t element = operand->value == DOPE_NO_SUFFIX ? 0 : operand->value;
+                    operand->value = program->scalar_count + arrays[array] * DOPE_ARRAY_SIZE + element;
+                } else {
+                    operand->value = scalars[operand->letter][operand->value];
+                }
+            } else {
+                continue;
+            }
+            operand->kind = DOPE_OPERAND_REGISTER;
+            operand->letter = 0;
+        }
+    }
+}
+
+static dope_program_t* dope_compile_fail(dope_diagnostic_t* diagnostic, dope_compile_error_t error, uint32_t source_line) {
+    diagnostic->error = error;
+    diagnostic->source_line = source_line;
+    return NULL;
+}
+
+dope_program_t* dope_compile(mem_arena_t* arena, file_line_stream_t* lines, dope_diagnostic_t* diagnostic) {
+    require_address(arena, "NULL memory arena!");
+    require_address(lines, "NULL line stream!");
+    require_address(diagnostic, "NULL diagnostic!");
+
+    dope_program_t* program = (dope_program_t*)mem_arena_calloc(arena, sizeof(dope_program_t));
+    if (!program) {
+        return dope_compile_fail(diagnostic, DOPE_COMPILE_NO_MEMORY, 0);
+    }
+    program->code = (dope_instruction_t*)mem_arena_alloc(arena, DOPE_MAX_LINE_NUMBER * sizeof(dope_instruction_t));
+    program->constants = (double*)mem_arena_alloc(arena, DOPE_MAX_CONSTANTS * sizeof(double));
+    program->text = (char*)mem_arena_alloc(arena, DOPE_MAX_TEXT);
+    if (!program->code || !program->constants || !program->text) {
+        return dope_compile_fail(diagnostic, DOPE_COMPILE_NO_MEMORY, 0);
+    }
+    program->constant_capacity = DOPE_MAX_CONSTANTS;
+
+    /* source line of each DOPE line number, for errors found once every line is in */
+    uint32_t source_lines[DOPE_MAX_LINE_NUMBER + 1];
+    memset(source_lines, 0, sizeof(source_lines));
+
+    file_line_view_t line;
+    bool ended = false;
+    while (!ended && file_line_stream_next(lines, &line)) {
+        const char* ctrl_z = str_scan_byte(line.ptr, line.length, CTRL_Z);
+        if (ctrl_z) {                                       // DOS end of file: COPY CON, EDIT
+            line = str_view_make(line.ptr, (size_t)(ctrl_z - line.ptr));
+            ended = true;
+        }
+        str_view_t text = str_view_before(line, DOPE_COMMENT);
+        if (str_view_is_blank(text)) {
+            continue;
+        }
+        uint32_t source_line = file_line_stream_line_number(lines);
+        dope_instruction_t instruction;
+        dope_compile_error_t error = dope_compile_instruction(program, text, &instruction);
+        if (error) {
+            return dope_compile_fail(diagnostic, error, source_line);
+        }
+        if (!dope_compile_insert(program, &instruction)) {
+            return dope_compile_fail(diagnostic, DOPE_COMPILE_DUPLICATE_LINE, source_line);
+        }
+        source_lines[instruction.line] = source_line;
+    }
+    if (file_line_stream_error(lines)) {                    // broke off: a line too long, or a read error
+        return dope_compile_fail(diagnostic, file_line_stream_error(lines) == DOS_INSUFFICIENT_MEMORY ? DOPE_COMPILE_NO_MEMORY
+                                                                                                      : DOPE_COMPILE_UNREADABLE,
+                                 file_line_stream_line_number(lines) + 1);
+    }
+    if (!program->count) {
+        return dope_compile_fail(diagnostic, DOPE_COMPILE_EMPTY, 0);
+    }
+
+    uint16_t unresolved = dope_compile_resolve(program);
+    if (unresolved < program->count) {
+        return dope_compile_fail(diagnostic, DOPE_COMPILE_UNDEFINED_LINE, source_lines[program->code[unresolved].line]);
+    }
+    uint16_t failed;
+    dope_compile_error_t error = dope_compile_loops(arena, program, &failed);
+    if (error) {
+        return dope_compile_fail(diagnostic, error, error == DOPE_COMPILE_NO_MEMORY ? 0 : source_lines[program->code[failed].line]);
+    }
+    dope_compile_allocate(program);
+    diagnostic->error = DOPE_COMPILE_OK;
+    diagnostic->source_line = 0;
+    return program;
+}
+
+dope_program_t* dope_compile_file(mem_arena_t* arena, const char* path_name, dope_diagnostic_t* diagnostic) {
+    require_address(arena, "NULL memory arena!");
+    require_address(path_name, "NULL path name!");
+    require_address(diagnostic, "NULL diagnostic!");
+
+    file_line_stream_t* lines = file_line_stream_open(arena, path_name, DOPE_SOURCE_BUFFER);
+    if (!lines) {
+        return dope_compile_fail(diagnostic, DOPE_COMPILE_UNREADABLE, 0);
+    }
+    dope_program_t* program = dope_compile(arena, lines, diagnostic);
+    file_line_stream_close(lines);
+    return program;
+}
+
+const char* dope_compile_message(dope_compile_error_t error) {
+    require_range(error <= DOPE_COMPILE_NO_MEMORY, "Unknown compile error!");
+    return dope_compile_messages[error];
+}
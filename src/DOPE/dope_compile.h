@@ -0,0 +1,84 @@
+/**
+ * @file dope_compile.h
+ * @brief Compiles DOPE source once into a fixed-size instruction array
+ * @defgroup dope_compile DOPE Compiler
+ * @{
+ */
+#ifndef DOPE_COMPILE_H
+#define DOPE_COMPILE_H
+
+#include <stdint.h>
+
+#include "dope_types.h"
+#include "../FILEUTIL/file_line_stream.h"
+#include "../MEM/mem_arena.h"
+
+typedef enum {
+    DOPE_COMPILE_OK,
+    DOPE_COMPILE_BAD_LINE_NUMBER,   ///< not an integer 1-99
+    DOPE_COMPILE_DUPLICATE_LINE,
+    DOPE_COMPILE_UNKNOWN_COMMAND,
+    DOPE_COMPILE_OPERAND_COUNT,     ///< wrong number of operands for the command
+    DOPE_COMPILE_BAD_OPERAND,       ///< not a number, variable, line or text where one is expected
+    DOPE_COMPILE_UNDEFINED_LINE,    ///< jump to a line the program does not have
+    DOPE_COMPILE_TOO_BIG,           ///< too many literals or too much prompt text
+    DOPE_COMPILE_UNMATCHED_LOOP,    ///< E without a Z, or Z without an E
+    DOPE_COMPILE_LOOP_DEPTH,        ///< Z nested deeper than DOPE_MAX_LOOP_DEPTH
+    DOPE_COMPILE_EMPTY,
+    DOPE_COMPILE_UNREADABLE,        ///< source could not be opened or read (see dos_last_error())
+    DOPE_COMPILE_NO_MEMORY          ///< the arena ran out, e.g. on a very long source line
+} dope_compile_error_t;
+
+/**
+ * @brief Where and why compilation stopped
+ */
+typedef struct {
+    dope_compile_error_t error;
+    uint32_t source_line;       ///< 1-based line in the source text, 0 if not line specific
+} dope_diagnostic_t;
+
+/**
+ * @brief Compiles a program
+ * @param arena Arena for the program
+ * @param lines Source lines, e.g. from file_line_stream_open()
+ * @param diagnostic Receives the error, if any
+ * @return Program or NULL on a compile error
+ *
+ * @details Every line is split and resolved exactly once. The executor then runs
+ * the instruction array and never sees source text again:
+ * @code
+ * | Source              | Compiled                                               |
+ * |---------------------|--------------------------------------------------------|
+ * | 5'+'A'B'C           | { DOPE_OP_ADD, 5, { r0, r1, r2 } }                     |
+ * | 7'*'D'2'X           | { DOPE_OP_MUL, 7, { r3, r5 = 2, r4 } }                 |
+ * | 60'C'A'0'70'80      | { DOPE_OP_COMPARE, 60, { r0, r6 = 0, @70, @80 } }      |
+ * @endcode
+ * Once every line is in, a 100 entry table maps line numbers to instruction indices
+ * and each T and C target is replaced by the index it lands on (@70 above), so jumps
+ * never search - however branch heavy the program. Finally every variable and literal
+ * becomes a slot in one flat register file (see dope_program_t), so fetching an
+ * operand is a single indexed load. Each Z is paired with its E through a stack of
+ * open loops and both get the resulting dope_loop_t frame.
+ * Lines may appear in any order and are sorted by line number. Blank lines, spaces
+ * and anything after a '#' are ignored, as are empty trailing fields ("4'E'").
+ * A Ctrl-Z (0x1A), which DOS editors and COPY CON leave at the end, ends the source.
+ */
+dope_program_t* dope_compile(mem_arena_t* arena, file_line_stream_t* lines, dope_diagnostic_t* diagnostic);
+
+/**
+ * @brief Compiles a program file
+ * @param arena Arena for the program and the file's read buffers
+ * @param path_name Source file
+ * @param diagnostic Receives the error, if any
+ * @return Program or NULL on a compile error or if the file cannot be read (see dos_last_error())
+ */
+dope_program_t* dope_compile_file(mem_arena_t* arena, const char* path_name, dope_diagnostic_t* diagnostic);
+
+/**
+ * @brief Describes a compile error
+ */
+const char* dope_compile_message(dope_compile_error_t error);
+
+#endif
+
+/** @} */ // end of dope_compile group
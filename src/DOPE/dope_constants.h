@@ -1,4 +1,29 @@
 #ifndef DOPE_CONSTANTS_H
 #define DOPE_CONSTANTS_H
 
+#include "../STRUTIL/str_scan.h"
+
+#define DOPE_MAX_LINE_NUMBER    99                      // line numbers 1-99 are the only labels
+#define DOPE_LINE_TABLE_SIZE    (DOPE_MAX_LINE_NUMBER + 1)
+#define DOPE_NO_LINE            0xFF                    // line table entry of a missing line
+#define DOPE_MAX_OPERANDS       4                       // C'a'b'l1'l2
+#define DOPE_MAX_FIELDS         (DOPE_MAX_OPERANDS + 2) // line number, command, operands
+#define DOPE_MAX_LOOP_DEPTH     8                       // Z inside Z inside ...
+#define DOPE_MAX_CONSTANTS      128                     // distinct literals per program
+#define DOPE_MAX_TEXT           512                     // bytes of A prompts per program
+#define DOPE_MAX_COMMAND        3                       // EXP, LOG, SIN, SQR
+
+#define DOPE_DELIMITER          STR_SCAN_DELIMITER      // 5'+'A'B'C
+#define DOPE_COMMENT            '#'                     // rest of the line is ignored
+
+#define DOPE_VARIABLE_LETTERS   26                      // A-Z
+#define DOPE_VARIABLE_SUFFIXES  11                      // X, X0-X9
+#define DOPE_NO_SUFFIX          10                      // plain X
+#define DOPE_ARRAY_FIRST        'E'                     // E, F, G, H are arrays
+#define DOPE_ARRAY_LAST         'H'
+#define DOPE_ARRAY_SIZE         10                      // E0-E9, plain E is E0
+
+#define DOPE_SOURCE_BUFFER      4096                    // line stream buffer for source files
+#define DOPE_INPUT_BUFFER       256                     // line stream buffer for J and A input
+
 #endif
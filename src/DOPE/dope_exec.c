@@ -0,0 +1,235 @@
+#include "dope_exec.h"
+#include "../CONTRACT/contract.h"
+#include "../DOS/dos_error_messages.h"
+#include "../DOS/dos_last_error.h"
+#include "../FILEUTIL/file_line_stream.h"
+#include "../STRUTIL/str_number.h"
+#include "../STRUTIL/str_view.h"
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct private_dope_machine_t {
+    const dope_program_t* program;
+    double* registers;              ///< Variables then literals, see dope_program_t
+#if DOPE_EXEC_HAS_THREADED
+    const void** handlers;          ///< Label of each instruction, then the halt sentinel
+#endif
+    file_line_stream_t* input;
+    FILE* output;
+    mem_arena_t* arena;
+    dope_budget_t budget;
+    dope_profile_t* profile;        ///< NULL = not profiling
+    uint32_t started;               ///< dope_exec_clock() when the run began
+    uint32_t instructions;
+    uint8_t line;
+} dope_machine_t;
+
+static const char dope_exec_status_messages[DOPE_STATUS_COUNT][32] = {
+    "End of program",
+    "End of input",
+    "Input is not a number",
+    "Instruction limit reached",
+    "Time limit reached",
+    "Memory limit reached"
+};
+
+/**
+ * @brief Milliseconds from an arbitrary start, wrapping
+ */
+static uint32_t dope_exec_clock(void) {
+#ifndef __DOS__
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)now.tv_sec * 1000u + (uint32_t)(now.tv_nsec / 1000000);
+#else
+    return (uint32_t)clock() * (1000u / CLOCKS_PER_SEC);   // BIOS timer, 55 ms steps
+#endif
+}
+
+/**
+ * @brief Slow path of the budget, taken when the back branch countdown runs out
+ * @param machine Running machine
+ * @param instructions Executed so far
+ * @param fuel Refilled with the back branches until the next check
+ * @return DOPE_STATUS_END to go on, or the limit that was reached
+ */
+static dope_status_t dope_exec_meter(dope_machine_t* machine, uint32_t instructions, uint32_t* fuel) {
+    const dope_budget_t* budget = &machine->budget;
+    uint32_t interval = budget->milliseconds ? DOPE_EXEC_METER_INTERVAL : UINT32_MAX;
+    if (budget->instructions) {
+        if (instructions >= budget->instructions) {
+            return DOPE_STATUS_INSTRUCTION_LIMIT;
+        }
+        // between two back branches each line runs at most once
+        uint32_t passes = (budget->instructions - instructions) / ((uint32_t)machine->program->count + 1);
+        if (passes < interval) {
+            interval = passes ? passes : 1;
+        }
+    }
+    if (budget->milliseconds && dope_exec_clock() - machine->started >= budget->milliseconds) {
+        return DOPE_STATUS_TIME_LIMIT;
+    }
+    *fuel = interval;
+    return DOPE_STATUS_END;
+}
+
+/**
+ * @brief Reads one number for J or A, skipping blank input lines
+ */
+static dope_status_t dope_exec_read(dope_machine_t* machine, double* value) {
+    file_line_view_t line;
+    if (!machine->input) {
+        return DOPE_STATUS_INPUT_EOF;
+    }
+    do {
+        if (!file_line_stream_next(machine->input, &line)) {
+            return file_line_stream_error(machine->input) == DOS_INSUFFICIENT_MEMORY ? DOPE_STATUS_MEMORY_LIMIT
+                                                                                     : DOPE_STATUS_INPUT_EOF;
+        }
+        line = str_view_trim(line);
+    } while (!line.length);
+    if (str_number_parse(line.ptr, line.length, value) != line.length) {
+        return DOPE_STATUS_BAD_INPUT;
+    }
+    return DOPE_STATUS_END;
+}
+
+static void dope_exec_print(dope_machine_t* machine, double value) {
+    char text[STR_NUMBER_FORMAT_SIZE];
+    size_t length = str_number_format(value, text, sizeof(text));
+    text[length] = ' ';
+    fwrite(text, 1, length + 1, machine->output);
+}
+
+static void dope_exec_prompt(dope_machine_t* machine, const dope_operand_t* text) {
+    fwrite(machine->program->text + text->value, 1, text->letter, machine->output);
+    fputc(' ', machine->output);
+    fflush(machine->output);
+}
+
+/**
+ * @brief Charges one executed instruction to its line and opcode
+ */
+static void dope_exec_profile(dope_profile_t* profile, const dope_instruction_t* instruction, uint64_t nanoseconds) {
+    dope_profile_entry_t* line = &profile->lines[instruction->line];
+    dope_profile_entry_t* opcode = &profile->opcodes[instruction->opcode];
+    ++line->count;
+    line->nanoseconds += nanoseconds;
+    ++opcode->count;
+    opcode->nanoseconds += nanoseconds;
+}
+
+#define DOPE_LOOP_NAME      dope_exec_loop_switch
+#define DOPE_LOOP_THREADED  0
+#define DOPE_LOOP_PROFILED  0
+#include "dope_exec_loop.h"
+#undef DOPE_LOOP_NAME
+#undef DOPE_LOOP_THREADED
+#undef DOPE_LOOP_PROFILED
+
+#if DOPE_EXEC_HAS_THREADED
+#define DOPE_LOOP_NAME      dope_exec_loop_threaded
+#define DOPE_LOOP_THREADED  1
+#define DOPE_LOOP_PROFILED  0
+#include "dope_exec_loop.h"
+#undef DOPE_LOOP_NAME
+#undef DOPE_LOOP_THREADED
+#undef DOPE_LOOP_PROFILED
+#endif
+
+#define DOPE_LOOP_NAME      dope_exec_loop_profiled
+#define DOPE_LOOP_THREADED  0
+#define DOPE_LOOP_PROFILED  1
+#include "dope_exec_loop.h"
+#undef DOPE_LOOP_NAME
+#undef DOPE_LOOP_THREADED
+#undef DOPE_LOOP_PROFILED
+
+dope_machine_t* dope_exec_create(mem_arena_t* arena, const dope_program_t* program, file_source_t* input, FILE* output) {
+    require_address(arena, "NULL memory arena!");
+    require_address(program, "NULL program!");
+    require_address(output, "NULL output stream!");
+
+    /* a program of only N, T and E has no registers - the arena refuses empty requests */
+    mem_size_t registers = program->register_count ? program->register_count : 1;
+    dope_machine_t* machine = (dope_machine_t*)mem_arena_calloc(arena, sizeof(dope_machine_t));
+    if (!machine
+        || !(machine->registers = (double*)mem_arena_alloc_aligned(arena, registers * sizeof(double), sizeof(double)))
+#if DOPE_EXEC_HAS_THREADED
+        || !(machine->handlers = (const void**)mem_arena_calloc(arena, (mem_size_t)(program->count + 1) * sizeof(void*)))
+#endif
+        || (input && !(machine->input = file_line_stream_create(arena, input)))) {
+        dos_last_error_set(DOS_INSUFFICIENT_MEMORY, __func__, NULL, mem_arena_size(arena));
+        return NULL;
+    }
+    machine->program = program;
+    machine->output = output;
+    machine->arena = arena;
+    return machine;
+}
+
+static void dope_exec_reset(dope_machine_t* machine) {
+    const dope_program_t* program = machine->program;
+    memset(machine->registers, 0, program->variable_count * sizeof(double));
+    memcpy(machine->registers + program->variable_count, program->constants, program->constant_count * sizeof(double));
+}
+
+dope_status_t dope_exec_run(dope_machine_t* machine) {
+#if DOPE_EXEC_HAS_THREADED && defined(DOPE_THREADED_DISPATCH)
+    return dope_exec_run_dispatch(machine, DOPE_DISPATCH_THREADED);
+#else
+    return dope_exec_run_dispatch(machine, DOPE_DISPATCH_SWITCH);
+#endif
+}
+
+dope_status_t dope_exec_run_dispatch(dope_machine_t* machine, dope_dispatch_t dispatch) {
+    require_address(machine, "NULL machine!");
+
+    dope_exec_reset(machine);
+    machine->instructions = 0;
+    machine->line = 0;
+    if (machine->budget.arena_bytes && mem_arena_used(machine->arena) > machine->budget.arena_bytes) {
+        return DOPE_STATUS_MEMORY_LIMIT;
+    }
+    machine->started = dope_exec_clock();
+    if (machine->profile) {
+        return dope_exec_loop_profiled(machine);
+    }
+#if DOPE_EXEC_HAS_THREADED
+    if (dispatch == DOPE_DISPATCH_THREADED) {
+        return dope_exec_loop_threaded(machine);
+    }
+#endif
+    return dope_exec_loop_switch(machine);
+}
+
+void dope_exec_set_budget(dope_machine_t* machine, const dope_budget_t* budget) {
+    require_address(machine, "NULL machine!");
+    if (budget) {
+        machine->budget = *budget;
+    } else {
+        memset(&machine->budget, 0, sizeof(dope_budget_t));
+    }
+}
+
+void dope_exec_set_profile(dope_machine_t* machine, dope_profile_t* profile) {
+    require_address(machine, "NULL machine!");
+    machine->profile = profile;
+}
+
+uint32_t dope_exec_instructions(const dope_machine_t* machine) {
+    require_address(machine, "NULL machine!");
+    return machine->instructions;
+}
+
+uint8_t dope_exec_line(const dope_machine_t* machine) {
+    require_address(machine, "NULL machine!");
+    return machine->line;
+}
+
+const char* dope_exec_status_message(dope_status_t status) {
+    require_range(status < DOPE_STATUS_COUNT, "Unknown run status!");
+    return dope_exec_status_messages[status];
+}
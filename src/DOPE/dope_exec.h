@@ -0,0 +1,155 @@
+/**
+ * @file dope_exec.h
+ * @brief Runs compiled DOPE programs
+ * @defgroup dope_exec DOPE Executor
+ * @{
+ */
+#ifndef DOPE_EXEC_H
+#define DOPE_EXEC_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "dope_profile.h"
+#include "dope_types.h"
+#include "../FILEUTIL/file_source.h"
+#include "../MEM/mem_arena.h"
+
+/**
+ * @brief Why a run stopped
+ */
+typedef enum {
+    DOPE_STATUS_END,                ///< ran past the last line
+    DOPE_STATUS_INPUT_EOF,          ///< J or A with no input left
+    DOPE_STATUS_BAD_INPUT,          ///< J or A read something that is not a number
+    DOPE_STATUS_INSTRUCTION_LIMIT,  ///< ran more instructions than its budget
+    DOPE_STATUS_TIME_LIMIT,         ///< ran longer than its budget
+    DOPE_STATUS_MEMORY_LIMIT,       ///< its arena held more than its budget before it started, or ran out on an input line
+    DOPE_STATUS_COUNT
+} dope_status_t;
+
+/**
+ * @brief Limits of one run, 0 = no limit
+ *
+ * @details Budgets are only looked at on backward branches - T, C or E going to the
+ * same or an earlier line - since a program that never branches back runs each line
+ * at most once. A countdown of back branches is decremented there; only when it runs
+ * out are the instruction count and the clock compared with the budget, and the
+ * countdown refilled so the next check cannot come later than one more pass over the
+ * program past the instruction limit:
+ * @code
+ * | Limit        | Checked                               | Overshoot at most          |
+ * |--------------|---------------------------------------|----------------------------|
+ * | instructions | when the countdown runs out           | one pass over the program  |
+ * | milliseconds | every DOPE_EXEC_METER_INTERVAL back   | that many loop iterations  |
+ * |              | branches                              |                            |
+ * | arena_bytes  | once, when the run starts             | -                          |
+ * @endcode
+ * A run that hits a limit stops on the branching line with the matching status.
+ */
+typedef struct {
+    uint32_t instructions;
+    uint32_t milliseconds;      ///< wall time
+    mem_size_t arena_bytes;     ///< of the machine's arena: program, input and machine state
+} dope_budget_t;
+
+#define DOPE_EXEC_METER_INTERVAL    1024    ///< Back branches between clock reads
+
+/**
+ * @brief Labels-as-values, needed for threaded dispatch: GCC and Clang, not Watcom
+ */
+#if defined(__GNUC__) && !defined(__WATCOMC__)
+#define DOPE_EXEC_HAS_THREADED 1
+#else
+#define DOPE_EXEC_HAS_THREADED 0
+#endif
+
+/**
+ * @brief How the executor gets from one instruction to the next
+ */
+typedef enum {
+    DOPE_DISPATCH_SWITCH,       ///< one switch in a loop, portable C
+    DOPE_DISPATCH_THREADED      ///< computed goto per instruction, switch where unavailable
+} dope_dispatch_t;
+
+/**
+ * @brief Opaque machine: variables, arrays, loop counters and I/O of one program
+ */
+typedef struct private_dope_machine_t dope_machine_t;
+
+/**
+ * @brief Creates a machine for a compiled program
+ * @param arena Arena for the machine state
+ * @param program Compiled program, must outlive the machine
+ * @param input Source J and A read from, one number per line (NULL for none)
+ * @param output Stream P, N and A write to
+ * @return Machine or NULL if the arena is full (see dos_last_error())
+ */
+dope_machine_t* dope_exec_create(mem_arena_t* arena, const dope_program_t* program, file_source_t* input, FILE* output);
+
+/**
+ * @brief Runs the program from its first line with every variable zero
+ * @param machine Machine
+ * @return Why the run stopped
+ *
+ * @details The loop only ever touches the instruction array - no text is split,
+ * no command name compared and no literal parsed while the program runs.
+ * @code
+ * | Command | Operands | Effect                                                       |
+ * |---------|----------|--------------------------------------------------------------|
+ * | C       | a b l1 l2| a < b: go to l1, a == b: go to l2, a > b: next line (0 = next) |
+ * | Z       | n a v    | v = a, then run the lines up to the matching E n times       |
+ * | E       | -        | end of the innermost Z                                       |
+ * | J       | v        | read one number; at end of input the run stops              |
+ * @endcode
+ */
+dope_status_t dope_exec_run(dope_machine_t* machine);
+
+/**
+ * @brief Runs the program with an explicit dispatch loop
+ * @param machine Machine
+ * @param dispatch Loop to use
+ * @return Why the run stopped
+ *
+ * @details dope_exec_run() uses the threaded loop when the build defines
+ * DOPE_THREADED_DISPATCH (CMake option, on by default for host builds) and the
+ * compiler supports it, the switch otherwise. Both give identical results; this
+ * entry point lets benchmarks compare them in one binary.
+ */
+dope_status_t dope_exec_run_dispatch(dope_machine_t* machine, dope_dispatch_t dispatch);
+
+/**
+ * @brief Limits every following run of the machine
+ * @param machine Machine
+ * @param budget Limits, copied; NULL removes them
+ */
+void dope_exec_set_budget(dope_machine_t* machine, const dope_budget_t* budget);
+
+/**
+ * @brief Profiles every following run of the machine
+ * @param machine Machine
+ * @param profile Zeroed profile to add each run to, must outlive the machine; NULL stops profiling
+ *
+ * @details A profiled run always takes its own switch loop, which reads the clock
+ * before every instruction; the other loops have no profiling code in them at all.
+ */
+void dope_exec_set_profile(dope_machine_t* machine, dope_profile_t* profile);
+
+/**
+ * @brief Gets how many instructions the last run executed
+ */
+uint32_t dope_exec_instructions(const dope_machine_t* machine);
+
+/**
+ * @brief Gets the DOPE line number the last run stopped on (0 if it ran past the end)
+ */
+uint8_t dope_exec_line(const dope_machine_t* machine);
+
+/**
+ * @brief Describes a run status
+ */
+const char* dope_exec_status_message(dope_status_t status);
+
+#endif
+
+/** @} */ // end of dope_exec group
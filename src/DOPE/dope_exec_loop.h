@@ -0,0 +1,241 @@
+/*
+ * Dispatch loop template, included by dope_exec.c once per variant - no include guard.
+ *
+ * Before including, define:
+ *   DOPE_LOOP_NAME         name of the static function to generate
+ *   DOPE_LOOP_THREADED     1 for computed goto through machine->handlers, 0 for switch
+ *   DOPE_LOOP_PROFILED     1 to charge each instruction to machine->profile (switch only)
+ *
+ * Every instruction body is written once below; the macros decide how control reaches
+ * the next one. The threaded variant jumps straight from the end of one body to the
+ * next body's label, so each instruction has its own indirect branch for the predictor
+ * to learn, and running past the last line lands on a sentinel handler instead of
+ * being bounds checked on every step.
+ *
+ * Jumps that may go back go through DOPE_BRANCH, the only place the run budget is
+ * looked at (see dope_budget_t): one decrement and test of a countdown per backward
+ * branch, and a call to dope_exec_meter() when it runs out.
+ *
+ * DOPE_PROFILE marks the start of every instruction. In the profiled variant it reads
+ * the clock and charges the time since the last mark to the instruction that ran
+ * then; elsewhere it expands to nothing.
+ */
+
+static dope_status_t DOPE_LOOP_NAME(dope_machine_t* machine) {
+    const dope_program_t* program = machine->program;
+    const dope_instruction_t* code = program->code;
+    double* r = machine->registers;
+    const dope_loop_t* loops = program->loops;
+    const dope_loop_t* loop;
+    uint32_t instructions = 0;
+    uint32_t fuel = 1;                                      // meter on the first back branch
+    uint16_t pc = 0;
+    uint16_t target;
+    dope_status_t status = DOPE_STATUS_END;
+    double a, b;
+#if DOPE_LOOP_PROFILED
+    dope_profile_t* profile = machine->profile;
+    uint64_t then = dope_profile_clock(), now;
+    uint16_t last = UINT16_MAX;                             // nothing ran yet
+#endif
+
+#if DOPE_LOOP_THREADED
+    static const void* const labels[DOPE_OP_COUNT] = {
+        &&op_add, &&op_sub, &&op_mul, &&op_div,
+        &&op_exp, &&op_log, &&op_sin, &&op_sqr,
+        &&op_print, &&op_newline, &&op_input, &&op_ask,
+        &&op_jump, &&op_compare, &&op_loop, &&op_end_loop,
+        &&op_move, &&op_add_compare, &&op_add_jump, &&op_add_print,
+        &&op_add_print_compare, &&op_print_newline
+    };
+    const void** handlers = machine->handlers;
+    if (!handlers[program->count]) {                        // first threaded run: thread the code
+        uint16_t i;
+        for (i = 0; i < program->count; ++i) {
+            handlers[i] = labels[code[i].opcode];
+        }
+        handlers[program->count] = &&op_halt;
+    }
+#define DOPE_DISPATCH()         { ++instructions; goto *handlers[pc]; }
+#define DOPE_CASE(LABEL, OP)    LABEL:
+#else
+#define DOPE_DISPATCH()         continue
+#define DOPE_CASE(LABEL, OP)    case OP:
+#endif
+/* plain blocks, not do { } while (0): the switch variant's continue must reach the for loop */
+#define DOPE_NEXT()             { ++pc; DOPE_DISPATCH(); }
+#define DOPE_GOTO(TARGET)       { pc = (TARGET); DOPE_DISPATCH(); }
+#define DOPE_STOP(STATUS)       { status = (STATUS); goto stop; }
+#define DOPE_METER(AT)          { status = dope_exec_meter(machine, instructions, &fuel); if (status) { pc += (AT); goto stop; } }
+/* AT: which of the lines a superinstruction stands in for branches, so a stop names it */
+#define DOPE_BRANCH_AT(TARGET, AT) { target = (TARGET); if (target <= pc + (AT) && !--fuel) DOPE_METER(AT); DOPE_GOTO(target); }
+#define DOPE_BRANCH(TARGET)     DOPE_BRANCH_AT(TARGET, 0)
+#if DOPE_LOOP_PROFILED
+#if DOPE_LOOP_THREADED
+#error "The profiled loop is a switch loop"
+#endif
+#define DOPE_PROFILE()          { now = dope_profile_clock(); if (last != UINT16_MAX) dope_exec_profile(profile, &code[last], now - then); then = now; last = pc; }
+#else
+#define DOPE_PROFILE()
+#endif
+#define OPS                     (code[pc].operands)
+#define OPS_1                   (code[pc + 1].operands)    // operands of the lines a
+#define OPS_2                   (code[pc + 2].operands)    // superinstruction stands in for
+
+#if DOPE_LOOP_THREADED
+    DOPE_DISPATCH();
+    {
+#else
+    for (;;) {
+        if (pc >= program->count) goto op_halt;
+        ++instructions;
+        DOPE_PROFILE();
+        switch (code[pc].opcode) {
+#endif
+        DOPE_CASE(op_add, DOPE_OP_ADD)
+            r[OPS[2].value] = r[OPS[0].value] + r[OPS[1].value];
+            DOPE_NEXT();
+        DOPE_CASE(op_sub, DOPE_OP_SUB)
+            r[OPS[2].value] = r[OPS[0].value] - r[OPS[1].value];
+            DOPE_NEXT();
+        DOPE_CASE(op_mul, DOPE_OP_MUL)
+            r[OPS[2].value] = r[OPS[0].value] * r[OPS[1].value];
+            DOPE_NEXT();
+        DOPE_CASE(op_div, DOPE_OP_DIV)
+            r[OPS[2].value] = r[OPS[0].value] / r[OPS[1].value];
+            DOPE_NEXT();
+        DOPE_CASE(op_exp, DOPE_OP_EXP)
+            r[OPS[1].value] = exp(r[OPS[0].value]);
+            DOPE_NEXT();
+        DOPE_CASE(op_log, DOPE_OP_LOG)
+            r[OPS[1].value] = log(r[OPS[0].value]);
+            DOPE_NEXT();
+        DOPE_CASE(op_sin, DOPE_OP_SIN)
+            r[OPS[1].value] = sin(r[OPS[0].value]);
+            DOPE_NEXT();
+        DOPE_CASE(op_sqr, DOPE_OP_SQR)
+            r[OPS[1].value] = sqrt(r[OPS[0].value]);
+            DOPE_NEXT();
+        DOPE_CASE(op_print, DOPE_OP_PRINT)
+            dope_exec_print(machine, r[OPS[0].value]);
+            DOPE_NEXT();
+        DOPE_CASE(op_newline, DOPE_OP_NEWLINE)
+            fputc('\n', machine->output);
+            DOPE_NEXT();
+        DOPE_CASE(op_ask, DOPE_OP_ASK)
+            dope_exec_prompt(machine, &OPS[0]);
+            status = dope_exec_read(machine, &r[OPS[1].value]);
+            if (status) {
+                DOPE_STOP(status);
+            }
+            DOPE_NEXT();
+        DOPE_CASE(op_input, DOPE_OP_INPUT)
+            status = dope_exec_read(machine, &r[OPS[0].value]);
+            if (status) {
+                DOPE_STOP(status);
+            }
+            DOPE_NEXT();
+        DOPE_CASE(op_jump, DOPE_OP_JUMP)
+            DOPE_BRANCH(OPS[0].value);
+        DOPE_CASE(op_compare, DOPE_OP_COMPARE)
+            a = r[OPS[0].value];
+            b = r[OPS[1].value];
+            if (a < b) {
+                DOPE_BRANCH(OPS[2].value);
+            }
+            if (a == b) {
+                DOPE_BRANCH(OPS[3].value);
+            }
+            DOPE_NEXT();
+        DOPE_CASE(op_loop, DOPE_OP_LOOP)
+            a = r[OPS[0].value];
+            r[OPS[2].value] = r[OPS[1].value];
+            loop = &loops[OPS[3].value];
+            if (!(a >= 1)) {                                // no iterations: skip the body
+                DOPE_GOTO(loop->exit);
+            }
+            r[loop->counter] = a < (double)UINT32_MAX ? (double)(uint32_t)a : (double)UINT32_MAX;
+            DOPE_NEXT();
+        DOPE_CASE(op_end_loop, DOPE_OP_END_LOOP)
+            loop = &loops[OPS[0].value];
+            if (--r[loop->counter] > 0) {
+                DOPE_BRANCH(loop->body);
+            }
+            DOPE_NEXT();
+        DOPE_CASE(op_move, DOPE_OP_MOVE)
+            r[OPS[1].value] = r[OPS[0].value];
+            DOPE_NEXT();
+        DOPE_CASE(op_add_compare, DOPE_OP_ADD_COMPARE)
+            r[OPS[2].value] = r[OPS[0].value] + r[OPS[1].value];
+            ++instructions;
+            a = r[OPS_1[0].value];
+            b = r[OPS_1[1].value];
+            if (a < b) {
+                DOPE_BRANCH_AT(OPS_1[2].value, 1);
+            }
+            if (a == b) {
+                DOPE_BRANCH_AT(OPS_1[3].value, 1);
+            }
+            DOPE_GOTO(pc + 2);
+        DOPE_CASE(op_add_jump, DOPE_OP_ADD_JUMP)
+            r[OPS[2].value] = r[OPS[0].value] + r[OPS[1].value];
+            ++instructions;
+            DOPE_BRANCH_AT(OPS_1[0].value, 1);
+        DOPE_CASE(op_add_print, DOPE_OP_ADD_PRINT)
+            r[OPS[2].value] = r[OPS[0].value] + r[OPS[1].value];
+            ++instructions;
+            dope_exec_print(machine, r[OPS_1[0].value]);
+            DOPE_GOTO(pc + 2);
+        DOPE_CASE(op_add_print_compare, DOPE_OP_ADD_PRINT_COMPARE)
+            r[OPS[2].value] = r[OPS[0].value] + r[OPS[1].value];
+            dope_exec_print(machine, r[OPS_1[0].value]);
+            instructions += 2;
+            a = r[OPS_2[0].value];
+            b = r[OPS_2[1].value];
+            if (a < b) {
+                DOPE_BRANCH_AT(OPS_2[2].value, 2);
+            }
+            if (a == b) {
+                DOPE_BRANCH_AT(OPS_2[3].value, 2);
+            }
+            DOPE_GOTO(pc + 3);
+        DOPE_CASE(op_print_newline, DOPE_OP_PRINT_NEWLINE)
+            dope_exec_print(machine, r[OPS[0].value]);
+            fputc('\n', machine->output);
+            ++instructions;
+            DOPE_GOTO(pc + 2);
+#if !DOPE_LOOP_THREADED
+        default:
+            ensure(0, "Unknown opcode!");
+        }
+#endif
+    }
+
+op_halt:
+    DOPE_PROFILE();                                         // charge the last instruction
+#if DOPE_LOOP_THREADED
+    --instructions;                                         // the sentinel is not an instruction
+#endif
+    machine->instructions = instructions;
+    machine->line = 0;
+    return DOPE_STATUS_END;
+
+stop:
+    DOPE_PROFILE();
+    machine->instructions = instructions;
+    machine->line = code[pc].line;
+    return status;
+
+#undef DOPE_DISPATCH
+#undef DOPE_CASE
+#undef DOPE_NEXT
+#undef DOPE_GOTO
+#undef DOPE_STOP
+#undef DOPE_METER
+#undef DOPE_BRANCH_AT
+#undef DOPE_BRANCH
+#undef DOPE_PROFILE
+#undef OPS
+#undef OPS_1
+#undef OPS_2
+}
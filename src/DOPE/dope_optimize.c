@@ -0,0 +1,121 @@
+#include "dope_optimize.h"
+#include "../CONTRACT/contract.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+static bool dope_optimize_is_constant(const dope_program_t* program, const dope_operand_t* operand) {
+    return operand->kind == DOPE_OPERAND_REGISTER && operand->value >= program->variable_count;
+}
+
+static double dope_optimize_constant(const dope_program_t* program, const dope_operand_t* operand) {
+    return program->constants[operand->value - program->variable_count];
+}
+
+/**
+ * @brief Finds or adds a folded value in the constant pool
+ * @details New literals go after the existing ones, which are the last registers,
+ *          so no slot already handed out moves.
+ * @return Register slot, or 0xFFFF if the pool is full
+ */
+static uint16_t dope_optimize_register(dope_program_t* program, double value) {
+    uint16_t i;
+    for (i = 0; i < program->constant_count; ++i) {
+        if (memcmp(&program->constants[i], &value, sizeof(double)) == 0) {
+            return program->variable_count + i;
+        }
+    }
+    if (program->constant_count == program->constant_capacity) {
+        return 0xFFFF;
+    }
+    program->constants[program->constant_count++] = value;
+    ++program->register_count;
+    return program->register_count - 1;
+}
+
+/**
+ * @brief Turns an arithmetic line whose sources are all literals into a MOVE
+ */
+static bool dope_optimize_fold(dope_program_t* program, dope_instruction_t* instruction) {
+    dope_operand_t* operands = instruction->operands;
+    uint8_t target = 2;
+    double a, b, value;
+
+    switch (instruction->opcode) {
+        case DOPE_OP_ADD: case DOPE_OP_SUB: case DOPE_OP_MUL: case DOPE_OP_DIV:
+            if (!dope_optimize_is_constant(program, &operands[0]) || !dope_optimize_is_constant(program, &operands[1])) {
+                return false;
+            }
+            a = dope_optimize_constant(program, &operands[0]);
+            b = dope_optimize_constant(program, &operands[1]);
+            value = instruction->opcode == DOPE_OP_ADD ? a + b
+                  : instruction->opcode == DOPE_OP_SUB ? a - b
+                  : instruction->opcode == DOPE_OP_MUL ? a * b : a / b;
+            break;
+        case DOPE_OP_EXP: case DOPE_OP_LOG: case DOPE_OP_SIN: case DOPE_OP_SQR:
+            if (!dope_optimize_is_constant(program, &operands[0])) {
+                return false;
+            }
+            a = dope_optimize_constant(program, &operands[0]);
+            value = instruction->opcode == DOPE_OP_EXP ? exp(a)
+                  : instruction->opcode == DOPE_OP_LOG ? log(a)
+                  : instruction->opcode == DOPE_OP_SIN ? sin(a) : sqrt(a);
+            target = 1;
+            break;
+        default:
+            return false;
+    }
+
+    uint16_t slot = dope_optimize_register(program, value);
+    if (slot == 0xFFFF) {
+        return false;
+    }
+    instruction->opcode = DOPE_OP_MOVE;
+    operands[0].value = slot;
+    operands[1] = operands[target];
+    memset(&operands[2], 0, sizeof(dope_operand_t) * (DOPE_MAX_OPERANDS - 2));
+    return true;
+}
+
+/**
+ * @brief Picks the superinstruction for the sequence starting at an instruction
+ * @return Fused opcode, or the instruction's own opcode if nothing fuses
+ */
+static uint8_t dope_optimize_fuse(const dope_program_t* program, uint16_t i) {
+    const dope_instruction_t* code = program->code;
+    uint8_t next = i + 1 < program->count ? code[i + 1].opcode : DOPE_OP_COUNT;
+    uint8_t after = i + 2 < program->count ? code[i + 2].opcode : DOPE_OP_COUNT;
+
+    switch (code[i].opcode) {
+        case DOPE_OP_ADD:
+            if (next == DOPE_OP_COMPARE) return DOPE_OP_ADD_COMPARE;
+            if (next == DOPE_OP_JUMP) return DOPE_OP_ADD_JUMP;
+            if (next == DOPE_OP_PRINT) return after == DOPE_OP_COMPARE ? DOPE_OP_ADD_PRINT_COMPARE : DOPE_OP_ADD_PRINT;
+            break;
+        case DOPE_OP_PRINT:
+            if (next == DOPE_OP_NEWLINE) return DOPE_OP_PRINT_NEWLINE;
+            break;
+    }
+    return code[i].opcode;
+}
+
+uint16_t dope_optimize(dope_program_t* program) {
+    require_address(program, "NULL program!");
+
+    uint16_t rewritten = 0;
+    uint16_t i;
+    for (i = 0; i < program->count; ++i) {
+        rewritten += dope_optimize_fold(program, &program->code[i]);
+    }
+    /* forwards: each decision reads its followers before they are rewritten themselves,
+       and a fused handler runs its followers' original work whatever their slots become */
+    for (i = 0; i < program->count; ++i) {
+        uint8_t fused = dope_optimize_fuse(program, i);
+        if (fused != program->code[i].opcode) {
+            program->code[i].opcode = fused;
+            ++rewritten;
+        }
+    }
+    return rewritten;
+}
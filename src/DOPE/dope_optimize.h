@@ -0,0 +1,44 @@
+/**
+ * @file dope_optimize.h
+ * @brief Peephole pass over compiled DOPE: constant folding and superinstructions
+ * @defgroup dope_optimize DOPE Optimizer
+ * @{
+ */
+#ifndef DOPE_OPTIMIZE_H
+#define DOPE_OPTIMIZE_H
+
+#include <stdint.h>
+
+#include "dope_types.h"
+
+/**
+ * @brief Folds constant expressions and fuses common line sequences in place
+ * @param program Program from dope_compile()
+ * @return Number of instructions rewritten
+ *
+ * @details DOPE allows one action per line, so a handful of sequences make up most
+ * of what programs execute. The pass rewrites only the opcode of the first line of
+ * such a sequence; its handler then does the work of the following lines too, reading
+ * their operands from their own slots:
+ * @code
+ * | Source                 | Becomes                | Saves                          |
+ * |------------------------|------------------------|--------------------------------|
+ * | 1'+'5'3'A              | MOVE 8 -> A            | the add, at compile time       |
+ * | 2'SQR'16'B             | MOVE 4 -> B            | the sqrt, at compile time      |
+ * | +  then C              | ADD_COMPARE            | one dispatch (increment, test) |
+ * | +  then T              | ADD_JUMP               | one dispatch (loop back)       |
+ * | +  then P              | ADD_PRINT              | one dispatch                   |
+ * | +  then P then C       | ADD_PRINT_COMPARE      | two dispatches                 |
+ * | P  then N              | PRINT_NEWLINE          | one dispatch                   |
+ * @endcode
+ * Every slot keeps its line: a jump into the middle of a fused sequence lands on the
+ * untouched original instruction, so no jump target needs adjusting. The instruction
+ * count of a run is the same with and without the pass.
+ *
+ * @note Folding may add literals to the register file - optimize before dope_exec_create()
+ */
+uint16_t dope_optimize(dope_program_t* program);
+
+#endif
+
+/** @} */ // end of dope_optimize group
@@ -0,0 +1,121 @@
+#include "dope_profile.h"
+#include "../CONTRACT/contract.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char dope_profile_opcode_names[DOPE_OP_COUNT][4] = {
+    "+", "-", "*", "/",
+    "EXP", "LOG", "SIN", "SQR",
+    "P", "N", "J", "A",
+    "T", "C", "Z", "E",
+    "=", "+C", "+T", "+P",
+    "+PC", "PN"
+};
+
+/// Entry being sorted against, qsort() has no context argument
+static const dope_profile_entry_t* dope_profile_sorting;
+
+/**
+ * @brief Orders entry indices by time, then count, most first
+ */
+static int dope_profile_compare(const void* a, const void* b) {
+    const dope_profile_entry_t* x = &dope_profile_sorting[*(const uint8_t*)a];
+    const dope_profile_entry_t* y = &dope_profile_sorting[*(const uint8_t*)b];
+    if (x->nanoseconds != y->nanoseconds) {
+        return x->nanoseconds < y->nanoseconds ? 1 : -1;
+    }
+    if (x->count != y->count) {
+        return x->count < y->count ? 1 : -1;
+    }
+    return (int)*(const uint8_t*)a - (int)*(const uint8_t*)b;
+}
+
+/**
+ * @brief Indices of the entries that ran, most time first
+ * @return Number of indices
+ */
+static uint8_t dope_profile_sort(const dope_profile_entry_t* entries, uint8_t count, uint8_t* order) {
+    uint8_t used = 0;
+    uint8_t i;
+    for (i = 0; i < count; ++i) {
+        if (entries[i].count) {
+            order[used++] = i;
+        }
+    }
+    dope_profile_sorting = entries;
+    qsort(order, used, sizeof(uint8_t), dope_profile_compare);
+    return used;
+}
+
+/**
+ * @brief Writes one sorted table, the first limit rows of it
+ */
+static void dope_profile_table(FILE* stream, const char* heading, const dope_profile_entry_t* entries, uint8_t count, uint8_t limit, bool lines) {
+    uint8_t order[DOPE_LINE_TABLE_SIZE];
+    uint8_t used = dope_profile_sort(entries, count, order);
+    uint64_t total = 0;
+    uint8_t i;
+    for (i = 0; i < used; ++i) {
+        total += entries[order[i]].nanoseconds;
+    }
+    fprintf(stream, "%-6s %10s %12s %6s %9s\n", heading, "count", "ms", "time", "ns/exec");
+    for (i = 0; i < used && i < limit; ++i) {
+        const dope_profile_entry_t* entry = &entries[order[i]];
+        if (lines) {
+            fprintf(stream, "%6u", (unsigned)order[i]);
+        } else {
+            fprintf(stream, "%6s", dope_profile_opcode_name(order[i]));
+        }
+        fprintf(stream, " %10lu %12.3f %5.1f%% %9.1f\n", (unsigned long)entry->count, (double)entry->nanoseconds / 1e6,
+                total ? 100.0 * (double)entry->nanoseconds / (double)total : 0.0, (double)entry->nanoseconds / entry->count);
+    }
+}
+
+uint64_t dope_profile_clock(void) {
+#ifndef __DOS__
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#else
+    return (uint64_t)clock() * (1000000000u / CLOCKS_PER_SEC);
+#endif
+}
+
+const char* dope_profile_opcode_name(uint8_t opcode) {
+    require_range(opcode < DOPE_OP_COUNT, "Unknown opcode!");
+    return dope_profile_opcode_names[opcode];
+}
+
+void dope_profile_report(const dope_profile_t* profile, FILE* stream) {
+    require_address(profile, "NULL profile!");
+    require_address(stream, "NULL stream!");
+
+    dope_profile_table(stream, "line", profile->lines, DOPE_LINE_TABLE_SIZE, DOPE_PROFILE_HOT_LINES, true);
+    dope_profile_table(stream, "op", profile->opcodes, DOPE_OP_COUNT, DOPE_OP_COUNT, false);
+}
+
+bool dope_profile_csv(const dope_profile_t* profile, const char* path_name) {
+    require_address(profile, "NULL profile!");
+    require_address(path_name, "NULL path name!");
+
+    FILE* csv = fopen(path_name, "w");
+    if (!csv) {
+        return false;
+    }
+    fprintf(csv, "kind,key,count,nanoseconds\n");
+    uint8_t i;
+    for (i = 0; i < DOPE_LINE_TABLE_SIZE; ++i) {
+        if (profile->lines[i].count) {
+            fprintf(csv, "line,%u,%lu,%.0f\n", (unsigned)i, (unsigned long)profile->lines[i].count, (double)profile->lines[i].nanoseconds);
+        }
+    }
+    for (i = 0; i < DOPE_OP_COUNT; ++i) {
+        if (profile->opcodes[i].count) {
+            fprintf(csv, "opcode,%s,%lu,%.0f\n", dope_profile_opcode_name(i), (unsigned long)profile->opcodes[i].count, (double)profile->opcodes[i].nanoseconds);
+        }
+    }
+    bool written = !ferror(csv);
+    return fclose(csv) == 0 && written;
+}
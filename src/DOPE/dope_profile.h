@@ -0,0 +1,76 @@
+/**
+ * @file dope_profile.h
+ * @brief Where a DOPE run spends its time: counts and nanoseconds per line and per opcode
+ * @defgroup dope_profile DOPE Profiler
+ * @{
+ */
+#ifndef DOPE_PROFILE_H
+#define DOPE_PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "dope_constants.h"
+#include "dope_types.h"
+
+#define DOPE_PROFILE_HOT_LINES  10      ///< Lines in the report, hottest first
+
+/**
+ * @brief Executions of one line or opcode and the time they took
+ */
+typedef struct {
+    uint32_t count;
+    uint64_t nanoseconds;
+} dope_profile_entry_t;
+
+/**
+ * @brief Accumulated over every profiled run of a machine (see dope_exec_set_profile())
+ *
+ * @details Each instruction is charged the time from its own start to the start of
+ * the next one, so a J or A waiting for input is charged the wait. The clock is read
+ * once per instruction and costs far more than a DOPE instruction, so absolute times
+ * are inflated; the shares between lines are what the profile is for. Profile an
+ * unoptimized program: a superinstruction is charged to the first line it stands for.
+ */
+typedef struct {
+    dope_profile_entry_t lines[DOPE_LINE_TABLE_SIZE];   ///< By DOPE line number 1-99
+    dope_profile_entry_t opcodes[DOPE_OP_COUNT];
+} dope_profile_t;
+
+/**
+ * @brief Reads the profiling clock
+ * @return Nanoseconds from an arbitrary start; BIOS timer ticks (55 ms) under DOS
+ */
+uint64_t dope_profile_clock(void);
+
+/**
+ * @brief Gets the command spelling of an opcode ("+", "SIN", "T"; "+T" for superinstructions)
+ */
+const char* dope_profile_opcode_name(uint8_t opcode);
+
+/**
+ * @brief Writes the hottest lines and every opcode used, most time first
+ * @param profile Profile
+ * @param stream Stream to write to
+ *
+ * @details
+ * @code
+ * line      count        ms   time   ns/exec
+ *    2    1000000    41.250  58.3%      41.2
+ *    1    1000001    29.500  41.7%      29.5
+ * @endcode
+ */
+void dope_profile_report(const dope_profile_t* profile, FILE* stream);
+
+/**
+ * @brief Writes every line and opcode that ran as CSV: kind, key, count, nanoseconds
+ * @param profile Profile
+ * @param path_name CSV file, replaced if it exists
+ * @return false if the file cannot be written
+ */
+bool dope_profile_csv(const dope_profile_t* profile, const char* path_name);
+
+#endif
+
+/** @} */ // end of dope_profile group
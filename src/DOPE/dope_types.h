@@ -1,4 +1,104 @@
 #ifndef DOPE_TYPES_H
 #define DOPE_TYPES_H
 
+#include <stdint.h>
+
+#include "dope_constants.h"
+
+/**
+ * @brief Operations, one per DOPE command
+ */
+typedef enum {
+    DOPE_OP_ADD,            // +'a'b'c      c = a + b
+    DOPE_OP_SUB,            // -'a'b'c      c = a - b
+    DOPE_OP_MUL,            // *'a'b'c      c = a * b
+    DOPE_OP_DIV,            // /'a'b'c      c = a / b
+    DOPE_OP_EXP,            // EXP'a'b      b = e^a
+    DOPE_OP_LOG,            // LOG'a'b      b = ln a
+    DOPE_OP_SIN,            // SIN'a'b      b = sin a
+    DOPE_OP_SQR,            // SQR'a'b      b = sqrt a
+    DOPE_OP_PRINT,          // P'a          print a and a space
+    DOPE_OP_NEWLINE,        // N            print a newline
+    DOPE_OP_INPUT,          // J'a          read a number into a
+    DOPE_OP_ASK,            // A'text'a     print text, read a number into a
+    DOPE_OP_JUMP,           // T'l          go to line l
+    DOPE_OP_COMPARE,        // C'a'b'l1'l2  a < b: go to l1, a == b: go to l2, else next line
+    DOPE_OP_LOOP,           // Z'n'a'v      v = a, run the lines up to the matching E n times (operand 3: frame)
+    DOPE_OP_END_LOOP,       // E            end of the innermost Z (operand 0: frame)
+    DOPE_OP_SOURCE_COUNT,   // opcodes below only come from dope_optimize()
+    DOPE_OP_MOVE = DOPE_OP_SOURCE_COUNT,    // b = a, a folded constant expression
+    DOPE_OP_ADD_COMPARE,    // + then C
+    DOPE_OP_ADD_JUMP,       // + then T
+    DOPE_OP_ADD_PRINT,      // + then P
+    DOPE_OP_ADD_PRINT_COMPARE, // + then P then C
+    DOPE_OP_PRINT_NEWLINE,  // P then N
+    DOPE_OP_COUNT
+} dope_opcode_t;
+
+typedef enum {
+    DOPE_OPERAND_NONE,
+    DOPE_OPERAND_CONSTANT,  // value: constant pool index (only while compiling)
+    DOPE_OPERAND_VARIABLE,  // letter: 0-25, value: suffix 0-9 or DOPE_NO_SUFFIX (only while compiling)
+    DOPE_OPERAND_LINE,      // value: line number, 0 = next line (only while compiling)
+    DOPE_OPERAND_REGISTER,  // value: register file slot
+    DOPE_OPERAND_TARGET,    // value: instruction index to continue at
+    DOPE_OPERAND_TEXT,      // value: text pool offset, letter: length
+    DOPE_OPERAND_LOOP       // value: loop frame index
+} dope_operand_kind_t;
+
+typedef struct {
+    uint8_t kind;
+    uint8_t letter;
+    uint16_t value;
+} dope_operand_t;
+
+/**
+ * @brief One compiled source line
+ */
+typedef struct {
+    uint8_t opcode;
+    uint8_t line;           ///< DOPE line number
+    dope_operand_t operands[DOPE_MAX_OPERANDS];
+} dope_instruction_t;
+
+/**
+ * @brief Z/E pair matched at compile time
+ * @details Z loads the counter and E counts it down, so an iteration costs one
+ *          decrement, one compare and one branch - nothing is searched at run time.
+ */
+typedef struct {
+    uint16_t counter;       ///< Register holding the iterations left
+    uint16_t body;          ///< Instruction after the Z, where E loops back to
+    uint16_t exit;          ///< Instruction after the E, where a Z with no iterations goes
+} dope_loop_t;
+
+/**
+ * @brief Compiled program, instructions in line number order
+ *
+ * @details Every value operand is a slot in one flat register file:
+ * @code
+ * | Slots                          | Holds                                   |
+ * |--------------------------------|-----------------------------------------|
+ * | 0 .. scalar_count-1            | scalars, in order of first use          |
+ * | ..                             | used arrays, DOPE_ARRAY_SIZE slots each |
+ * | .. variable_count-1            | loop counters, one per Z                |
+ * | .. register_count-1            | literals, initialised from constants    |
+ * @endcode
+ */
+typedef struct {
+    dope_instruction_t* code;
+    uint16_t count;
+    double* constants;      ///< Literal pool, copied into the register file after the variables
+    uint16_t constant_count;
+    uint16_t constant_capacity; ///< Room dope_optimize() may fold into
+    uint16_t scalar_count;
+    uint16_t variable_count; ///< Scalar, array and loop counter slots, zeroed before each run
+    uint16_t register_count;
+    char* text;             ///< A prompts, not NUL terminated
+    uint16_t text_size;
+    uint8_t lines[DOPE_LINE_TABLE_SIZE]; ///< Line number to instruction index, DOPE_NO_LINE if absent
+    dope_loop_t* loops;     ///< One frame per Z, in line order
+    uint8_t loop_count;
+} dope_program_t;
+
 #endif
@@ -0,0 +1,492 @@
+/**
+ * @file test_dope.h
+ * @brief Test suite for the DOPE compiler and executor
+ * @ingroup tdd_framework
+ */
+#ifndef TEST_DOPE_H
+#define TEST_DOPE_H
+
+#include "dope_batch.h"
+#include "dope_cache.h"
+#include "dope_compile.h"
+#include "dope_exec.h"
+#include "dope_optimize.h"
+#include "../TDD/tdd_macros.h"
+#include "../DOS/dos_services_files.h"
+#include "../FILEUTIL/file_line_stream.h"
+#include "../FILEUTIL/file_source.h"
+#include "../MEM/mem_arena.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define DOPE_TESTS &test_dope_compile_errors,               \
+    &test_dope_loop_count_below_one,                        \
+    &test_dope_fused_matches_unfused,                       \
+    &test_dope_cache_invalidation,                          \
+    &test_dope_cache_corruption,                            \
+    &test_dope_budget_statuses,                             \
+    &test_dope_batch_manifest
+
+#define TEST_DOPE_ARENA_SIZE    (MEM_SIZE_32K)
+#define TEST_DOPE_OUTPUT_SIZE   256
+#define TEST_DOPE_SOURCE        "TSTCACHE.DOP"  /* scratch files in the current directory */
+#define TEST_DOPE_CACHE         "TSTCACHE.DPC"
+#define TEST_DOPE_CACHE_SIZE    4096
+#define TEST_DOPE_MANIFEST      "./TSTBATCH.LST"
+#define TEST_DOPE_SUMMARY       "TSTBATCH.CSV"
+
+/* ----------------- Helpers ----------------- */
+
+/**
+ * @brief Compiles program text held in memory
+ */
+static dope_program_t* test_dope_compile(mem_arena_t* arena, const char* text, dope_diagnostic_t* diagnostic) {
+    file_source_t* source = file_source_memory(arena, text, (uint32_t)strlen(text));
+    file_line_stream_t* lines = source ? file_line_stream_create(arena, source) : NULL;
+    if (!lines) {
+        return NULL;
+    }
+    dope_program_t* program = dope_compile(arena, lines, diagnostic);
+    file_line_stream_close(lines);
+    return program;
+}
+
+/**
+ * @brief Runs a program on input held in memory and collects what it printed
+ * @return Why the run stopped, DOPE_STATUS_COUNT if it could not start
+ */
+static dope_status_t test_dope_run(mem_arena_t* arena, const dope_program_t* program, const char* input, char* output,
+                                   dope_dispatch_t dispatch) {
+    output[0] = '\0';
+    FILE* stream = tmpfile();
+    if (!stream) {
+        return DOPE_STATUS_COUNT;
+    }
+    file_source_t* source = file_source_memory(arena, input, (uint32_t)strlen(input));
+    dope_machine_t* machine = source ? dope_exec_create(arena, program, source, stream) : NULL;
+    if (!machine) {
+        fclose(stream);
+        return DOPE_STATUS_COUNT;
+    }
+    dope_status_t status = dope_exec_run_dispatch(machine, dispatch);
+    rewind(stream);
+    size_t length = fread(output, 1, TEST_DOPE_OUTPUT_SIZE - 1, stream);
+    output[length] = '\0';
+    fclose(stream);
+    return status;
+}
+
+/**
+ * @brief Replaces a file with the given bytes
+ */
+static int test_dope_write(const char* path_name, const char* data, size_t nbytes) {
+    FILE* file = fopen(path_name, "wb");
+    if (!file) {
+        return 0;
+    }
+    size_t written = fwrite(data, 1, nbytes, file);
+    return fclose(file) == 0 && written == nbytes;
+}
+
+/**
+ * @brief Reads a whole text file into buffer, "" if it cannot
+ */
+static void test_dope_read(const char* path_name, char* buffer, size_t capacity) {
+    buffer[0] = '\0';
+    FILE* file = fopen(path_name, "r");
+    if (file) {
+        size_t length = fread(buffer, 1, capacity - 1, file);
+        buffer[length] = '\0';
+        fclose(file);
+    }
+}
+
+/**
+ * @brief Loads a cache or compiles, runs the program and frees what it took
+ */
+static dope_status_t test_dope_open_run(mem_arena_t* arena, char* output) {
+    dope_diagnostic_t diagnostic;
+    mem_size_t used = mem_arena_used(arena);
+    dope_program_t* program = dope_cache_open(arena, TEST_DOPE_SOURCE, &diagnostic);
+    dope_status_t status = program ? test_dope_run(arena, program, "", output, DOPE_DISPATCH_SWITCH) : DOPE_STATUS_COUNT;
+    mem_arena_dealloc(arena, mem_arena_used(arena) - used);
+    return status;
+}
+
+/**
+ * @brief Tells whether the cache loads, freeing what it took
+ */
+static int test_dope_cache_loads(mem_arena_t* arena) {
+    mem_size_t used = mem_arena_used(arena);
+    int loaded = dope_cache_load(arena, TEST_DOPE_SOURCE) != NULL;
+    mem_arena_dealloc(arena, mem_arena_used(arena) - used);
+    return loaded;
+}
+
+/* ----------------- Compiler Tests ----------------- */
+
+/**
+ * @brief Compile error tests
+ * @details Each source must fail with its error on its source line:
+ * - line numbers outside 1-99 and line numbers used twice
+ * - unknown commands and wrong operand counts
+ * - jumps to lines the program does not have
+ * - E without Z, Z without E, and a surplus E after nested loops
+ * - a source with no program lines
+ * A source ending in a DOS Ctrl-Z compiles, whatever follows the Ctrl-Z.
+ */
+TEST(test_dope_compile_errors)
+{
+    static const struct {
+        const char* source;
+        dope_compile_error_t error;
+        uint32_t source_line;
+    } cases[] = {
+        { "0'P'1\n",                                        DOPE_COMPILE_BAD_LINE_NUMBER,   1 },
+        { "1'P'1\n\n3'P'1\n3'N\n",                          DOPE_COMPILE_DUPLICATE_LINE,    4 },
+        { "1'Q'1\n",                                        DOPE_COMPILE_UNKNOWN_COMMAND,   1 },
+        { "1'P\n",                                          DOPE_COMPILE_OPERAND_COUNT,     1 },
+        { "1'+'A'1\n",                                      DOPE_COMPILE_OPERAND_COUNT,     1 },
+        { "1'T'9\n",                                        DOPE_COMPILE_UNDEFINED_LINE,    1 },
+        { "1'C'A'0'2'9\n2'N\n",                             DOPE_COMPILE_UNDEFINED_LINE,    1 },
+        { "1'E\n",                                          DOPE_COMPILE_UNMATCHED_LOOP,    1 },
+        { "1'Z'2'1'I\n2'P'I\n",                             DOPE_COMPILE_UNMATCHED_LOOP,    1 },
+        { "1'Z'1'1'I\n2'Z'1'1'J\n3'E\n4'E\n5'E\n",          DOPE_COMPILE_UNMATCHED_LOOP,    5 },
+        { "# only a comment\n",                             DOPE_COMPILE_EMPTY,             0 }
+    };
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_DOPE_ARENA_SIZE);
+    ASSERT(arena != NULL);
+
+    uint8_t i;
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        dope_diagnostic_t diagnostic;
+        mem_size_t used = mem_arena_used(arena);
+        EXPECT(test_dope_compile(arena, cases[i].source, &diagnostic) == NULL);
+        EXPECT(diagnostic.error == cases[i].error);
+        EXPECT(diagnostic.source_line == cases[i].source_line);
+        V(printf("%u: %s\n", (unsigned)diagnostic.source_line, dope_compile_message(diagnostic.error)););
+        mem_arena_dealloc(arena, mem_arena_used(arena) - used);
+    }
+
+    /* Comments, blank lines and out of order lines are fine, and a Ctrl-Z ends the source */
+    dope_diagnostic_t diagnostic;
+    EXPECT(test_dope_compile(arena, "# header\n\n2'N\n1'P'1 # first\n", &diagnostic) != NULL);
+    EXPECT(diagnostic.error == DOPE_COMPILE_OK);
+    EXPECT(test_dope_compile(arena, "1'P'1\r\n\x1A", &diagnostic) != NULL);
+    EXPECT(diagnostic.error == DOPE_COMPILE_OK);
+    EXPECT(test_dope_compile(arena, "1'P'1\x1A" "0'Q\r\n", &diagnostic) != NULL);
+    EXPECT(diagnostic.error == DOPE_COMPILE_OK);
+
+    mem_arena_delete(arena);
+}
+
+/**
+ * @brief Z with a count below 1 skips its body
+ * @details A count of 0 or less runs none of the lines up to the matching E, while
+ *          a count of 3 runs them three times.
+ */
+TEST(test_dope_loop_count_below_one)
+{
+    static const struct {
+        const char* source;
+        const char* output;
+    } cases[] = {
+        { "1'Z'0'1'I\n2'P'I\n3'E\n4'P'99\n",                "99 " },
+        { "1'Z'-2'1'I\n2'P'I\n3'E\n4'P'7\n",                "7 " },
+        { "1'Z'3'1'I\n2'P'I\n3'E\n4'P'7\n",                 "1 1 1 7 " }
+    };
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_DOPE_ARENA_SIZE);
+    ASSERT(arena != NULL);
+
+    uint8_t i;
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        dope_diagnostic_t diagnostic;
+        char output[TEST_DOPE_OUTPUT_SIZE];
+        dope_program_t* program = test_dope_compile(arena, cases[i].source, &diagnostic);
+        ASSERT(program != NULL);
+        EXPECT(test_dope_run(arena, program, "", output, DOPE_DISPATCH_SWITCH) == DOPE_STATUS_END);
+        EXPECT(strcmp(output, cases[i].output) == 0);
+    }
+
+    mem_arena_delete(arena);
+}
+
+/* ----------------- Optimizer Tests ----------------- */
+
+/**
+ * @brief Folded and fused programs print exactly what the plain ones print
+ * @details The programs between them fold literal arithmetic and use every
+ *          superinstruction: +C, +T, +P, +PC and PN. Each optimized program
+ *          runs under both dispatch loops and must stop the same way.
+ */
+TEST(test_dope_fused_matches_unfused)
+{
+    static const struct {
+        const char* source;
+        const char* input;
+    } cases[] = {
+        { "1'+'I'1'I\n2'P'I\n3'C'I'5'1'4\n4'N\n"                       /* +PC, PN */
+          "5'+'2'3'K\n6'+'A'K'A\n7'C'A'20'6'8\n8'T'9\n9'P'A\n"          /* fold, +C */
+          "10'+'B'1'B\n11'T'13\n12'P'0\n13'P'B\n"                      /* +T */
+          "14'SQR'16'X\n15'P'X\n16'+'X'1'Y\n17'P'Y\n18'N\n",            /* fold, +P, PN */
+          "" },
+        { "1'J'A\n2'*'A'A'B\n3'+'B'1'B\n4'P'B\n5'N\n6'T'1\n",          /* +P, PN, ends on input */
+          "2\n3\n" }
+    };
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_DOPE_ARENA_SIZE);
+    ASSERT(arena != NULL);
+
+    uint8_t i;
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        dope_diagnostic_t diagnostic;
+        char plain_output[TEST_DOPE_OUTPUT_SIZE];
+        char fused_output[TEST_DOPE_OUTPUT_SIZE];
+        dope_program_t* plain = test_dope_compile(arena, cases[i].source, &diagnostic);
+        dope_program_t* fused = test_dope_compile(arena, cases[i].source, &diagnostic);
+        ASSERT(plain != NULL && fused != NULL);
+        EXPECT(dope_optimize(fused) > 0);
+
+        dope_status_t status = test_dope_run(arena, plain, cases[i].input, plain_output, DOPE_DISPATCH_SWITCH);
+        EXPECT(status != DOPE_STATUS_COUNT);
+        V(printf("%s", plain_output););
+        EXPECT(test_dope_run(arena, fused, cases[i].input, fused_output, DOPE_DISPATCH_SWITCH) == status);
+        EXPECT(strcmp(plain_output, fused_output) == 0);
+        EXPECT(test_dope_run(arena, fused, cases[i].input, fused_output, DOPE_DISPATCH_THREADED) == status);
+        EXPECT(strcmp(plain_output, fused_output) == 0);
+    }
+
+    mem_arena_delete(arena);
+}
+
+/* ----------------- Cache Tests ----------------- */
+
+/**
+ * @brief A cache is used while its source is unchanged and replaced when it changes
+ * @details Verifies:
+ * - There is nothing to load before the first open
+ * - The first open compiles and saves a cache that then loads
+ * - Editing the source, even to the same size, makes the cache stale
+ * - The next open runs the edited program and saves a current cache
+ */
+TEST(test_dope_cache_invalidation)
+{
+    static const char* sources[] = { "1'P'1\n2'N\n", "1'P'2\n2'N\n", "1'P'3\n2'P'4\n3'N\n" };
+    static const char* outputs[] = { "1 \n", "2 \n", "3 4 \n" };
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_DOPE_ARENA_SIZE);
+    ASSERT(arena != NULL);
+    dos_delete_file(TEST_DOPE_CACHE);
+
+    uint8_t i;
+    for (i = 0; i < sizeof(sources) / sizeof(sources[0]); ++i) {
+        char output[TEST_DOPE_OUTPUT_SIZE];
+        ASSERT(test_dope_write(TEST_DOPE_SOURCE, sources[i], strlen(sources[i])));
+        EXPECT(!test_dope_cache_loads(arena));
+        EXPECT(test_dope_open_run(arena, output) == DOPE_STATUS_END);
+        EXPECT(strcmp(output, outputs[i]) == 0);
+        EXPECT(test_dope_cache_loads(arena));
+        EXPECT(test_dope_open_run(arena, output) == DOPE_STATUS_END);
+        EXPECT(strcmp(output, outputs[i]) == 0);
+    }
+
+    dos_delete_file(TEST_DOPE_CACHE);
+    dos_delete_file(TEST_DOPE_SOURCE);
+    mem_arena_delete(arena);
+}
+
+/**
+ * @brief A damaged cache is never run
+ * @details Flips a byte in the header, the first body byte and the last body byte,
+ *          and cuts the last byte off. Each damaged cache must be refused, leaving
+ *          the arena as it was, and the next open must compile the source again
+ *          and run it correctly.
+ */
+TEST(test_dope_cache_corruption)
+{
+    static const char source[] = "1'Z'3'1'I\n2'+'A'I'A\n3'E\n4'P'A\n5'N\n";
+    static char cache[TEST_DOPE_CACHE_SIZE];
+    static char damaged[TEST_DOPE_CACHE_SIZE];
+    char output[TEST_DOPE_OUTPUT_SIZE];
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_DOPE_ARENA_SIZE);
+    ASSERT(arena != NULL);
+    dos_delete_file(TEST_DOPE_CACHE);
+    ASSERT(test_dope_write(TEST_DOPE_SOURCE, source, sizeof(source) - 1));
+    EXPECT(test_dope_open_run(arena, output) == DOPE_STATUS_END);
+
+    FILE* file = fopen(TEST_DOPE_CACHE, "rb");
+    ASSERT(file != NULL);
+    size_t size = fread(cache, 1, sizeof(cache), file);
+    fclose(file);
+    ASSERT(size > sizeof(dope_cache_header_t) && size < sizeof(cache));
+
+    const size_t offsets[] = { 8, sizeof(dope_cache_header_t), size - 1 };
+    uint8_t i;
+    for (i = 0; i < sizeof(offsets) / sizeof(offsets[0]); ++i) {
+        memcpy(damaged, cache, size);
+        damaged[offsets[i]] ^= 0x5A;
+        ASSERT(test_dope_write(TEST_DOPE_CACHE, damaged, size));
+        ASSERT(mem_arena_alloc(arena, 1) != NULL);    /* the body then needs alignment padding */
+        mem_size_t used = mem_arena_used(arena);
+        EXPECT(dope_cache_load(arena, TEST_DOPE_SOURCE) == NULL);
+        EXPECT(mem_arena_used(arena) == used);
+        mem_arena_dealloc(arena, 1);
+        EXPECT(test_dope_open_run(arena, output) == DOPE_STATUS_END);
+        EXPECT(strcmp(output, "3 \n") == 0);
+    }
+
+    ASSERT(test_dope_write(TEST_DOPE_CACHE, cache, size - 1));
+    EXPECT(!test_dope_cache_loads(arena));
+    ASSERT(test_dope_write(TEST_DOPE_CACHE, cache, size));
+    EXPECT(test_dope_cache_loads(arena));
+
+    dos_delete_file(TEST_DOPE_CACHE);
+    dos_delete_file(TEST_DOPE_SOURCE);
+    mem_arena_delete(arena);
+}
+
+/* ----------------- Budget Tests ----------------- */
+
+/**
+ * @brief Every way a run stops, and the line it stops on
+ * @details Endless T, C and E loops stop on their branching line once they pass
+ *          an instruction or time budget, overshooting the instruction budget by
+ *          no more than one pass over the program. An arena budget smaller than
+ *          the program stops the run before line 1. Input that runs out or is not
+ *          a number stops on the J that read it, and with no budget a finite
+ *          program runs to the end.
+ */
+TEST(test_dope_budget_statuses)
+{
+    static const struct {
+        const char* source;
+        const char* input;
+        dope_budget_t budget;
+        dope_status_t status;
+        uint8_t line;
+    } cases[] = {
+        { "1'+'A'1'A\n2'T'1\n",                       "",     { 1000, 0, 0 },  DOPE_STATUS_INSTRUCTION_LIMIT, 2 },
+        { "1'+'A'1'A\n2'C'A'1000000'1'0\n",           "",     { 1000, 0, 0 },  DOPE_STATUS_INSTRUCTION_LIMIT, 2 },
+        { "1'Z'1000000'1'I\n2'+'A'1'A\n3'E\n",        "",     { 1000, 0, 0 },  DOPE_STATUS_INSTRUCTION_LIMIT, 3 },
+        { "1'+'A'1'A\n2'T'1\n",                       "",     { 0, 50, 0 },    DOPE_STATUS_TIME_LIMIT,        2 },
+        { "1'P'1\n",                                   "",     { 0, 0, 16 },    DOPE_STATUS_MEMORY_LIMIT,      0 },
+        { "1'J'A\n2'P'A\n",                           "",     { 0, 0, 0 },     DOPE_STATUS_INPUT_EOF,         1 },
+        { "1'J'A\n2'P'A\n",                           "x\n",  { 0, 0, 0 },     DOPE_STATUS_BAD_INPUT,         1 },
+        { "1'Z'5'1'I\n2'+'A'1'A\n3'E\n4'P'A\n",       "",     { 0, 0, 0 },     DOPE_STATUS_END,               0 }
+    };
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_DOPE_ARENA_SIZE);
+    ASSERT(arena != NULL);
+
+    uint8_t i;
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        dope_diagnostic_t diagnostic;
+        mem_size_t used = mem_arena_used(arena);
+        dope_program_t* program = test_dope_compile(arena, cases[i].source, &diagnostic);
+        ASSERT(program != NULL);
+        FILE* stream = tmpfile();
+        ASSERT(stream != NULL);
+        file_source_t* input = file_source_memory(arena, cases[i].input, (uint32_t)strlen(cases[i].input));
+        dope_machine_t* machine = input ? dope_exec_create(arena, program, input, stream) : NULL;
+        ASSERT(machine != NULL);
+        dope_exec_set_budget(machine, &cases[i].budget);
+
+        EXPECT(dope_exec_run(machine) == cases[i].status);
+        EXPECT(dope_exec_line(machine) == cases[i].line);
+        V(printf("Line %u: %s after %lu instructions\n", (unsigned)dope_exec_line(machine),
+                 dope_exec_status_message(cases[i].status), (unsigned long)dope_exec_instructions(machine)););
+        if (cases[i].status == DOPE_STATUS_INSTRUCTION_LIMIT) {
+            EXPECT(dope_exec_instructions(machine) >= cases[i].budget.instructions);
+            EXPECT(dope_exec_instructions(machine) <= cases[i].budget.instructions + program->count + 1);
+        }
+        fclose(stream);
+        mem_arena_dealloc(arena, mem_arena_used(arena) - used);
+    }
+
+    mem_arena_delete(arena);
+}
+
+/* ----------------- Batch Tests ----------------- */
+
+/**
+ * @brief A manifest batch runs every job and reports each in job order
+ * @details The manifest has comments, a blank line and paths relative to it. Its jobs:
+ * - TSTB1.DOP reads TSTB1.ANS and writes TSTB1.OUT
+ * - TSTB2.DOP does not compile: the summary names the compile error and its line
+ * - TSTB3.DOP writes TSTB3.TXT and loops until the instruction budget stops it
+ * - TSTB4.DOP does not exist
+ * Two workers run the batch, and the summary rows must match the results.
+ */
+TEST(test_dope_batch_manifest)
+{
+    static const char* files[][2] = {
+        { "TSTB1.DOP", "1'J'A\n2'P'A\n" },
+        { "TSTB1.ANS", "42\n" },
+        { "TSTB2.DOP", "1'P'1\n\n3'Q'1\n" },
+        { "TSTB3.DOP", "1'+'A'1'A\n2'T'1\n" },
+        { TEST_DOPE_MANIFEST, "# test batch\nTSTB1.DOP,TSTB1.ANS\n\nTSTB2.DOP   # compile error\n"
+                              "TSTB3.DOP,,TSTB3.TXT\nTSTB4.DOP\n" }
+    };
+    static const char* removed[] = {
+        "TSTB1.DOP", "TSTB1.ANS", "TSTB1.DPC", "TSTB1.OUT", "TSTB2.DOP", "TSTB2.OUT",
+        "TSTB3.DOP", "TSTB3.DPC", "TSTB3.TXT", "TSTB4.OUT", TEST_DOPE_MANIFEST, TEST_DOPE_SUMMARY
+    };
+    static const char* rows[] = {
+        "program,answers,output,result,line,instructions\n",
+        "./TSTB1.DOP,./TSTB1.ANS,./TSTB1.OUT,End of program,0,2\n",
+        "./TSTB2.DOP,,./TSTB2.OUT,Unknown command,3,0\n",
+        "./TSTB3.DOP,,./TSTB3.TXT,Instruction limit reached,2,",
+        "./TSTB4.DOP,,./TSTB4.OUT,File not found,0,0\n"
+    };
+    static char summary[TEST_DOPE_CACHE_SIZE];
+    const dope_budget_t budget = { 1000, 0, 0 };
+    uint8_t i;
+    for (i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
+        ASSERT(test_dope_write(files[i][0], files[i][1], strlen(files[i][1])));
+    }
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_DOPE_ARENA_SIZE);
+    ASSERT(arena != NULL);
+
+    dope_batch_job_t* jobs;
+    uint16_t count = dope_batch_manifest(arena, TEST_DOPE_MANIFEST, &jobs);
+    ASSERT(count == 4);
+    EXPECT(strcmp(jobs[0].program, "./TSTB1.DOP") == 0);
+    EXPECT(strcmp(jobs[0].answers, "./TSTB1.ANS") == 0);
+    EXPECT(strcmp(jobs[0].output, "./TSTB1.OUT") == 0);
+    EXPECT(jobs[1].answers == NULL);
+    EXPECT(strcmp(jobs[2].output, "./TSTB3.TXT") == 0);
+
+    dope_batch_t* batch = dope_batch_create(arena, 2, TEST_DOPE_ARENA_SIZE);
+    dope_batch_set_budget(batch, &budget);
+    dope_batch_result_t* results = dope_batch_run(batch, jobs, count);
+    for (i = 0; i < count; ++i) {
+        EXPECT(results[i].job == &jobs[i]);
+    }
+    EXPECT(results[0].status == DOPE_STATUS_END);
+    EXPECT(results[1].error == DOPE_COMPILE_UNKNOWN_COMMAND && results[1].err_code == DOS_SUCCESS);
+    EXPECT(results[1].source_line == 3);
+    EXPECT(results[2].status == DOPE_STATUS_INSTRUCTION_LIMIT && results[2].line == 2);
+    EXPECT(results[3].error == DOPE_COMPILE_UNREADABLE && results[3].err_code == DOS_FILE_NOT_FOUND);
+
+    char output[TEST_DOPE_OUTPUT_SIZE];
+    test_dope_read("TSTB1.OUT", output, sizeof(output));
+    EXPECT(strcmp(output, "42 ") == 0);
+
+    ASSERT(dope_batch_summary(results, count, TEST_DOPE_SUMMARY));
+    test_dope_read(TEST_DOPE_SUMMARY, summary, sizeof(summary));
+    V(printf("%s", summary););
+    const char* row = summary;
+    for (i = 0; i < sizeof(rows) / sizeof(rows[0]); ++i) {
+        EXPECT(strncmp(row, rows[i], strlen(rows[i])) == 0);
+        row = strchr(row, '\n');
+        ASSERT(row != NULL);
+        ++row;
+    }
+    EXPECT(*row == '\0');
+
+    dope_batch_delete(batch);
+    mem_arena_delete(arena);
+    for (i = 0; i < sizeof(removed) / sizeof(removed[0]); ++i) {
+        dos_delete_file(removed[i]);
+    }
+}
+
+#endif
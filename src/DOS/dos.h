@@ -2,6 +2,7 @@
 #define DOS_H
 
 #include "dos_error_messages.h"
+#include "dos_last_error.h"
 #include "dos_services.h"
 #include "dos_services_constants.h"
 #include "dos_services_types.h"
@@ -32,7 +32,12 @@ typedef enum {
     DOS_INVALID_DRIVE_SPECIFIED,
     DOS_ATTEMPT_TO_REMOVE_CURRENT_DIRECTORY,
     DOS_NOT_SAME_DEVICE,
-    DOS_NO_MORE_FILES
+    DOS_NO_MORE_FILES,
+    DOS_DRIVE_NOT_READY = 0x15,             // DOS 3.0+ extended errors
+    DOS_READ_FAULT = 0x1E,
+    DOS_SHARING_VIOLATION = 0x20,
+    DOS_LOCK_VIOLATION = 0x21,
+    DOS_INSUFFICIENT_DISK_SPACE = 0x27      // DOS 4.0+ extended error
 } dos_error_codes;
 
 /**
@@ -90,7 +95,7 @@ static const char dos_error_messages[85][MAX_ERR_STRING_LEN] = {
         "24  Sharing buffer overflow ",
         "25  Reserved ",
         "26  Unable to complete file operation ",
-        "27  Reserved ",
+        "27  Insufficient disk space ",
         "28  Reserved ",
         "29  Reserved ",
         "30  Reserved ",
@@ -0,0 +1,62 @@
+#include "dos_last_error.h"
+
+#include <stdio.h>
+
+#include "dos_error_messages.h"
+
+#define DOS_LAST_ERROR_MAX_CODE (sizeof(dos_error_messages) / sizeof(dos_error_messages[0]))
+
+#if !defined(__DOS__) && defined(__GNUC__)
+#define DOS_LAST_ERROR_STORAGE static __thread  // host builds read files from worker threads
+#else
+#define DOS_LAST_ERROR_STORAGE static
+#endif
+
+DOS_LAST_ERROR_STORAGE dos_last_error_t dos_last_error_record = { DOS_SUCCESS, NULL, "", 0 };
+
+void dos_last_error_set(dos_error_code_t code, const char* function, const char* path_name, uint32_t argument) {
+    dos_last_error_record.code = code;
+    dos_last_error_record.function = function;
+    uint8_t length = 0;
+    if (path_name) {
+        while (length < DOS_LAST_ERROR_PATH_SIZE - 1 && path_name[length]) {
+            dos_last_error_record.path_name[length] = path_name[length];
+            ++length;
+        }
+    }
+    dos_last_error_record.path_name[length] = '\0';
+    dos_last_error_record.argument = argument;
+}
+
+void dos_last_error_clear() {
+    dos_last_error_record.code = DOS_SUCCESS;
+    dos_last_error_record.function = NULL;
+    dos_last_error_record.path_name[0] = '\0';
+    dos_last_error_record.argument = 0;
+}
+
+const dos_last_error_t* dos_last_error() {
+    return &dos_last_error_record;
+}
+
+dos_error_code_t dos_last_error_code() {
+    return dos_last_error_record.code;
+}
+
+const char* dos_last_error_message() {
+    if (dos_last_error_record.code >= DOS_LAST_ERROR_MAX_CODE) {
+        return "Unknown error ";
+    }
+    return dos_error_messages[dos_last_error_record.code];
+}
+
+void dos_last_error_dump(FILE* stream) {
+    if (!stream || dos_last_error_record.code == DOS_SUCCESS) return;
+
+    fprintf(stream, "%s%s", dos_last_error_message(),
+            dos_last_error_record.function ? dos_last_error_record.function : "");
+    if (dos_last_error_record.path_name[0]) {
+        fprintf(stream, " path name = %s", dos_last_error_record.path_name);
+    }
+    fprintf(stream, " argument = %lu\n", (unsigned long)dos_last_error_record.argument);
+}
@@ -0,0 +1,97 @@
+/**
+ * @file dos_last_error.h
+ * @brief Per-process record of the last failed DOS service call
+ * @defgroup dos_last_error DOS Last Error
+ * @{
+ */
+#ifndef DOS_LAST_ERROR_H
+#define DOS_LAST_ERROR_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "dos_services_types.h"
+
+#define DOS_LAST_ERROR_PATH_SIZE    80      ///< DOS MAXPATH: drive, 64 byte directory, 8.3 name and NUL
+
+/**
+ * @brief What went wrong in the most recent failed wrapper call
+ * @dot
+ * digraph last_error {
+ *     node [shape=record, fontname="Courier New"];
+ *     last_error [label="<f0> code|<f1> function|<f2> path_name|<f3> argument"];
+ * }
+ * @enddot
+ *
+ * @note Only failures are recorded - a successful call leaves the record alone,
+ *       so clear it before a sequence of calls that is to be checked as a whole.
+ * @note Host builds keep one record per thread.
+ */
+typedef struct {
+    dos_error_code_t code;      ///< DOS error code (DOS_SUCCESS when clear)
+    const char* function;       ///< Name of the wrapper that failed
+    char path_name[DOS_LAST_ERROR_PATH_SIZE];   ///< Copy of the failed call's path, truncated, "" if none
+    uint32_t argument;          ///< Handle, drive, segment or size argument of the failed call
+} dos_last_error_t;
+
+/**
+ * @brief Records a failed service call
+ * @details Called by every wrapper on error in place of printing, so it must stay cheap:
+ *          a few stores and one bounded path copy, no stdio and no string lookup.
+ *          The path is copied because callers often pass a buffer that is gone, or
+ *          reused for the next name, by the time the record is read.
+ *
+ * @param code DOS error code returned by INT 21h
+ * @param function Wrapper name (use __func__)
+ * @param path_name Path argument or NULL, longer paths keep their first DOS_LAST_ERROR_PATH_SIZE - 1 characters
+ * @param argument Numeric argument (handle, drive, segment...)
+ */
+void dos_last_error_set(dos_error_code_t code, const char* function, const char* path_name, uint32_t argument);
+
+/**
+ * @brief Resets the record to DOS_SUCCESS
+ */
+void dos_last_error_clear();
+
+/**
+ * @brief Gets the last error record
+ * @return Pointer to the process wide record (never NULL)
+ */
+const dos_last_error_t* dos_last_error();
+
+/**
+ * @brief Gets the last error code
+ * @return DOS error code or DOS_SUCCESS if nothing has failed since the last clear
+ *
+ * @example Cheap retry on a sharing violation:
+ * @code
+ * do {
+ *     dos_last_error_clear();
+ *     fhandle = dos_open_file(path_name, ACCESS_READ_WRITE | DENY_WRITE);
+ * } while (!fhandle && dos_last_error_code() == DOS_SHARING_VIOLATION && --retries);
+ * @endcode
+ */
+dos_error_code_t dos_last_error_code();
+
+/**
+ * @brief Looks up the standard message for the last error code
+ * @return Message text from dos_error_messages
+ *
+ * @note The string table is only touched here, never on the error path itself
+ */
+const char* dos_last_error_message();
+
+/**
+ * @brief Writes the last error record to a stream
+ * @param stream Output stream (e.g. stderr)
+ *
+ * @output Example:
+ * @code
+ * 02  File not found dos_open_file path name = NOFILE.TXT argument = 0
+ * @endcode
+ */
+void dos_last_error_dump(FILE* stream);
+
+#endif
+
+/** @} */ // end of dos_last_error group
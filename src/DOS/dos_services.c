@@ -7,11 +7,12 @@
  */
 #include "dos_services.h"
 
-#include <stdio.h>
-
 #include "dos_services_constants.h"
 #include "dos_services_types.h"
 #include "dos_error_messages.h"
+#include "dos_last_error.h"
+
+#ifdef __DOS__  // host builds use dos_services_host.c
 
 /**
  * @brief Provides a safe method for changing interrupt vectors
@@ -127,14 +128,9 @@ OK: mov     mem_seg, ax
     pop     ds
     popf
     }
-#ifndef NDEBUG
-    if (err_code) {
-        fprintf(stderr, "%s", dos_error_messages[err_code]);
-        if (err_code == DOS_INSUFFICIENT_MEMORY) {
-            fprintf(stderr, " largest available block = %u paragraphs\n", available);    // paragraph = 16 bytes
-        }
+    if (err_code) {     // on insufficient memory the argument is the largest available block in paragraphs
+        dos_last_error_set(err_code, __func__, NULL, (err_code == DOS_INSUFFICIENT_MEMORY) ? available : paragraphs);
     }
-#endif
     return mem_seg;
 }
 
@@ -181,12 +177,12 @@ uint16_t dos_free_allocated_memory_blocks(uint16_t segment) {
         popf
     }
     mcb[0] = '\0';  // invalidate the MCB
-#ifndef NDEBUG
     if (err_code) {
-        fprintf(stderr, "%s %X\n", dos_error_messages[err_code], segment);
+        dos_last_error_set(err_code, __func__, NULL, segment);
     }
-#endif
     return err_code;
 }
 
+#endif
+
 /** @} */ // end of dos_services group
@@ -3,6 +3,9 @@
 #include <stdint.h>
 #include "dos_services_constants.h"
 #include "dos_error_messages.h"
+#include "dos_last_error.h"
+
+#ifdef __DOS__  // host builds use dos_services_3x_host.c
 
 /**
 * @brief Get extended error information (3.x+)
@@ -49,3 +52,91 @@ void dos3x_get_extended_error_information(dos3x_extended_error_information_t* in
     info->slocus = dos_error_locus[info->elocus];
 
 }
+
+/**
+* @brief Lock file access (3.x+)
+* AX = 5C00h
+* BX = file handle
+* CX:DX = offset of the region to lock
+* SI:DI = length of the region in bytes
+*
+* on return:
+* CF = 0 if successful
+*    = 1 if error
+* AX = error code if CF set (21h lock violation if any part of the region is already locked)
+*
+* - requires SHARE.EXE (or a network redirector) to be loaded, otherwise 01h invalid function
+* - locks are exclusive: other processes can neither read nor write the region
+* - locking beyond end of file is not an error
+* - every lock must be removed with an unlock of exactly the same offset and length
+*   before the file is closed
+*/
+dos_error_code_t dos3x_lock_file_region(const dos_file_handle_t fhandle, dos_file_position_t foffset, dos_file_size_t nbytes) {
+    dos_error_code_t err_code = 0;
+    __asm {
+        .8086
+        push    ds
+        pushf
+
+        mov     bx, fhandle
+        mov     dx, word ptr foffset                ; CX:DX = region offset
+        mov     cx, word ptr foffset + 2
+        mov     di, word ptr nbytes                 ; SI:DI = region length
+        mov     si, word ptr nbytes + 2
+        mov     al, 0                               ; AL = 00 lock
+        mov     ah, DOS_LOCK_UNLOCK_FILE_ACCESS
+        int     DOS_SERVICE
+        jnc     END
+        mov     err_code, ax
+
+END:    popf
+        pop     ds
+    }
+    if (err_code) {
+        dos_last_error_set(err_code, __func__, NULL, fhandle);
+    }
+    return err_code;
+}
+
+/**
+* @brief Unlock file access (3.x+)
+* AX = 5C01h
+* BX = file handle
+* CX:DX = offset of the locked region
+* SI:DI = length of the locked region in bytes
+*
+* on return:
+* CF = 0 if successful
+*    = 1 if error
+* AX = error code if CF set
+*
+* - offset and length must match a previous lock exactly
+*/
+dos_error_code_t dos3x_unlock_file_region(const dos_file_handle_t fhandle, dos_file_position_t foffset, dos_file_size_t nbytes) {
+    dos_error_code_t err_code = 0;
+    __asm {
+        .8086
+        push    ds
+        pushf
+
+        mov     bx, fhandle
+        mov     dx, word ptr foffset                ; CX:DX = region offset
+        mov     cx, word ptr foffset + 2
+        mov     di, word ptr nbytes                 ; SI:DI = region length
+        mov     si, word ptr nbytes + 2
+        mov     al, 1                               ; AL = 01 unlock
+        mov     ah, DOS_LOCK_UNLOCK_FILE_ACCESS
+        int     DOS_SERVICE
+        jnc     END
+        mov     err_code, ax
+
+END:    popf
+        pop     ds
+    }
+    if (err_code) {
+        dos_last_error_set(err_code, __func__, NULL, fhandle);
+    }
+    return err_code;
+}
+
+#endif
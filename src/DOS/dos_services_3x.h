@@ -1,6 +1,8 @@
 #ifndef DOS_SERVICE_3X_H
 #define DOS_SERVICE_3X_H
 
+#include "dos_services_types.h"
+#include "dos_services_files_types.h"
 #include "dos_services_3x_types.h"
 
 // 59  Get extended error information (3.x+)
@@ -9,6 +11,10 @@ void dos3x_get_extended_error_information(dos3x_extended_error_information_t* in
 // 5A  Create temporary file (3.x+)
 // 5B  Create new file (3.x+)
 // 5C  Lock/unlock file access (3.x+)
+dos_error_code_t dos3x_lock_file_region(const dos_file_handle_t fhandle, dos_file_position_t foffset, dos_file_size_t nbytes);
+
+dos_error_code_t dos3x_unlock_file_region(const dos_file_handle_t fhandle, dos_file_position_t foffset, dos_file_size_t nbytes);
+
 // 5D  Critical error information (undocumented 3.x+)
 // 5E  Network services (3.1+)
 // 5F  Network redirection (3.1+)
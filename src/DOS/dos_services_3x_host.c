@@ -0,0 +1,82 @@
+/**
+ * @file dos_services_3x_host.c
+ * @brief Host backend for dos_services_3x.h
+ * @ingroup dos_services_host
+ */
+#ifndef __DOS__
+
+#include "dos_services_3x.h"
+#include "dos_services_host.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include "dos_error_messages.h"
+#include "dos_last_error.h"
+
+#ifdef F_OFD_SETLK
+#define DOS_HOST_SETLK  F_OFD_SETLK     // per open file description: separate opens conflict even within one process
+#else
+#define DOS_HOST_SETLK  F_SETLK         // per process: only other processes conflict
+#endif
+
+/**
+* @note class, action and locus are inferred from the last error code - the host keeps no more than that
+*/
+void dos3x_get_extended_error_information(dos3x_extended_error_information_t* info) {
+    info->ecode = dos_last_error_code();
+    switch (info->ecode) {
+        case DOS_SUCCESS:
+            info->eclass = 0x00; info->eaction = 0x00; info->elocus = 0x00;
+            break;
+        case DOS_FILE_NOT_FOUND:
+        case DOS_PATH_NOT_FOUND:
+            info->eclass = 0x08; info->eaction = 0x03; info->elocus = 0x02;
+            break;
+        case DOS_INSUFFICIENT_MEMORY:
+        case DOS_MCB_DESTROYED:
+        case DOS_INVALID_MEMORY_BLOCK_ADDRESS:
+            info->eclass = 0x01; info->eaction = 0x04; info->elocus = 0x05;
+            break;
+        case DOS_SHARING_VIOLATION:
+        case DOS_LOCK_VIOLATION:
+            info->eclass = 0x0A; info->eaction = 0x02; info->elocus = 0x02;
+            break;
+        case DOS_ACCESS_DENIED:
+            info->eclass = 0x03; info->eaction = 0x04; info->elocus = 0x02;
+            break;
+        default:
+            info->eclass = 0x0D; info->eaction = 0x04; info->elocus = 0x01;
+            break;
+    }
+    info->scode = dos_last_error_message();
+    info->sclass = dos_error_classes[info->eclass];
+    info->saction = dos_error_actions[info->eaction];
+    info->slocus = dos_error_locus[info->elocus];
+}
+
+static dos_error_code_t dos_host_lock(const dos_file_handle_t fhandle, dos_file_position_t foffset, dos_file_size_t nbytes, short type, const char* function) {
+    struct flock region;
+    memset(&region, 0, sizeof(region));     // F_OFD_SETLK requires l_pid == 0
+    region.l_type = type;
+    region.l_whence = SEEK_SET;
+    region.l_start = foffset;
+    region.l_len = nbytes;
+    if (fcntl(fhandle, DOS_HOST_SETLK, &region) != 0) {
+        dos_error_code_t err_code = (errno == EACCES || errno == EAGAIN) ? DOS_LOCK_VIOLATION : dos_host_error_code(errno);
+        dos_last_error_set(err_code, function, NULL, fhandle);
+        return err_code;
+    }
+    return DOS_SUCCESS;
+}
+
+dos_error_code_t dos3x_lock_file_region(const dos_file_handle_t fhandle, dos_file_position_t foffset, dos_file_size_t nbytes) {
+    return dos_host_lock(fhandle, foffset, nbytes, F_WRLCK, __func__);
+}
+
+dos_error_code_t dos3x_unlock_file_region(const dos_file_handle_t fhandle, dos_file_position_t foffset, dos_file_size_t nbytes) {
+    return dos_host_lock(fhandle, foffset, nbytes, F_UNLCK, __func__);
+}
+
+#endif
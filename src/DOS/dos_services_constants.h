@@ -32,7 +32,7 @@
 #define DOS_RENAME_FILE_USING_FCB 
 #define DOS_DOS_DUMMY_FUNCTION_1   							// CP/M_NOT_USED/LISTED
 #define DOS_GET_CURRENT_DEFAULT_DRIVE 
-#define DOS_SET_DISK_TRANSFER_ADDRESS 
+#define DOS_SET_DISK_TRANSFER_ADDRESS						1Ah
 #define DOS_GET_ALLOCATION_TABLE_INFORMATION 
 #define DOS_GET_ALLOCATION_TABLE_INFO_FOR_SPECIFIC_DEVICE 
 #define DOS_DOS_DUMMY_FUNCTION_2   							// CP/M_NOT_USED/LISTED
@@ -53,7 +53,7 @@
 #define DOS_GET_TIME 
 #define DOS_SET_TIME 
 #define DOS_TOGGLE_VERIFY_SWITCH 
-#define DOS_GET_DISK_TRANSFER_ADDRESS 
+#define DOS_GET_DISK_TRANSFER_ADDRESS						2Fh
 #define DOS_GET_DOS_VERSION_NUMBER 
 #define DOS_TERMINATE_PROCESS_AND_REMAIN_RESIDENT 
 #define DOS_GET_POINTER_TO_DRIVE_PARAMETER_TABLE			// UNDOCUMENTED
@@ -74,7 +74,7 @@
 #define DOS_DELETE_FILE										41h
 #define DOS_MOVE_FILE_POINTER_USING_HANDLE					42h
 #define DOS_CHANGE_FILE_MODE								43h
-#define DOS_IO_CONTROL_FOR_DEVICES 
+#define DOS_IO_CONTROL_FOR_DEVICES							44h
 #define DOS_DUPLICATE_FILE_HANDLE 
 #define DOS_FORCE_DUPLICATE_FILE_HANDLE 
 #define DOS_GET_CURRENT_DIRECTORY 
@@ -84,8 +84,8 @@
 #define DOS_EXEC_LOAD_AND_EXECUTE_PROGRAM 
 #define DOS_TERMINATE_PROCESS_WITH_RETURN_CODE 
 #define DOS_GET_RETURN_CODE_OF_SUB_PROCESS 
-#define DOS_FIND_FIRST_MATCHING_FILE 
-#define DOS_FIND_NEXT_MATCHING_FILE 
+#define DOS_FIND_FIRST_MATCHING_FILE						4Eh
+#define DOS_FIND_NEXT_MATCHING_FILE							4Fh
 #define DOS_SET_CURRENT_PROCESS_ID   						// UNDOCUMENTED
 #define DOS_GET_CURRENT_PROCESS_ID   						// UNDOCUMENTED
 #define DOS_GET_POINTER_TO_DOS_INVARS						// UNDOCUMENTED
@@ -93,12 +93,12 @@
 #define DOS_GET_VERIFY_SETTING 
 #define DOS_CREATE_PSP										// UNDOCUMENTED
 #define DOS_RENAME_FILE 
-#define DOS_GET_SET_FILE_DATE_AND_TIME_USING_HANDLE 
+#define DOS_GET_SET_FILE_DATE_AND_TIME_USING_HANDLE			57h
 #define DOS_GET_SET_MEMORY_ALLOCATION_STRATEGY				// 3.X +   UNDOCUMENTED
 #define DOS_GET_EXTENDED_ERROR_INFORMATION					59h				// 3.X + 
 #define DOS_CREATE_TEMPORARY_FILE   						// 3.X + 
 #define DOS_CREATE_NEW_FILE									// 3.X + 
-#define DOS_LOCK_UNLOCK_FILE_ACCESS							// 3.X + 
+#define DOS_LOCK_UNLOCK_FILE_ACCESS							5Ch				// 3.X + 
 #define DOS_CRITICAL_ERROR_INFORMATION						// UNDOCUMENTED
 #define DOS_NETWORK_SERVICES								// 3.1 + 
 #define DOS_NETWORK_REDIRECTION   							// 3.1 + 
@@ -1,8 +1,11 @@
-#include <stdio.h>
+#include "dos_services_files.h"
 
 #include "dos_error_messages.h"
-#include "dos_services_files.h"
+#include "dos_last_error.h"
 #include "dos_services_constants.h"
+#include "dos_services_files_constants.h"
+
+#ifdef __DOS__  // host builds use dos_services_files_host.c
 
 /**
 * INT 21,36 - Get Disk Free Space
@@ -49,11 +52,9 @@ OK:		lds		di, info
 END:		popf
 		pop		ds
 	}
-#ifndef NDEBUG
 	if (info->sectors_per_cluster == 0xFFFF) {
-		fprintf(stderr, "%s drive_number = %i", dos_error_messages[DOS_INVALID_DRIVE_SPECIFIED], drive_number);
+		dos_last_error_set(DOS_INVALID_DRIVE_SPECIFIED, __func__, NULL, drive_number);
 	}
-#endif
 }
 
 /**
@@ -90,11 +91,9 @@ OK:		mov		fhandle, ax
 END:	popf
 		pop		ds
 	}
-#ifndef NDEBUG
 	if (err_code) {
-		fprintf(stderr, "%s drive_number = %s\n", dos_error_messages[err_code], path_name);
+		dos_last_error_set(err_code, __func__, path_name, 0);
 	}
-#endif
 	return fhandle;
 }
 
@@ -132,11 +131,9 @@ END:	popf
 		pop		ds
 	}
 
-#ifndef NDEBUG
 	if (err_code) {
-		fprintf(stderr, "%s path name = %s\n", dos_error_messages[err_code], path_name);
+		dos_last_error_set(err_code, __func__, path_name, 0);
 	}
-#endif
 	return fhandle;
 }
 
@@ -167,11 +164,9 @@ dos_error_code_t dos_close_file(const dos_file_handle_t fhandle) {
 END:		popf
 		pop		ds
 	}
-#ifndef NDEBUG
 	if (err_code) {
-		fprintf(stderr, "%s file_handle = %i\n", dos_error_messages[err_code], fhandle);
+		dos_last_error_set(err_code, __func__, NULL, fhandle);
 	}
-#endif
 	return err_code;
 }
 
@@ -212,11 +207,9 @@ OK:		mov		bytes_read, ax
 END:		popf
 		pop		ds
 	}
-#ifndef NDEBUG
 	if (err_code) {
-		fprintf(stderr, "%s file_handle = %i\n", dos_error_messages[err_code], fhandle);
+		dos_last_error_set(err_code, __func__, NULL, fhandle);
 	}
-#endif
 	return bytes_read;
 }
 
@@ -256,11 +249,9 @@ OK:		mov		bytes_written, ax
 END:		popf
 		pop		ds
 	}
-#ifndef NDEBUG
 	if (err_code) {
-		fprintf(stderr, "%s file_handle = %i\n", dos_error_messages[err_code], fhandle);
+		dos_last_error_set(err_code, __func__, NULL, fhandle);
 	}
-#endif
 	return bytes_written;
 }
 
@@ -293,11 +284,9 @@ dos_error_code_t dos_delete_file(const char* path_name) {
 END:		popf
 		pop		ds
 	}
-#ifndef NDEBUG
 	if (err_code) {
-		fprintf(stderr, "%s path name = %s\n", dos_error_messages[err_code], path_name);
+		dos_last_error_set(err_code, __func__, path_name, 0);
 	}
-#endif
 	return err_code;
 }
 
@@ -356,11 +345,9 @@ OK:		lds 	di, fpos_ptr						; DX:AX = new file position in bytes from start of f
 
 END:
 	}
-#ifndef NDEBUG
 	if (err_code) {
-		fprintf(stderr, "%s file_handle = %i\n", dos_error_messages[err_code], fhandle);
+		dos_last_error_set(err_code, __func__, NULL, fhandle);
 	}
-#endif
     return fposition;
 }
 
@@ -404,11 +391,9 @@ OK:		mov		attributes, ax
 END:		popf
 		pop		ds
 	}
-#ifndef NDEBUG
 	if (err_code) {
-		fprintf(stderr, "%s path name = %s\n", dos_error_messages[err_code], path_name);
+		dos_last_error_set(err_code, __func__, path_name, 0);
 	}
-#endif
 	return attributes;
 }
 
@@ -434,10 +419,242 @@ dos_error_code_t dos_set_file_attributes(const char* path_name, dos_file_attribu
 END:	popf
 		pop		ds
 	}
-#ifndef NDEBUG
 	if (err_code) {
-		fprintf(stderr, "%s path name = %s\n", dos_error_messages[err_code], path_name);
+		dos_last_error_set(err_code, __func__, path_name, 0);
+	}
+	return err_code;
+}
+
+/**
+* INT 21,4400 - IOCTL Get Device Information
+* AH = 44h
+* AL = 00
+* BX = file handle
+*
+* on return:
+* DX = device information word (see dos_file_device_info_t)
+* AX = error code if CF set  (see DOS ERROR CODES)
+*
+* - for a disk file bits 0-5 of DX hold the drive number (0 = A:)
+*/
+dos_file_device_info_t dos_get_device_information(const dos_file_handle_t fhandle) {
+	dos_file_device_info_t device_info = 0;
+	dos_error_code_t err_code = 0;
+	__asm {
+		.8086
+		push	ds
+		pushf
+
+		mov		bx, fhandle
+		xor		al, al						; AL = 00 get device information
+		mov		ah, DOS_IO_CONTROL_FOR_DEVICES
+		int		DOS_SERVICE
+		jnc		OK
+		mov		err_code, ax
+		xor		dx, dx
+OK:		mov		device_info, dx
+
+END:	popf
+		pop		ds
+	}
+	if (err_code) {
+		dos_last_error_set(err_code, __func__, NULL, fhandle);
+	}
+	return device_info;
+}
+
+/**
+* INT 21,4E - Find First Matching File
+* AH = 4Eh
+* CX = attributes to match (0 = normal files, 10h adds subdirectories)
+* DS:DX = pointer to an ASCIIZ path with wildcards
+*
+* on return:
+* AX = error code if CF set  (see DOS ERROR CODES)
+* DTA = dos_file_find_t of the first match
+*
+* - the DTA is pointed at entry for the call (INT 21,1A) and given back to the caller's
+*   DTA (INT 21,2F) afterwards, so the command tail at PSP:80h survives
+* - DOS_NO_MORE_FILES is the normal end of a search and is not recorded as the last error
+*/
+dos_error_code_t dos_find_first(const char* path_spec, dos_file_attributes_t attributes, dos_file_find_t* entry) {
+	dos_error_code_t err_code = 0;
+	__asm {
+		.8086
+		push	ds
+		pushf
+
+		mov		ah, DOS_GET_DISK_TRANSFER_ADDRESS
+		int		DOS_SERVICE					; ES:BX = DTA of the caller
+		push	es
+		push	bx
+		lds		dx, entry
+		mov		ah, DOS_SET_DISK_TRANSFER_ADDRESS
+		int		DOS_SERVICE
+		lds		dx, path_spec
+		mov		cx, attributes
+		mov		ah, DOS_FIND_FIRST_MATCHING_FILE
+		int		DOS_SERVICE
+		jnc		RESTORE
+		mov		err_code, ax
+RESTORE:	pop		dx
+		pop		ds
+		mov		ah, DOS_SET_DISK_TRANSFER_ADDRESS
+		int		DOS_SERVICE
+
+END:	popf
+		pop		ds
+	}
+	if (err_code && err_code != DOS_NO_MORE_FILES) {
+		dos_last_error_set(err_code, __func__, path_spec, attributes);
+	}
+	return err_code;
+}
+
+/**
+* INT 21,4F - Find Next Matching File
+* AH = 4Fh
+* DTA = dos_file_find_t of the previous match
+*
+* on return:
+* AX = error code if CF set  (see DOS ERROR CODES)
+* DTA = dos_file_find_t of the next match
+*/
+dos_error_code_t dos_find_next(dos_file_find_t* entry) {
+	dos_error_code_t err_code = 0;
+	__asm {
+		.8086
+		push	ds
+		pushf
+
+		mov		ah, DOS_GET_DISK_TRANSFER_ADDRESS
+		int		DOS_SERVICE
+		push	es
+		push	bx
+		lds		dx, entry
+		mov		ah, DOS_SET_DISK_TRANSFER_ADDRESS
+		int		DOS_SERVICE
+		mov		ah, DOS_FIND_NEXT_MATCHING_FILE
+		int		DOS_SERVICE
+		jnc		RESTORE
+		mov		err_code, ax
+RESTORE:	pop		dx
+		pop		ds
+		mov		ah, DOS_SET_DISK_TRANSFER_ADDRESS
+		int		DOS_SERVICE
+
+END:	popf
+		pop		ds
+	}
+	if (err_code && err_code != DOS_NO_MORE_FILES) {
+		dos_last_error_set(err_code, __func__, NULL, 0);
+	}
+	return err_code;
+}
+
+/**
+* INT 21,5700 - Get File Date and Time Using Handle
+* AH = 57h
+* AL = 00
+* BX = file handle
+*
+* on return:
+* CX = time of last write (see dos_file_date_time_t)
+* DX = date of last write
+* AX = error code if CF set  (see DOS ERROR CODES)
+*/
+dos_error_code_t dos_get_file_date_time(const dos_file_handle_t fhandle, dos_file_date_time_t* stamp) {
+	uint16_t ftime = 0;
+	uint16_t fdate = 0;
+	dos_error_code_t err_code = 0;
+	__asm {
+		.8086
+		push	ds
+		pushf
+
+		mov		bx, fhandle
+		xor		al, al						; AL = 00 get date and time
+		mov		ah, DOS_GET_SET_FILE_DATE_AND_TIME_USING_HANDLE
+		int		DOS_SERVICE
+		jnc		OK
+		mov		err_code, ax
+		xor		cx, cx
+		xor		dx, dx
+OK:		mov		ftime, cx
+		mov		fdate, dx
+
+END:	popf
+		pop		ds
+	}
+	stamp->time = ftime;
+	stamp->date = fdate;
+	if (err_code) {
+		dos_last_error_set(err_code, __func__, NULL, fhandle);
 	}
-#endif
 	return err_code;
 }
+
+#endif
+
+/**
+* @brief Grow an open file to its final size in one step
+*
+* Writing a large file in small pieces extends the FAT chain cluster by cluster,
+* updating the FAT on every write and scattering clusters across the disk.
+* Moving the file pointer to size - 1 and writing a single byte makes DOS allocate
+* the whole chain at once; later writes then overwrite clusters already in place.
+*
+* - checks the free space on the file's drive first (INT 21,36)
+* - grows an empty file to one byte before the large move (see the FAT corruption BUG
+*   noted for dos_move_file_pointer)
+* - the file pointer is restored to where it was on entry
+* - a file already at least fsize long, or a character device, is left untouched
+*
+* @return DOS_SUCCESS, DOS_INVALID_DRIVE_SPECIFIED, DOS_INSUFFICIENT_DISK_SPACE or the failing call's error code
+*/
+dos_error_code_t dos_file_preallocate(const dos_file_handle_t fhandle, dos_file_size_t fsize) {
+	dos_file_disk_space_info_t info;
+	dos_file_device_info_t device_info;
+	dos_file_position_t fposition, fend;
+	dos_file_size_t free_bytes;
+	const char zero = 0;
+
+	device_info = dos_get_device_information(fhandle);
+	if (!fsize || (device_info & DOS_DEVICE_INFO_IS_DEVICE)) {
+		return DOS_SUCCESS;
+	}
+	fposition = dos_move_file_pointer(fhandle, 0, FSEEK_CUR);
+	fend = dos_move_file_pointer(fhandle, 0, FSEEK_END);
+	if ((dos_file_size_t)fend >= fsize) {
+		dos_move_file_pointer(fhandle, fposition, FSEEK_SET);
+		return DOS_SUCCESS;
+	}
+
+	dos_get_disk_free_space((device_info & DOS_DEVICE_INFO_DRIVE_MASK) + 1, &info);    // 0 = A: here but 1 = A: for INT 21,36
+	if (info.sectors_per_cluster == 0xFFFF) {                   // already recorded by dos_get_disk_free_space
+		dos_move_file_pointer(fhandle, fposition, FSEEK_SET);
+		return DOS_INVALID_DRIVE_SPECIFIED;
+	}
+	free_bytes = (dos_file_size_t)info.available_clusters * info.sectors_per_cluster * info.bytes_per_sector;
+	if (fsize - (dos_file_size_t)fend > free_bytes) {
+		dos_move_file_pointer(fhandle, fposition, FSEEK_SET);
+		dos_last_error_set(DOS_INSUFFICIENT_DISK_SPACE, __func__, NULL, fsize);
+		return DOS_INSUFFICIENT_DISK_SPACE;
+	}
+
+	if (fend == 0) {											// grow from zero to one byte first
+		if (dos_write_file(fhandle, &zero, 1) != 1) {
+			dos_move_file_pointer(fhandle, fposition, FSEEK_SET);
+			dos_last_error_set(DOS_INSUFFICIENT_DISK_SPACE, __func__, NULL, fsize);
+			return DOS_INSUFFICIENT_DISK_SPACE;
+		}
+	}
+	dos_move_file_pointer(fhandle, (dos_file_position_t)(fsize - 1), FSEEK_SET);
+	if (dos_write_file(fhandle, &zero, 1) != 1) {				// a short write means the disk filled up
+		dos_move_file_pointer(fhandle, fposition, FSEEK_SET);
+		dos_last_error_set(DOS_INSUFFICIENT_DISK_SPACE, __func__, NULL, fsize);
+		return DOS_INSUFFICIENT_DISK_SPACE;
+	}
+	dos_move_file_pointer(fhandle, fposition, FSEEK_SET);
+	return DOS_SUCCESS;
+}
@@ -40,8 +40,22 @@ dos_file_attributes_t dos_get_file_attributes(const char* path_name);
 dos_error_code_t dos_set_file_attributes(const char* path_name, dos_file_attributes_t attributes);
 
 // 44  I/O control for devices (IOCTL)
+dos_file_device_info_t dos_get_device_information(const dos_file_handle_t fhandle);
+
 // 45  Duplicate file handle
 // 46  Force duplicate file handle
 // 47  Get current directory
+//
+// 4E  Find first matching file
+dos_error_code_t dos_find_first(const char* path_spec, dos_file_attributes_t attributes, dos_file_find_t* entry);
+
+// 4F  Find next matching file
+dos_error_code_t dos_find_next(dos_file_find_t* entry);
+
+// 57  Get/set file date and time using handle
+dos_error_code_t dos_get_file_date_time(const dos_file_handle_t fhandle, dos_file_date_time_t* stamp);
+
+// Composite services
+dos_error_code_t dos_file_preallocate(const dos_file_handle_t fhandle, dos_file_size_t fsize);
 
 #endif
@@ -1,5 +1,13 @@
 #ifndef DOS_SERVICES_FILES_CONSTANTS_H
 #define DOS_SERVICES_FILES_CONSTANTS_H
 
+// IOCTL 4400h device information word
+#define DOS_DEVICE_INFO_DRIVE_MASK      0x003F      // drive number of a disk file (0 = A:)
+#define DOS_DEVICE_INFO_NOT_WRITTEN     0x0040      // disk file has not been written
+#define DOS_DEVICE_INFO_IS_DEVICE       0x0080      // handle refers to a character device
+
+// INT 21,4E/4F search attributes and dos_file_find_t.attributes
+#define DOS_FILE_ATTRIBUTE_DIRECTORY    0x10        // include/is a subdirectory
+#define DOS_FILE_NAME_SIZE              13          // 8.3 name, dot and NUL
 
 #endif
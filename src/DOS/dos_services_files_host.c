@@ -0,0 +1,293 @@
+/**
+ * @file dos_services_files_host.c
+ * @brief Host backend for dos_services_files.h on POSIX file descriptors
+ * @ingroup dos_services_host
+ */
+#ifndef __DOS__
+
+#include "dos_services_files.h"
+#include "dos_services_host.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dos_error_messages.h"
+#include "dos_last_error.h"
+#include "dos_services_files_constants.h"
+
+#define DOS_HOST_BYTES_PER_SECTOR       512
+#define DOS_HOST_SECTORS_PER_CLUSTER    64      // 32KB clusters, FAT16's largest
+#define DOS_HOST_DRIVE                  2       // disk files all live on C: (0 = A:)
+#define DOS_HOST_MAX_PATH               260     // directory part of a search path
+
+/**
+* @note the host has no drive letters, every valid drive reports the file system of the current directory
+*/
+void dos_get_disk_free_space(uint8_t drive_number, dos_file_disk_space_info_t* info) {
+	struct statvfs vfs;
+	if (drive_number > 26 || statvfs(".", &vfs) != 0) {
+		info->sectors_per_cluster = 0xFFFF;
+		info->available_clusters = info->bytes_per_sector = info->clusters_per_drive = 0;
+		dos_last_error_set(DOS_INVALID_DRIVE_SPECIFIED, __func__, NULL, drive_number);
+		return;
+	}
+	uint64_t cluster_size = (uint64_t)DOS_HOST_BYTES_PER_SECTOR * DOS_HOST_SECTORS_PER_CLUSTER;
+	uint64_t available = ((uint64_t)vfs.f_bavail * vfs.f_frsize) / cluster_size;
+	uint64_t total = ((uint64_t)vfs.f_blocks * vfs.f_frsize) / cluster_size;
+	info->sectors_per_cluster = DOS_HOST_SECTORS_PER_CLUSTER;
+	info->available_clusters = (uint16_t)(available > 0xFFF6 ? 0xFFF6 : available);  // FAT16 cluster limit
+	info->bytes_per_sector = DOS_HOST_BYTES_PER_SECTOR;
+	info->clusters_per_drive = (uint16_t)(total > 0xFFF6 ? 0xFFF6 : total);
+}
+
+dos_file_handle_t dos_create_file(const char* path_name, dos_file_attributes_t create_attributes) {
+	int fd = open(path_name, O_RDWR | O_CREAT | O_TRUNC, (create_attributes & CREATE_READ_ONLY) ? 0444 : 0666);
+	if (fd < 0) {
+		dos_last_error_set(dos_host_error_code(errno), __func__, path_name, 0);
+		return 0;
+	}
+	return (dos_file_handle_t)fd;
+}
+
+/**
+* @note sharing mode bits are accepted but not enforced
+*/
+dos_file_handle_t dos_open_file(const char* path_name, dos_file_access_attributes_t access_attributes) {
+	static const int access_flags[3] = { O_RDONLY, O_WRONLY, O_RDWR };
+	unsigned access_mode = access_attributes & 7;
+	if (access_mode > ACCESS_READ_WRITE) {
+		dos_last_error_set(DOS_INVALID_ACCESS_MODE, __func__, path_name, 0);
+		return 0;
+	}
+	int fd = open(path_name, access_flags[access_mode]);
+	if (fd < 0) {
+		dos_last_error_set(dos_host_error_code(errno), __func__, path_name, 0);
+		return 0;
+	}
+	return (dos_file_handle_t)fd;
+}
+
+dos_error_code_t dos_close_file(const dos_file_handle_t fhandle) {
+	if (close(fhandle) != 0) {
+		dos_error_code_t err_code = dos_host_error_code(errno);
+		dos_last_error_set(err_code, __func__, NULL, fhandle);
+		return err_code;
+	}
+	return DOS_SUCCESS;
+}
+
+uint16_t dos_read_file(const dos_file_handle_t fhandle, const char* buffer, uint16_t nbytes) {
+	ssize_t bytes_read;
+	do {
+		bytes_read = read(fhandle, (void*)buffer, nbytes);
+	} while (bytes_read < 0 && errno == EINTR);
+	if (bytes_read < 0) {
+		dos_last_error_set(dos_host_error_code(errno), __func__, NULL, fhandle);
+		return 0;
+	}
+	return (uint16_t)bytes_read;
+}
+
+/**
+* @note as with INT 21,40 a zero byte write truncates/extends the file to the current position
+*/
+uint16_t dos_write_file(const dos_file_handle_t fhandle, const char* buffer, uint16_t nbytes) {
+	if (!nbytes) {
+		off_t fposition = lseek(fhandle, 0, SEEK_CUR);
+		if (fposition < 0 || ftruncate(fhandle, fposition) != 0) {
+			dos_last_error_set(dos_host_error_code(errno), __func__, NULL, fhandle);
+		}
+		return 0;
+	}
+	ssize_t bytes_written;
+	do {
+		bytes_written = write(fhandle, buffer, nbytes);
+	} while (bytes_written < 0 && errno == EINTR);
+	if (bytes_written < 0) {
+		if (errno == ENOSPC) {      // DOS reports a full disk as a short write, not an error
+			return 0;
+		}
+		dos_last_error_set(dos_host_error_code(errno), __func__, NULL, fhandle);
+		return 0;
+	}
+	return (uint16_t)bytes_written;
+}
+
+dos_error_code_t dos_delete_file(const char* path_name) {
+	if (unlink(path_name) != 0) {
+		dos_error_code_t err_code = dos_host_error_code(errno);
+		dos_last_error_set(err_code, __func__, path_name, 0);
+		return err_code;
+	}
+	return DOS_SUCCESS;
+}
+
+dos_file_position_t dos_move_file_pointer(const dos_file_handle_t fhandle, dos_file_position_t foffset, uint8_t forigin) {
+	static const int whence[3] = { SEEK_SET, SEEK_CUR, SEEK_END };
+	if (forigin > FSEEK_END) {
+		dos_last_error_set(DOS_INVALID_FUNCTION_NUMBER, __func__, NULL, fhandle);
+		return foffset;
+	}
+	off_t fposition = lseek(fhandle, (off_t)foffset, whence[forigin]);
+	if (fposition < 0) {
+		dos_last_error_set(dos_host_error_code(errno), __func__, NULL, fhandle);
+		return foffset;
+	}
+	return (dos_file_position_t)fposition;
+}
+
+dos_file_attributes_t dos_get_file_attributes(const char* path_name) {
+	struct stat st;
+	if (stat(path_name, &st) != 0) {
+		dos_last_error_set(dos_host_error_code(errno), __func__, path_name, 0);
+		return 0;
+	}
+	dos_file_attributes_t attributes = S_ISDIR(st.st_mode) ? 0x10 : CREATE_ARCHIVE;
+	if (!(st.st_mode & S_IWUSR)) {
+		attributes |= CREATE_READ_ONLY;
+	}
+	return attributes;
+}
+
+/**
+* @note only the read-only bit has a host equivalent
+*/
+dos_error_code_t dos_set_file_attributes(const char* path_name, dos_file_attributes_t attributes) {
+	struct stat st;
+	if (stat(path_name, &st) != 0) {
+		dos_error_code_t err_code = dos_host_error_code(errno);
+		dos_last_error_set(err_code, __func__, path_name, 0);
+		return err_code;
+	}
+	mode_t mode = (attributes & CREATE_READ_ONLY) ? (st.st_mode & ~(S_IWUSR | S_IWGRP | S_IWOTH)) : (st.st_mode | S_IWUSR);
+	if (chmod(path_name, mode & 07777) != 0) {
+		dos_error_code_t err_code = dos_host_error_code(errno);
+		dos_last_error_set(err_code, __func__, path_name, 0);
+		return err_code;
+	}
+	return DOS_SUCCESS;
+}
+
+dos_file_device_info_t dos_get_device_information(const dos_file_handle_t fhandle) {
+	struct stat st;
+	if (fstat(fhandle, &st) != 0) {
+		dos_last_error_set(dos_host_error_code(errno), __func__, NULL, fhandle);
+		return 0;
+	}
+	if (S_ISCHR(st.st_mode) || S_ISFIFO(st.st_mode) || S_ISSOCK(st.st_mode)) {
+		return DOS_DEVICE_INFO_IS_DEVICE;
+	}
+	return (dos_file_device_info_t)(DOS_HOST_DRIVE | (st.st_size == 0 ? DOS_DEVICE_INFO_NOT_WRITTEN : 0));
+}
+
+/**
+* @brief Matches directory entries until one fits the template kept in the record
+*
+* The host keeps its search state where DOS does, in the record's reserved bytes:
+* the open DIR*, the 8.3 template (NUL padded, 12 bytes) and the search attributes. Names that do not fit an 8.3 record
+* are skipped, matching is case insensitive and "*.*" also matches names without a dot.
+*/
+static dos_error_code_t dos_host_find(dos_file_find_t* entry) {
+	DIR* dir;
+	char pattern[DOS_FILE_NAME_SIZE];
+	memcpy(&dir, entry->reserved, sizeof(dir));
+	memcpy(pattern, entry->reserved + sizeof(dir), DOS_FILE_NAME_SIZE - 1);
+	pattern[DOS_FILE_NAME_SIZE - 1] = '\0';
+	uint8_t search = entry->reserved[sizeof(entry->reserved) - 1];
+	if (!dir) {
+		return DOS_NO_MORE_FILES;
+	}
+	struct dirent* dirent;
+	struct stat st;
+	while ((dirent = readdir(dir)) != NULL) {
+		if (strlen(dirent->d_name) >= DOS_FILE_NAME_SIZE || dirent->d_name[0] == '.'
+			|| fnmatch(pattern, dirent->d_name, FNM_CASEFOLD) != 0
+			|| fstatat(dirfd(dir), dirent->d_name, &st, 0) != 0) {
+			continue;
+		}
+		if (S_ISDIR(st.st_mode) && !(search & DOS_FILE_ATTRIBUTE_DIRECTORY)) {
+			continue;
+		}
+		struct tm local;
+		localtime_r(&st.st_mtime, &local);
+		strcpy(entry->name, dirent->d_name);
+		entry->size = (uint32_t)st.st_size;
+		entry->time = (uint16_t)((local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec / 2));
+		entry->date = (uint16_t)(local.tm_year < 80 ? (1 << 5) | 1 : ((local.tm_year - 80) << 9) | ((local.tm_mon + 1) << 5) | local.tm_mday);
+		entry->attributes = S_ISDIR(st.st_mode) ? DOS_FILE_ATTRIBUTE_DIRECTORY : CREATE_ARCHIVE;
+		return DOS_SUCCESS;
+	}
+	closedir(dir);
+	dir = NULL;
+	memcpy(entry->reserved, &dir, sizeof(dir));
+	return DOS_NO_MORE_FILES;
+}
+
+/**
+* @note the directory stays open until the search returns DOS_NO_MORE_FILES
+*/
+dos_error_code_t dos_find_first(const char* path_spec, dos_file_attributes_t attributes, dos_file_find_t* entry) {
+	char directory[DOS_HOST_MAX_PATH];
+	const char* name = path_spec;
+	const char* p;
+	for (p = path_spec; *p; ++p) {
+		if (*p == '/' || *p == '\\') {
+			name = p + 1;
+		}
+	}
+	memset(entry, 0, sizeof(dos_file_find_t));
+	if (strlen(name) >= DOS_FILE_NAME_SIZE || (size_t)(name - path_spec) >= sizeof(directory)) {
+		dos_last_error_set(DOS_FILE_NOT_FOUND, __func__, path_spec, attributes);
+		return DOS_FILE_NOT_FOUND;
+	}
+	memcpy(directory, path_spec, name - path_spec);
+	directory[name - path_spec] = '\0';
+	DIR* dir = opendir(directory[0] ? directory : ".");
+	if (!dir) {
+		dos_last_error_set(DOS_PATH_NOT_FOUND, __func__, path_spec, attributes);
+		return DOS_PATH_NOT_FOUND;
+	}
+	memcpy(entry->reserved, &dir, sizeof(dir));
+	strcpy((char*)entry->reserved + sizeof(dir), strcmp(name, "*.*") ? name : "*");
+	entry->reserved[sizeof(entry->reserved) - 1] = (uint8_t)attributes;
+	dos_error_code_t err_code = dos_host_find(entry);
+	if (err_code == DOS_NO_MORE_FILES) {
+		err_code = DOS_FILE_NOT_FOUND;				// as DOS: nothing matched at all
+		dos_last_error_set(err_code, __func__, path_spec, attributes);
+	}
+	return err_code;
+}
+
+dos_error_code_t dos_find_next(dos_file_find_t* entry) {
+	return dos_host_find(entry);
+}
+
+dos_error_code_t dos_get_file_date_time(const dos_file_handle_t fhandle, dos_file_date_time_t* stamp) {
+	struct stat st;
+	struct tm local;
+	stamp->time = 0;
+	stamp->date = 0;
+	if (fstat(fhandle, &st) != 0) {
+		dos_error_code_t err_code = dos_host_error_code(errno);
+		dos_last_error_set(err_code, __func__, NULL, fhandle);
+		return err_code;
+	}
+	localtime_r(&st.st_mtime, &local);
+	if (local.tm_year < 80) {					// FAT dates start in 1980
+		local.tm_year = 80;
+		local.tm_mon = 0;
+		local.tm_mday = 1;
+	}
+	stamp->time = (uint16_t)((local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec / 2));
+	stamp->date = (uint16_t)(((local.tm_year - 80) << 9) | ((local.tm_mon + 1) << 5) | local.tm_mday);
+	return DOS_SUCCESS;
+}
+
+#endif
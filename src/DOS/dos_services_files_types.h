@@ -82,11 +82,65 @@ typedef enum {
 */
 typedef struct {
 
-        int16_t sectors_per_cluster;    // 0FFFFH if the drive number is invalid
-        int16_t available_clusters;
-        int16_t bytes_per_sector;
-        int16_t clusters_per_drive;
+        uint16_t sectors_per_cluster;   // 0FFFFH if the drive number is invalid
+        uint16_t available_clusters;
+        uint16_t bytes_per_sector;
+        uint16_t clusters_per_drive;
 
 } dos_file_disk_space_info_t;
 
+/**
+* DOS int 21h, 4400h    IOCTL Get Device Information
+*
+* |F|E|D|C|B|A|9|8|7|6|5|4|3|2|1|0|  DX  for files (bit 7 clear)
+*                  | | `------------- drive number (0 = A:)
+*                  | `-------------- 1 = file has not been written
+*                  `--------------- 0 = disk file, 1 = character device
+*/
+typedef uint16_t dos_file_device_info_t;
+
+/**
+* DOS int 21h, 5700h    Get File Date and Time Using Handle
+*
+* |F|E|D|C|B|A|9|8|7|6|5|4|3|2|1|0|  CX  time
+*  | | | | | | | | | | | `-+-+-+-+---- seconds / 2
+*  | | | | | `-+-+-+-+-+------------- minutes
+*  `-+-+-+-+------------------------- hours
+*
+* |F|E|D|C|B|A|9|8|7|6|5|4|3|2|1|0|  DX  date
+*  | | | | | | | | | | | `-+-+-+-+---- day
+*  | | | | | | | `-+-+-+------------- month
+*  `-+-+-+-+-+-+--------------------- year - 1980
+*/
+typedef struct {
+        uint16_t time;
+        uint16_t date;
+} dos_file_date_time_t;
+
+/**
+* DOS int 21h, 4Eh/4Fh  Find First/Next Matching File
+*
+* The disk transfer area filled in by a search; DOS keeps the state of the search
+* in the first 21 bytes, so the same record must be passed to every find next.
+*
+* | Offset | Size | Field                                     |
+* |--------|------|-------------------------------------------|
+* | 00h    | 21   | reserved (drive, search template, entry)  |
+* | 15h    | 1    | attributes of the file found              |
+* | 16h    | 2    | time of last write (dos_file_date_time_t) |
+* | 18h    | 2    | date of last write                        |
+* | 1Ah    | 4    | file size                                 |
+* | 1Eh    | 13   | ASCIIZ 8.3 name, no path                  |
+*/
+#pragma pack(push, 1)
+typedef struct {
+        uint8_t reserved[21];
+        uint8_t attributes;
+        uint16_t time;
+        uint16_t date;
+        uint32_t size;
+        char name[13];
+} dos_file_find_t;
+#pragma pack(pop)
+
 #endif
@@ -0,0 +1,204 @@
+/**
+ * @file dos_services_host.c
+ * @brief Host backend for dos_services.h - interrupt vector table and simulated conventional memory
+ * @ingroup dos_services_host
+ */
+#ifndef __DOS__
+
+#include "dos_services.h"
+#include "dos_services_host.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include "dos_error_messages.h"
+#include "dos_last_error.h"
+#include "../MEM/mem_constants.h"
+
+#define DOS_HOST_PARAGRAPHS     (DOS_HOST_LAST_SEGMENT - DOS_HOST_FIRST_SEGMENT)
+
+/* MCB field offsets (see mem_dump_mcb_to_stream) */
+#define MCB_SIGNATURE   0
+#define MCB_OWNER       1
+#define MCB_SIZE        3
+#define MCB_NAME        8
+
+#define DOS_HOST_ROM_SEGMENT    0xF000  // vectors start out pointing into ROM BIOS, as on a real machine
+
+static void* dos_host_vectors[256];
+
+static int dos_host_vectors_ready = 0;
+
+static uint8_t dos_host_memory[(uint32_t)DOS_HOST_PARAGRAPHS * MEM_SIZE_PARAGRAPH];
+
+static int dos_host_memory_ready = 0;
+
+static uint8_t* dos_host_mcb(uint16_t segment) {
+    return dos_host_memory + (uint32_t)(segment - DOS_HOST_FIRST_SEGMENT) * MEM_SIZE_PARAGRAPH;
+}
+
+static uint16_t dos_host_mcb_word(const uint8_t* mcb, int field) {
+    return (uint16_t)(mcb[field] | (mcb[field + 1] << 8));
+}
+
+static void dos_host_mcb_set(uint8_t* mcb, char signature, uint16_t owner, uint16_t size) {
+    mcb[MCB_SIGNATURE] = (uint8_t)signature;
+    mcb[MCB_OWNER] = (uint8_t)owner;
+    mcb[MCB_OWNER + 1] = (uint8_t)(owner >> 8);
+    mcb[MCB_SIZE] = (uint8_t)size;
+    mcb[MCB_SIZE + 1] = (uint8_t)(size >> 8);
+}
+
+/**
+ * @brief Lays down a single free 'Z' block covering all simulated memory
+ */
+static void dos_host_memory_init() {
+    if (dos_host_memory_ready) return;
+    dos_host_mcb_set(dos_host_mcb(DOS_HOST_FIRST_SEGMENT), 'Z', 0, DOS_HOST_PARAGRAPHS - 1);
+    dos_host_memory_ready = 1;
+}
+
+/**
+ * @brief Merges runs of adjacent free blocks, as DOS does lazily on the next allocation
+ */
+static void dos_host_memory_coalesce() {
+    uint16_t segment = DOS_HOST_FIRST_SEGMENT;
+    for (;;) {
+        uint8_t* mcb = dos_host_mcb(segment);
+        if (mcb[MCB_SIGNATURE] == 'Z') return;
+        uint16_t next = segment + 1 + dos_host_mcb_word(mcb, MCB_SIZE);
+        uint8_t* next_mcb = dos_host_mcb(next);
+        if (dos_host_mcb_word(mcb, MCB_OWNER) == 0 && dos_host_mcb_word(next_mcb, MCB_OWNER) == 0) {
+            dos_host_mcb_set(mcb, (char)next_mcb[MCB_SIGNATURE], 0,
+                             dos_host_mcb_word(mcb, MCB_SIZE) + 1 + dos_host_mcb_word(next_mcb, MCB_SIZE));
+            next_mcb[MCB_SIGNATURE] = '\0';
+        } else {
+            segment = next;
+        }
+    }
+}
+
+uint16_t dos_host_largest_free_block() {
+    dos_host_memory_init();
+    dos_host_memory_coalesce();
+    uint16_t largest = 0;
+    uint16_t segment = DOS_HOST_FIRST_SEGMENT;
+    for (;;) {
+        uint8_t* mcb = dos_host_mcb(segment);
+        uint16_t size = dos_host_mcb_word(mcb, MCB_SIZE);
+        if (dos_host_mcb_word(mcb, MCB_OWNER) == 0 && size > largest) {
+            largest = size;
+        }
+        if (mcb[MCB_SIGNATURE] == 'Z') return largest;
+        segment += 1 + size;
+    }
+}
+
+char* dos_host_segment_to_pointer(uint16_t segment) {
+    if (segment < DOS_HOST_FIRST_SEGMENT || segment >= DOS_HOST_LAST_SEGMENT) {
+        return NULL;
+    }
+    return (char*)dos_host_mcb(segment);
+}
+
+uint16_t dos_host_pointer_to_segment(const void* ptr) {
+    const uint8_t* p = (const uint8_t*)ptr;
+    if (p < dos_host_memory || p >= dos_host_memory + sizeof(dos_host_memory)) {
+        return 0;
+    }
+    return (uint16_t)(DOS_HOST_FIRST_SEGMENT + (p - dos_host_memory) / MEM_SIZE_PARAGRAPH);
+}
+
+dos_error_code_t dos_host_error_code(int err) {
+    switch (err) {
+        case 0:         return DOS_SUCCESS;
+        case ENOENT:    return DOS_FILE_NOT_FOUND;
+        case ENOTDIR:   return DOS_PATH_NOT_FOUND;
+        case ENAMETOOLONG: return DOS_PATH_NOT_FOUND;
+        case EMFILE:
+        case ENFILE:    return DOS_TOO_MANY_OPEN_FILES;
+        case EACCES:
+        case EPERM:
+        case EISDIR:
+        case EROFS:     return DOS_ACCESS_DENIED;
+        case EBADF:     return DOS_INVALID_HANDLE;
+        case ENOMEM:    return DOS_INSUFFICIENT_MEMORY;
+        case EINVAL:    return DOS_INVALID_ACCESS_MODE;
+        case EXDEV:     return DOS_NOT_SAME_DEVICE;
+        case EAGAIN:    return DOS_LOCK_VIOLATION;
+        case ENOSPC:
+        case EFBIG:     return DOS_INSUFFICIENT_DISK_SPACE;
+        case EEXIST:    return 0x50;    // file already exists
+        default:        return 0x1F;    // general failure
+    }
+}
+
+/**
+ * @brief Fills the vector table with distinct F000:xxxx placeholders (never called)
+ */
+static void dos_host_vectors_init() {
+    if (dos_host_vectors_ready) return;
+    for (int i = 0; i < 256; ++i) {
+        dos_host_vectors[i] = (void*)(uintptr_t)(((uint32_t)DOS_HOST_ROM_SEGMENT << 16) | (uint32_t)(i << 2));
+    }
+    dos_host_vectors_ready = 1;
+}
+
+void dos_set_interrupt_vector(uint8_t vec_num, void* phandler) {
+    dos_host_vectors_init();
+    dos_host_vectors[vec_num] = phandler;
+}
+
+void* dos_get_interrupt_vector(uint8_t vec_num) {
+    dos_host_vectors_init();
+    return dos_host_vectors[vec_num];
+}
+
+/**
+ * @brief First fit allocation down the simulated MCB chain
+ * @details Splits the chosen free block, the remainder gets its own MCB, exactly as INT 21,48
+ *          with the default (first fit) allocation strategy.
+ */
+uint16_t dos_allocate_memory_blocks(uint16_t paragraphs) {
+    if(!paragraphs) {
+        return paragraphs;
+    }
+    dos_host_memory_init();
+    dos_host_memory_coalesce();
+    uint16_t segment = DOS_HOST_FIRST_SEGMENT;
+    for (;;) {
+        uint8_t* mcb = dos_host_mcb(segment);
+        uint16_t size = dos_host_mcb_word(mcb, MCB_SIZE);
+        char signature = (char)mcb[MCB_SIGNATURE];
+        if (dos_host_mcb_word(mcb, MCB_OWNER) == 0 && size >= paragraphs) {
+            if (size > paragraphs) {    // split: the remainder keeps the chain position
+                dos_host_mcb_set(dos_host_mcb(segment + 1 + paragraphs), signature, 0, size - paragraphs - 1);
+                signature = 'M';
+            }
+            dos_host_mcb_set(mcb, signature, DOS_HOST_PSP_SEGMENT, paragraphs);
+            memcpy(mcb + MCB_NAME, "DOPE\0\0\0\0", 8);
+            return segment + 1;
+        }
+        if (signature == 'Z') break;
+        segment += 1 + size;
+    }
+    dos_last_error_set(DOS_INSUFFICIENT_MEMORY, __func__, NULL, dos_host_largest_free_block());
+    return 0;
+}
+
+uint16_t dos_free_allocated_memory_blocks(uint16_t segment) {
+    dos_host_memory_init();
+    if (segment <= DOS_HOST_FIRST_SEGMENT || segment >= DOS_HOST_LAST_SEGMENT) {
+        dos_last_error_set(DOS_INVALID_MEMORY_BLOCK_ADDRESS, __func__, NULL, segment);
+        return DOS_INVALID_MEMORY_BLOCK_ADDRESS;
+    }
+    uint8_t* mcb = dos_host_mcb(segment - 1);
+    if ((mcb[MCB_SIGNATURE] != 'M' && mcb[MCB_SIGNATURE] != 'Z') || dos_host_mcb_word(mcb, MCB_OWNER) == 0) {
+        dos_last_error_set(DOS_INVALID_MEMORY_BLOCK_ADDRESS, __func__, NULL, segment);
+        return DOS_INVALID_MEMORY_BLOCK_ADDRESS;
+    }
+    dos_host_mcb_set(mcb, (char)mcb[MCB_SIGNATURE], 0, dos_host_mcb_word(mcb, MCB_SIZE));
+    return DOS_SUCCESS;
+}
+
+#endif
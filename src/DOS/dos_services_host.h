@@ -0,0 +1,68 @@
+/**
+ * @file dos_services_host.h
+ * @brief Host (POSIX) backend for the DOS services API
+ * @defgroup dos_services_host DOS Services Host Backend
+ * @{
+ *
+ * When the tree is built without __DOS__ (see DOPE_HOST in CMakeLists.txt) the
+ * inline INT 21h wrappers are replaced by DOS/\*_host.c, which implement the same
+ * dos_* functions on POSIX so the arena, loaders and file layers build, run and
+ * benchmark natively.
+ *
+ * @details Emulation notes:
+ * @code
+ * | Service            | Host implementation                                    |
+ * |--------------------|--------------------------------------------------------|
+ * | 25h/35h vectors    | 256 entry table, nothing is ever called through it     |
+ * | 48h/49h memory     | 640KB simulated conventional memory with an MCB chain  |
+ * | 36h free space     | statvfs() folded into 32KB clusters, capped at 2GB     |
+ * | 3Ch-43h files      | open/read/write/lseek/unlink/chmod, errno -> DOS codes |
+ * | 4400h IOCTL        | fstat(), disk files report drive C:                    |
+ * | 4Eh/4Fh find       | opendir/readdir + fnmatch, state kept in the record    |
+ * | 5Ch locks          | fcntl() open file description (or process) locks       |
+ * | 59h extended error | built from the last error record                       |
+ * @endcode
+ *
+ * @note Sharing mode bits of dos_open_file() are accepted but not enforced - POSIX has no deny modes.
+ */
+#ifndef DOS_SERVICES_HOST_H
+#define DOS_SERVICES_HOST_H
+
+#include <stdint.h>
+
+#include "dos_services_types.h"
+
+#define DOS_HOST_FIRST_SEGMENT  0x0800  // segment of the first simulated MCB (where a small program's free memory begins)
+#define DOS_HOST_LAST_SEGMENT   0xA000  // top of conventional memory
+#define DOS_HOST_PSP_SEGMENT    0x0700  // owner stamped into allocated MCBs
+
+/**
+ * @brief Converts a simulated segment to a host pointer
+ * @param segment Segment in [DOS_HOST_FIRST_SEGMENT, DOS_HOST_LAST_SEGMENT)
+ * @return Host address of segment:0000 or NULL if out of range
+ */
+char* dos_host_segment_to_pointer(uint16_t segment);
+
+/**
+ * @brief Converts a host pointer inside simulated memory back to its segment
+ * @param ptr Paragraph aligned host address
+ * @return Segment or 0 if ptr is outside simulated memory
+ */
+uint16_t dos_host_pointer_to_segment(const void* ptr);
+
+/**
+ * @brief Size of the largest free block in simulated memory
+ * @return Paragraphs (what INT 21,48 returns in BX on failure)
+ */
+uint16_t dos_host_largest_free_block();
+
+/**
+ * @brief Translates a POSIX errno value to the nearest DOS error code
+ * @param err errno value
+ * @return DOS error code
+ */
+dos_error_code_t dos_host_error_code(int err);
+
+#endif
+
+/** @} */ // end of dos_services_host group
@@ -7,16 +7,30 @@
 #define TEST_DOS_SERVICES_H
 
 #include "dos_services.h"
+#include "dos_error_messages.h"
+#include "dos_last_error.h"
+#include "dos_services_3x.h"
+#include "dos_services_files.h"
+#include "dos_services_files_constants.h"
 #include "../TDD/tdd_macros.h"
 #include "../MEM/mem_tools.h"
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 
 #define DOS_SERVICES_TESTS &test_set_get_interrupt_vector,  \
     &test_memory_allocation_basic,                          \
     &test_memory_allocation_edge_cases,                     \
     &test_memory_free_operations,                           \
-    &test_memory_exhaustion
+    &test_memory_exhaustion,                                \
+    &test_last_error_record,                                \
+    &test_last_error_path,                                  \
+    &test_file_preallocate,                                 \
+    &test_file_region_locks,                                \
+    &test_file_date_time,                                   \
+    &test_find_first_next
+
+#define TEST_DOS_FILE_NAME  "TSTDOS.BIN"    /* scratch file in the current directory */
 
 /**
  * @brief Test interrupt vector manipulation
@@ -125,4 +139,202 @@ TEST(test_memory_exhaustion)
 
 }
 
+/**
+ * @brief Last error record tests
+ * @details Verifies:
+ * - Failed calls record code, function and argument
+ * - Successful calls leave the record untouched
+ * - Clearing resets the record
+ */
+TEST(test_last_error_record)
+{
+    dos_last_error_clear();
+    EXPECT(dos_last_error_code() == DOS_SUCCESS);
+
+    /* Failed allocation records the largest available block */
+    uint16_t largest_block = mem_max_paragraphs();
+    dos_last_error_clear();
+    EXPECT(dos_allocate_memory_blocks(largest_block + 1) == 0);
+    EXPECT(dos_last_error_code() == DOS_INSUFFICIENT_MEMORY);
+    EXPECT(dos_last_error()->argument == largest_block);
+    V(dos_last_error_dump(stdout););
+
+    /* Success does not overwrite the record */
+    uint16_t block = dos_allocate_memory_blocks(16);
+    ASSERT(block != 0);
+    EXPECT(dos_last_error_code() == DOS_INSUFFICIENT_MEMORY);
+    EXPECT(dos_free_allocated_memory_blocks(block) == 0);
+
+    dos_last_error_clear();
+    EXPECT(dos_last_error_code() == DOS_SUCCESS);
+    EXPECT(dos_last_error()->function == NULL);
+}
+
+/**
+ * @brief Last error path copy tests
+ * @details Verifies:
+ * - The record keeps its own copy of the path
+ * - Paths longer than DOS allows are truncated
+ * - No path and clearing give an empty path
+ */
+TEST(test_last_error_path)
+{
+    char path_name[DOS_LAST_ERROR_PATH_SIZE * 2];
+    strcpy(path_name, "NOFILE.TXT");
+    dos_last_error_clear();
+    EXPECT(dos_open_file(path_name, ACCESS_READ_ONLY) == 0);
+    strcpy(path_name, "REUSED.TXT");
+    EXPECT(strcmp(dos_last_error()->path_name, "NOFILE.TXT") == 0);
+
+    memset(path_name, 'A', sizeof(path_name) - 1);
+    path_name[sizeof(path_name) - 1] = '\0';
+    dos_last_error_set(DOS_PATH_NOT_FOUND, __func__, path_name, 0);
+    EXPECT(strlen(dos_last_error()->path_name) == DOS_LAST_ERROR_PATH_SIZE - 1);
+
+    dos_last_error_set(DOS_ACCESS_DENIED, __func__, NULL, 0);
+    EXPECT(dos_last_error()->path_name[0] == '\0');
+    dos_last_error_set(DOS_PATH_NOT_FOUND, __func__, "X.TXT", 0);
+    dos_last_error_clear();
+    EXPECT(dos_last_error()->path_name[0] == '\0');
+}
+
+/**
+ * @brief File preallocation and device information tests
+ * @details Verifies:
+ * - A new file is a disk file that has not been written
+ * - Preallocation grows the file to the requested size in one step
+ * - The file pointer is left where it was
+ * - A file already big enough is not shrunk
+ */
+TEST(test_file_preallocate)
+{
+    dos_file_handle_t fhandle = dos_create_file(TEST_DOS_FILE_NAME, CREATE_READ_WRITE);
+    ASSERT(fhandle != 0);
+
+    dos_file_device_info_t info = dos_get_device_information(fhandle);
+    EXPECT(!(info & DOS_DEVICE_INFO_IS_DEVICE));
+    EXPECT(info & DOS_DEVICE_INFO_NOT_WRITTEN);
+
+    EXPECT(dos_file_preallocate(fhandle, 4096) == DOS_SUCCESS);
+    EXPECT(dos_move_file_pointer(fhandle, 0, FSEEK_CUR) == 0);
+    EXPECT(dos_move_file_pointer(fhandle, 0, FSEEK_END) == 4096);
+    EXPECT(!(dos_get_device_information(fhandle) & DOS_DEVICE_INFO_NOT_WRITTEN));
+
+    /* Smaller requests and zero leave the file alone */
+    EXPECT(dos_file_preallocate(fhandle, 100) == DOS_SUCCESS);
+    EXPECT(dos_file_preallocate(fhandle, 0) == DOS_SUCCESS);
+    EXPECT(dos_move_file_pointer(fhandle, 0, FSEEK_END) == 4096);
+
+    EXPECT(dos_close_file(fhandle) == DOS_SUCCESS);
+    EXPECT(dos_delete_file(TEST_DOS_FILE_NAME) == DOS_SUCCESS);
+}
+
+/**
+ * @brief INT 21,5C region lock tests (needs SHARE under DOS)
+ * @details Verifies, with two handles on one shared file:
+ * - A locked region cannot be locked through the other handle
+ * - Disjoint regions lock independently
+ * - Unlocking releases the region to the other handle
+ */
+TEST(test_file_region_locks)
+{
+    dos_file_handle_t fhandle = dos_create_file(TEST_DOS_FILE_NAME, CREATE_READ_WRITE);
+    ASSERT(fhandle != 0);
+    EXPECT(dos_write_file(fhandle, "0123456789ABCDEF", 16) == 16);
+    EXPECT(dos_close_file(fhandle) == DOS_SUCCESS);
+
+    dos_file_handle_t first = dos_open_file(TEST_DOS_FILE_NAME, (dos_file_access_attributes_t)(ACCESS_READ_WRITE | SHARE_FULL));
+    dos_file_handle_t second = dos_open_file(TEST_DOS_FILE_NAME, (dos_file_access_attributes_t)(ACCESS_READ_WRITE | SHARE_FULL));
+    ASSERT(first != 0 && second != 0);
+
+    EXPECT(dos3x_lock_file_region(first, 4, 4) == DOS_SUCCESS);
+    dos_last_error_clear();
+    EXPECT(dos3x_lock_file_region(second, 6, 4) == DOS_LOCK_VIOLATION);
+    EXPECT(dos_last_error_code() == DOS_LOCK_VIOLATION);
+    EXPECT(dos3x_lock_file_region(second, 8, 4) == DOS_SUCCESS);
+
+    EXPECT(dos3x_unlock_file_region(first, 4, 4) == DOS_SUCCESS);
+    EXPECT(dos3x_lock_file_region(second, 0, 8) == DOS_SUCCESS);
+    EXPECT(dos3x_unlock_file_region(second, 0, 8) == DOS_SUCCESS);
+    EXPECT(dos3x_unlock_file_region(second, 8, 4) == DOS_SUCCESS);
+
+    EXPECT(dos_close_file(first) == DOS_SUCCESS);
+    EXPECT(dos_close_file(second) == DOS_SUCCESS);
+    EXPECT(dos_delete_file(TEST_DOS_FILE_NAME) == DOS_SUCCESS);
+}
+
+/**
+ * @brief INT 21,5700 file date and time tests
+ * @details Verifies:
+ * - The stamp of a new file decodes to a valid FAT date and time
+ * - Reading it again without a write gives the same stamp
+ * - A bad handle fails and is recorded
+ */
+TEST(test_file_date_time)
+{
+    dos_file_handle_t fhandle = dos_create_file(TEST_DOS_FILE_NAME, CREATE_READ_WRITE);
+    ASSERT(fhandle != 0);
+    EXPECT(dos_write_file(fhandle, "stamp", 5) == 5);
+
+    dos_file_date_time_t stamp, again;
+    EXPECT(dos_get_file_date_time(fhandle, &stamp) == DOS_SUCCESS);
+    V(printf("File stamp: %04X %04X\n", stamp.date, stamp.time););
+    EXPECT((stamp.time >> 11) < 24);
+    EXPECT(((stamp.time >> 5) & 0x3F) < 60);
+    EXPECT((stamp.time & 0x1F) < 30);
+    EXPECT(((stamp.date >> 5) & 0x0F) >= 1 && ((stamp.date >> 5) & 0x0F) <= 12);
+    EXPECT((stamp.date & 0x1F) >= 1);
+
+    EXPECT(dos_get_file_date_time(fhandle, &again) == DOS_SUCCESS);
+    EXPECT(again.date == stamp.date && again.time == stamp.time);
+
+    EXPECT(dos_close_file(fhandle) == DOS_SUCCESS);
+    EXPECT(dos_delete_file(TEST_DOS_FILE_NAME) == DOS_SUCCESS);
+
+    dos_last_error_clear();
+    EXPECT(dos_get_file_date_time(0xFFFF, &stamp) != DOS_SUCCESS);
+    EXPECT(dos_last_error_code() != DOS_SUCCESS);
+}
+
+/**
+ * @brief INT 21,4E/4F directory search tests
+ * @details Verifies:
+ * - A wildcard search returns every matching file exactly once, with its size
+ * - The search ends with DOS_NO_MORE_FILES
+ * - A template nothing matches fails on the find first
+ */
+TEST(test_find_first_next)
+{
+    char name[DOS_FILE_NAME_SIZE] = "TSTFND1.TMP";
+    uint8_t i;
+    for (i = 1; i <= 3; ++i) {
+        name[6] = (char)('0' + i);
+        dos_file_handle_t fhandle = dos_create_file(name, CREATE_READ_WRITE);
+        ASSERT(fhandle != 0);
+        EXPECT(dos_write_file(fhandle, "123", i) == i);
+        EXPECT(dos_close_file(fhandle) == DOS_SUCCESS);
+    }
+
+    dos_file_find_t entry;
+    uint8_t seen = 0;
+    dos_error_code_t err_code = dos_find_first("TSTFND?.TMP", 0, &entry);
+    while (err_code == DOS_SUCCESS) {
+        V(printf("Found %s %lu bytes\n", entry.name, (unsigned long)entry.size););
+        EXPECT(strlen(entry.name) == 11 && entry.name[6] >= '1' && entry.name[6] <= '3');
+        EXPECT(entry.size == (uint32_t)(entry.name[6] - '0'));
+        EXPECT(!(entry.attributes & DOS_FILE_ATTRIBUTE_DIRECTORY));
+        seen |= (uint8_t)(1 << (entry.name[6] - '0'));
+        err_code = dos_find_next(&entry);
+    }
+    EXPECT(err_code == DOS_NO_MORE_FILES);
+    EXPECT(seen == 0x0E);
+
+    EXPECT(dos_find_first("TSTNON?.TMP", 0, &entry) != DOS_SUCCESS);
+
+    for (i = 1; i <= 3; ++i) {
+        name[6] = (char)('0' + i);
+        EXPECT(dos_delete_file(name) == DOS_SUCCESS);
+    }
+}
+
 #endif
@@ -1,7 +1,7 @@
 #ifndef FILE_CONSTANTS_H
 #define FILE_CONSTANTS_H
 
-const char FILE_EXTENSION_DELIM = '.';
+static const char FILE_EXTENSION_DELIM = '.';
 
 #define FILE_MAX_LINE_SIZE  80  // 80 chars
 #define FILE_MAX_PAGE_SIZE  99  // 99 lines
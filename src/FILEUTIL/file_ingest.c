@@ -0,0 +1,190 @@
+#include "file_ingest.h"
+#include "file_prefetch.h"
+#include "../CONTRACT/contract.h"
+#include "../DOS/dos_error_messages.h"
+#include "../DOS/dos_last_error.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#ifndef __DOS__
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+typedef struct {
+    struct private_file_ingest_t* ingest;
+    mem_arena_t* lines;
+    mem_arena_t* scratch;
+#ifndef __DOS__
+    pthread_t thread;
+#endif
+} file_ingest_worker_t;
+
+typedef struct private_file_ingest_t {
+    mem_arena_t* arena;
+    file_ingest_worker_t workers[FILE_INGEST_MAX_WORKERS];
+    uint8_t worker_count;
+    const char* const* path_names;  ///< Current run
+    file_ingest_result_t* results;
+    uint16_t count;
+    uint16_t next;                  ///< Next unclaimed path
+#ifndef __DOS__
+    pthread_mutex_t lock;
+#endif
+} file_ingest_t;
+
+/**
+ * @brief Reads one file into its result slot
+ */
+static void file_ingest_file(file_ingest_worker_t* worker, file_ingest_result_t* result) {
+    mem_size_t used = mem_arena_used(worker->scratch);
+    if (used) {
+        mem_arena_dealloc(worker->scratch, used);
+    }
+    dos_last_error_clear();
+    file_prefetch_t* prefetch = file_prefetch_open(worker->scratch, result->path_name, FILE_INGEST_BUFFER_SIZE);
+    if (!prefetch) {
+        result->err_code = dos_last_error_code();
+        return;
+    }
+    while (result->page.line_count < FILE_MAX_PAGE_SIZE) {
+        line_t* line = file_prefetch_next_line(worker->lines, prefetch);
+        if (!line) {
+            break;
+        }
+        result->page.lines[result->page.line_count++] = line;
+    }
+    if (result->page.line_count == FILE_MAX_PAGE_SIZE) {
+        line_t* overflow = file_prefetch_next_line(worker->scratch, prefetch);
+        result->truncated = overflow != NULL;
+    }
+    result->err_code = file_prefetch_error(prefetch);
+    if (!result->err_code && !result->page.line_count) {
+        result->err_code = DOS_INVALID_DATA;
+    }
+    file_prefetch_close(prefetch);
+}
+
+/**
+ * @brief Claims the next path of the run, false when none are left
+ */
+static bool file_ingest_claim(file_ingest_t* ingest, uint16_t* index) {
+#ifndef __DOS__
+    pthread_mutex_lock(&ingest->lock);
+#endif
+    bool claimed = ingest->next < ingest->count;
+    if (claimed) {
+        *index = ingest->next++;
+    }
+#ifndef __DOS__
+    pthread_mutex_unlock(&ingest->lock);
+#endif
+    return claimed;
+}
+
+static void* file_ingest_worker(void* context) {
+    file_ingest_worker_t* worker = (file_ingest_worker_t*)context;
+    uint16_t index;
+    while (file_ingest_claim(worker->ingest, &index)) {
+        file_ingest_file(worker, &worker->ingest->results[index]);
+    }
+    return NULL;
+}
+
+file_ingest_t* file_ingest_create(mem_arena_t* arena, uint8_t workers, mem_size_t worker_arena_size) {
+    require_address(arena, "NULL memory arena!");
+    require(worker_arena_size > 0, "ZERO worker arena size!");
+
+#ifndef __DOS__
+    if (!workers) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = (uint8_t)(cpus > FILE_INGEST_MAX_WORKERS ? FILE_INGEST_MAX_WORKERS : cpus > 0 ? cpus : 1);
+    }
+#else
+    workers = 1;                                    // no threads under DOS
+#endif
+    require_range(workers <= FILE_INGEST_MAX_WORKERS, "Too many ingest workers!");
+
+    file_ingest_t* ingest = (file_ingest_t*)mem_arena_alloc_aligned(arena, sizeof(file_ingest_t), sizeof(void*) * 2);
+    require_mem(ingest, "NULL ingest pool - arena alloc fail!");
+    memset(ingest, 0, sizeof(file_ingest_t));
+    ingest->arena = arena;
+    ingest->worker_count = workers;
+    uint8_t i;
+    for (i = 0; i < workers; ++i) {
+        ingest->workers[i].ingest = ingest;
+        ingest->workers[i].lines = mem_arena_create(MEM_ARENA_POLICY_C, worker_arena_size);
+        ingest->workers[i].scratch = mem_arena_create(MEM_ARENA_POLICY_C, FILE_INGEST_BUFFER_SIZE * 2 + MEM_SIZE_1K);
+        require_mem(ingest->workers[i].lines && ingest->workers[i].scratch, "NULL worker arena - create fail!");
+    }
+#ifndef __DOS__
+    pthread_mutex_init(&ingest->lock, NULL);
+#endif
+    return ingest;
+}
+
+file_ingest_result_t* file_ingest_run(file_ingest_t* ingest, const char* const* path_names, uint16_t count) {
+    require_address(ingest, "NULL ingest pool!");
+    require_address(path_names, "NULL path names!");
+
+    file_ingest_result_t* results = (file_ingest_result_t*)mem_arena_calloc(ingest->arena, (mem_size_t)count * sizeof(file_ingest_result_t) + 1);
+    require_mem(results, "NULL ingest results - arena alloc fail!");
+    uint16_t i;
+    for (i = 0; i < count; ++i) {
+        require_address(path_names[i], "NULL path name!");
+        results[i].path_name = path_names[i];
+    }
+    ingest->path_names = path_names;
+    ingest->results = results;
+    ingest->count = count;
+    ingest->next = 0;
+
+#ifndef __DOS__
+    uint8_t started = ingest->worker_count < count ? ingest->worker_count : (uint8_t)count;
+    uint8_t w;
+    for (w = 0; w < started; ++w) {
+        require_not_busy(pthread_create(&ingest->workers[w].thread, NULL, file_ingest_worker, &ingest->workers[w]) == 0,
+                         "Ingest worker create fail!");
+    }
+    for (w = 0; w < started; ++w) {
+        pthread_join(ingest->workers[w].thread, NULL);
+    }
+#else
+    file_ingest_worker(&ingest->workers[0]);
+#endif
+    return results;
+}
+
+void file_ingest_reset(file_ingest_t* ingest) {
+    require_address(ingest, "NULL ingest pool!");
+
+    uint8_t i;
+    for (i = 0; i < ingest->worker_count; ++i) {
+        mem_size_t used = mem_arena_used(ingest->workers[i].lines);
+        if (used) {
+            mem_arena_dealloc(ingest->workers[i].lines, used);
+        }
+    }
+}
+
+uint8_t file_ingest_workers(const file_ingest_t* ingest) {
+    require_address(ingest, "NULL ingest pool!");
+    return ingest->worker_count;
+}
+
+void file_ingest_delete(file_ingest_t* ingest) {
+    require_address(ingest, "NULL ingest pool!");
+
+    uint8_t i;
+    for (i = 0; i < ingest->worker_count; ++i) {
+        mem_arena_delete(ingest->workers[i].lines);
+        mem_arena_delete(ingest->workers[i].scratch);
+        ingest->workers[i].lines = NULL;
+        ingest->workers[i].scratch = NULL;
+    }
+#ifndef __DOS__
+    pthread_mutex_destroy(&ingest->lock);
+#endif
+    ingest->worker_count = 0;
+}
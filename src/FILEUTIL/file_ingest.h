@@ -0,0 +1,91 @@
+/**
+ * @file file_ingest.h
+ * @brief Multi-file ingest: a worker pool reads and line-splits files into pages
+ * @defgroup file_ingest File Ingest
+ * @{
+ */
+#ifndef FILE_INGEST_H
+#define FILE_INGEST_H
+
+#include <stdint.h>
+
+#include "file_types.h"
+#include "../DOS/dos_services_types.h"
+#include "../MEM/mem_arena.h"
+#include "../MEM/mem_constants.h"
+
+#define FILE_INGEST_MAX_WORKERS     16
+#define FILE_INGEST_BUFFER_SIZE     MEM_SIZE_4K     ///< Per-file prefetch buffer
+
+/**
+ * @brief One ingested file, exactly what file_read_page() would have produced
+ *
+ * @details A file that fails part way keeps the lines read before the failure, with
+ * err_code saying why it stopped. Neither case stops the other files of the run.
+ */
+typedef struct {
+    const char* path_name;
+    page_t page;                    ///< Lines live in the arena of the worker that read the file
+    dos_error_code_t err_code;      ///< DOS_SUCCESS, the open/read error, DOS_INSUFFICIENT_MEMORY when the worker's
+                                    ///< lines arena filled, or DOS_INVALID_DATA for an empty file
+    uint8_t truncated;              ///< 1 = file had more than FILE_MAX_PAGE_SIZE lines
+} file_ingest_result_t;
+
+/**
+ * @brief Opaque ingest pool
+ *
+ * @details Each worker owns two C-policy arenas, so workers never contend on allocation:
+ * @code
+ * | Arena   | Holds                                 | Lifetime                  |
+ * |---------|---------------------------------------|---------------------------|
+ * | lines   | line_t of every page the worker read  | until file_ingest_reset   |
+ * | scratch | prefetch buffers of the current file  | reset after every file    |
+ * @endcode
+ * Lines pile up across runs, so a caller that is done with one run's pages calls
+ * file_ingest_reset() before the next run to get the full worker_arena_size back.
+ * Workers claim the next unread path from a shared counter and write its result to
+ * that path's slot, so results come back in submission order whatever finishes first.
+ * DOS builds run the same code on the calling thread with one worker.
+ */
+typedef struct private_file_ingest_t file_ingest_t;
+
+/**
+ * @brief Creates the pool and its worker arenas
+ * @param arena Arena for the pool and run results
+ * @param workers Worker count, 0 = one per online CPU (capped at FILE_INGEST_MAX_WORKERS)
+ * @param worker_arena_size Bytes of lines each worker may hold until file_ingest_reset()
+ * @return Pool handle
+ */
+file_ingest_t* file_ingest_create(mem_arena_t* arena, uint8_t workers, mem_size_t worker_arena_size);
+
+/**
+ * @brief Reads a batch of files concurrently
+ * @param ingest Pool handle
+ * @param path_names Files to read
+ * @param count Number of files
+ * @return count results in submission order, allocated from the pool's arena
+ */
+file_ingest_result_t* file_ingest_run(file_ingest_t* ingest, const char* const* path_names, uint16_t count);
+
+/**
+ * @brief Empties the worker lines arenas, invalidating every page returned so far
+ * @param ingest Pool handle
+ *
+ * @note Results stay in the pool's arena, only their pages go
+ */
+void file_ingest_reset(file_ingest_t* ingest);
+
+/**
+ * @brief Gets the number of workers
+ */
+uint8_t file_ingest_workers(const file_ingest_t* ingest);
+
+/**
+ * @brief Deletes the worker arenas, invalidating every page returned
+ * @param ingest Pool handle
+ */
+void file_ingest_delete(file_ingest_t* ingest);
+
+#endif
+
+/** @} */ // end of file_ingest group
@@ -0,0 +1,323 @@
+#include "file_line_index.h"
+#include "file_constants.h"
+#include "file_prefetch.h"
+#include "file_utils.h"
+#include "../CONTRACT/contract.h"
+#include "../DOS/dos_error_messages.h"
+#include "../DOS/dos_last_error.h"
+#include "../DOS/dos_services_files.h"
+#include "../STRUTIL/str_scan.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#define FILE_LINE_INDEX_STAGING 64  // encoded deltas batched per arena append
+#define FILE_LINE_INDEX_IO_MAX  0xFFF0U
+
+/**
+ * @brief Size and last write stamp of an open file, position left at the start
+ */
+static void file_line_index_identify(dos_file_handle_t fhandle, file_line_index_header_t* header) {
+    memcpy(header->magic, FILE_LINE_INDEX_MAGIC, sizeof(header->magic));
+    header->file_size = (dos_file_size_t)dos_move_file_pointer(fhandle, 0, FSEEK_END);
+    dos_move_file_pointer(fhandle, 0, FSEEK_SET);
+    dos_get_file_date_time(fhandle, &header->stamp);
+}
+
+/**
+ * @brief Appends encoded deltas directly after the previous append
+ */
+static void file_line_index_append(mem_arena_t* arena, file_line_index_t* index, const uint8_t* bytes, uint16_t nbytes) {
+    if (!nbytes) return;
+    uint8_t* dest = (uint8_t*)mem_arena_alloc(arena, nbytes);
+    require_mem(dest, "NULL line index deltas - arena alloc fail!");
+    if (!index->deltas) {
+        index->deltas = dest;
+    }
+    ensure(dest == index->deltas + index->header.delta_bytes, "Line index deltas not contiguous!");
+    memcpy(dest, bytes, nbytes);
+    index->header.delta_bytes += nbytes;
+}
+
+static uint16_t file_line_index_encode(uint8_t* out, uint32_t delta) {
+    uint16_t n = 0;
+    while (delta >= 0x80) {
+        out[n++] = (uint8_t)(delta | 0x80);
+        delta >>= 7;
+    }
+    out[n++] = (uint8_t)delta;
+    return n;
+}
+
+/**
+ * @brief Decodes the delta at position, 0 if it runs past end or is too long to be one
+ */
+static uint32_t file_line_index_decode(const uint8_t* deltas, uint32_t end, uint32_t* position) {
+    uint32_t delta = 0;
+    uint8_t shift = 0;
+    uint8_t byte;
+    do {
+        if (*position >= end || shift > 28) {
+            return 0;                               // a real delta is never 0
+        }
+        byte = deltas[(*position)++];
+        delta |= (uint32_t)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return delta;
+}
+
+/**
+ * @brief Rebuilds the in-memory checkpoints from the delta stream
+ * @return false if the arena is full, or the deltas do not describe line_count
+ *         lines of the file in exactly delta_bytes bytes
+ */
+static bool file_line_index_checkpoint(mem_arena_t* arena, file_line_index_t* index) {
+    uint32_t count = (index->header.line_count + FILE_LINE_INDEX_CHECKPOINT - 1) / FILE_LINE_INDEX_CHECKPOINT;
+    index->checkpoints = (uint32_t*)mem_arena_alloc_aligned(arena, (count ? count : 1) * sizeof(uint32_t), sizeof(uint32_t));
+    index->checkpoint_positions = (uint32_t*)mem_arena_alloc_aligned(arena, (count ? count : 1) * sizeof(uint32_t), sizeof(uint32_t));
+    if (!index->checkpoints || !index->checkpoint_positions) {
+        return false;
+    }
+
+    uint32_t offset = 0;
+    uint32_t position = 0;
+    uint32_t line;
+    for (line = 0; line < index->header.line_count; ++line) {
+        if (line % FILE_LINE_INDEX_CHECKPOINT == 0) {
+            index->checkpoints[line / FILE_LINE_INDEX_CHECKPOINT] = offset;
+            index->checkpoint_positions[line / FILE_LINE_INDEX_CHECKPOINT] = position;
+        }
+        if (line + 1 < index->header.line_count) {
+            uint32_t delta = file_line_index_decode(index->deltas, index->header.delta_bytes, &position);
+            if (!delta || delta >= index->header.file_size - offset) {
+                return false;                       // every line starts inside the file
+            }
+            offset += delta;
+        }
+    }
+    return position == index->header.delta_bytes;
+}
+
+file_line_index_t* file_line_index_build(mem_arena_t* arena, const char* path_name) {
+    require_address(arena, "NULL memory arena!");
+    require_address(path_name, "NULL path name!");
+
+    file_line_index_t* index = (file_line_index_t*)mem_arena_calloc(arena, sizeof(file_line_index_t));
+    require_mem(index, "NULL line index - arena alloc fail!");
+
+    dos_last_error_clear();
+    dos_file_handle_t fhandle = dos_open_file(path_name, ACCESS_READ_ONLY | DENY_WRITE);
+    if (!fhandle) {
+        return NULL;
+    }
+    file_line_index_identify(fhandle, &index->header);
+    dos_close_file(fhandle);
+    dos_file_size_t size = index->header.file_size;
+
+    // the scan of one buffer overlaps the read of the next; the deltas follow the buffers in the arena
+    file_prefetch_t* prefetch = file_prefetch_open(arena, path_name, FILE_LINE_INDEX_BUFFER_SIZE);
+    if (!prefetch) {
+        return NULL;
+    }
+
+    uint8_t staging[FILE_LINE_INDEX_STAGING];
+    uint16_t staged = 0;
+    uint32_t previous_start = 0;
+    uint32_t position = 0;
+    index->header.line_count = size ? 1 : 0;
+    const char* buffer;
+    uint16_t bytes_read;
+    while ((buffer = file_prefetch_next(prefetch, &bytes_read)) != NULL) {
+        const char* cursor = buffer;
+        const char* end = buffer + bytes_read;
+        const char* newline;
+        while ((newline = str_scan_byte(cursor, (size_t)(end - cursor), '\n')) != NULL) {
+            uint32_t start = position + (uint32_t)(newline - buffer) + 1;
+            if (start < size) {                     // a final '\n' does not start a line
+                if (staged > FILE_LINE_INDEX_STAGING - 5) {
+                    file_line_index_append(arena, index, staging, staged);
+                    staged = 0;
+                }
+                staged += file_line_index_encode(staging + staged, start - previous_start);
+                previous_start = start;
+                ++index->header.line_count;
+            }
+            cursor = newline + 1;
+        }
+        position += bytes_read;
+    }
+    dos_error_code_t err_code = file_prefetch_error(prefetch);
+    file_prefetch_close(prefetch);
+    if (err_code) {
+        dos_last_error_set(err_code, __func__, path_name, position);    // the read failed on the filler thread
+        return NULL;
+    }
+    file_line_index_append(arena, index, staging, staged);
+
+    require_mem(file_line_index_checkpoint(arena, index), "NULL line index checkpoints - arena alloc fail!");
+    return index;
+}
+
+void file_line_index_sidecar_path(const char* path_name, char* sidecar) {
+    file_replace_extension(path_name, FILE_LINE_INDEX_EXTENSION, sidecar, FILE_LINE_INDEX_MAX_PATH);
+}
+
+/**
+ * @brief Closes a rejected sidecar and gives back what loading it took
+ */
+static file_line_index_t* file_line_index_reject(mem_arena_t* arena, mem_size_t used, dos_file_handle_t fhandle) {
+    dos_close_file(fhandle);
+    mem_size_t taken = mem_arena_used(arena) - used;
+    if (taken) {
+        mem_arena_dealloc(arena, taken);
+    }
+    return NULL;
+}
+
+file_line_index_t* file_line_index_load(mem_arena_t* arena, const char* path_name) {
+    require_address(arena, "NULL memory arena!");
+    require_address(path_name, "NULL path name!");
+
+    file_line_index_header_t current;
+    dos_file_handle_t fhandle = dos_open_file(path_name, ACCESS_READ_ONLY | DENY_WRITE);
+    if (!fhandle) {
+        return NULL;
+    }
+    file_line_index_identify(fhandle, &current);
+    dos_close_file(fhandle);
+
+    char sidecar[FILE_LINE_INDEX_MAX_PATH];
+    file_line_index_sidecar_path(path_name, sidecar);
+    fhandle = dos_open_file(sidecar, ACCESS_READ_ONLY | DENY_WRITE);
+    if (!fhandle) {
+        return NULL;
+    }
+    mem_size_t used = mem_arena_used(arena);
+    uint32_t sidecar_size = (uint32_t)dos_move_file_pointer(fhandle, 0, FSEEK_END);
+    dos_move_file_pointer(fhandle, 0, FSEEK_SET);
+    file_line_index_t* index = (file_line_index_t*)mem_arena_calloc(arena, sizeof(file_line_index_t));
+    if (!index) {
+        return file_line_index_reject(arena, used, fhandle);
+    }
+    uint16_t bytes_read = dos_read_file(fhandle, (char*)&index->header, sizeof(file_line_index_header_t));
+    if (bytes_read != sizeof(file_line_index_header_t)
+        || memcmp(index->header.magic, current.magic, sizeof(current.magic)) != 0
+        || index->header.file_size != current.file_size
+        || index->header.stamp.date != current.stamp.date
+        || index->header.stamp.time != current.stamp.time
+        || index->header.delta_bytes != sidecar_size - sizeof(file_line_index_header_t)
+        || index->header.line_count > index->header.delta_bytes + 1
+        || !index->header.line_count != !index->header.file_size) {
+        return file_line_index_reject(arena, used, fhandle);   // missing, foreign, stale or damaged
+    }
+
+    index->deltas = (uint8_t*)mem_arena_alloc(arena, index->header.delta_bytes ? index->header.delta_bytes : 1);
+    if (!index->deltas) {
+        return file_line_index_reject(arena, used, fhandle);   // no room: the caller builds instead
+    }
+    uint32_t loaded = 0;
+    while (loaded < index->header.delta_bytes) {
+        uint32_t remaining = index->header.delta_bytes - loaded;
+        uint16_t nbytes = remaining < FILE_LINE_INDEX_IO_MAX ? (uint16_t)remaining : FILE_LINE_INDEX_IO_MAX;
+        if (dos_read_file(fhandle, (char*)index->deltas + loaded, nbytes) != nbytes) {
+            return file_line_index_reject(arena, used, fhandle);   // truncated sidecar
+        }
+        loaded += nbytes;
+    }
+    if (!file_line_index_checkpoint(arena, index)) {
+        return file_line_index_reject(arena, used, fhandle);
+    }
+    dos_close_file(fhandle);
+    return index;
+}
+
+dos_error_code_t file_line_index_save(const file_line_index_t* index, const char* path_name) {
+    require_address(index, "NULL line index!");
+    require_address(path_name, "NULL path name!");
+
+    char sidecar[FILE_LINE_INDEX_MAX_PATH];
+    file_line_index_sidecar_path(path_name, sidecar);
+    dos_last_error_clear();
+    dos_file_handle_t fhandle = dos_create_file(sidecar, CREATE_READ_WRITE);
+    if (!fhandle) {
+        return dos_last_error_code();
+    }
+    dos_error_code_t err_code = dos_file_preallocate(fhandle, sizeof(file_line_index_header_t) + index->header.delta_bytes);
+    if (!err_code && dos_write_file(fhandle, (const char*)&index->header, sizeof(file_line_index_header_t)) != sizeof(file_line_index_header_t)) {
+        err_code = dos_last_error_code() ? dos_last_error_code() : DOS_INSUFFICIENT_DISK_SPACE;
+    }
+    uint32_t saved = 0;
+    while (!err_code && saved < index->header.delta_bytes) {
+        uint32_t remaining = index->header.delta_bytes - saved;
+        uint16_t nbytes = remaining < FILE_LINE_INDEX_IO_MAX ? (uint16_t)remaining : FILE_LINE_INDEX_IO_MAX;
+        if (dos_write_file(fhandle, (const char*)index->deltas + saved, nbytes) != nbytes) {
+            err_code = dos_last_error_code() ? dos_last_error_code() : DOS_INSUFFICIENT_DISK_SPACE;
+        }
+        saved += nbytes;
+    }
+    dos_close_file(fhandle);
+    if (err_code) {
+        dos_delete_file(sidecar);                   // never leave a half written sidecar behind
+    }
+    return err_code;
+}
+
+file_line_index_t* file_line_index_open(mem_arena_t* arena, const char* path_name) {
+    file_line_index_t* index = file_line_index_load(arena, path_name);
+    if (index) {
+        return index;
+    }
+    index = file_line_index_build(arena, path_name);
+    if (index) {
+        file_line_index_save(index, path_name);
+        dos_last_error_clear();                     // the sidecar is only a cache
+    }
+    return index;
+}
+
+/**
+ * @brief Offset of a line, leaving position at the delta of the line after it
+ */
+static uint32_t file_line_index_seek_delta(const file_line_index_t* index, uint32_t line, uint32_t* position) {
+    uint32_t offset = index->checkpoints[line / FILE_LINE_INDEX_CHECKPOINT];
+    uint32_t skip = line % FILE_LINE_INDEX_CHECKPOINT;
+    *position = index->checkpoint_positions[line / FILE_LINE_INDEX_CHECKPOINT];
+    while (skip--) {
+        offset += file_line_index_decode(index->deltas, index->header.delta_bytes, position);
+    }
+    return offset;
+}
+
+dos_file_position_t file_line_index_offset(const file_line_index_t* index, uint32_t line) {
+    require_address(index, "NULL line index!");
+    require_range(line < index->header.line_count, "Line number out of range!");
+
+    uint32_t position;
+    return (dos_file_position_t)file_line_index_seek_delta(index, line, &position);
+}
+
+uint16_t file_line_index_read_line(const file_line_index_t* index, dos_file_handle_t fhandle, uint32_t line, char* buffer, uint16_t capacity) {
+    require_address(index, "NULL line index!");
+    require_address(buffer, "NULL line buffer!");
+    require(capacity > 0, "ZERO buffer capacity!");
+    require_range(line < index->header.line_count, "Line number out of range!");
+
+    uint32_t position;
+    uint32_t start = file_line_index_seek_delta(index, line, &position);
+    uint32_t end = line + 1 < index->header.line_count
+                 ? start + file_line_index_decode(index->deltas, index->header.delta_bytes, &position)
+                 : index->header.file_size;
+    uint32_t length = end - start;
+    if (length > (uint32_t)(capacity - 1)) {
+        length = capacity - 1;
+    }
+
+    dos_move_file_pointer(fhandle, (dos_file_position_t)start, FSEEK_SET);
+    uint16_t bytes_read = dos_read_file(fhandle, buffer, (uint16_t)length);
+    while (bytes_read && (buffer[bytes_read - 1] == '\n' || buffer[bytes_read - 1] == '\r')) {
+        --bytes_read;
+    }
+    buffer[bytes_read] = '\0';
+    return bytes_read;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file file_line_index.h
+ * @brief Compact line offset index for random access to line N of large files
+ * @defgroup file_line_index File Line Index
+ * @{
+ */
+#ifndef FILE_LINE_INDEX_H
+#define FILE_LINE_INDEX_H
+
+#include <stdint.h>
+
+#include "../DOS/dos_services_files_types.h"
+#include "../DOS/dos_services_types.h"
+#include "../MEM/mem_arena.h"
+#include "../MEM/mem_constants.h"
+
+#define FILE_LINE_INDEX_MAGIC           "LIX1"
+#define FILE_LINE_INDEX_EXTENSION       "LIX"           ///< Sidecar replaces the file's extension
+#define FILE_LINE_INDEX_CHECKPOINT      64              ///< Lines between absolute offsets
+#define FILE_LINE_INDEX_BUFFER_SIZE     MEM_SIZE_16K    ///< Build read size
+#define FILE_LINE_INDEX_MAX_PATH        128
+
+/**
+ * @brief Sidecar header, also identifies the indexed file
+ */
+typedef struct {
+    char magic[4];
+    dos_file_size_t file_size;
+    dos_file_date_time_t stamp;         ///< Last write of the indexed file
+    uint32_t line_count;
+    uint32_t delta_bytes;
+} file_line_index_header_t;
+
+/**
+ * @brief Line offset index
+ *
+ * @details Offsets are stored as the distance from the previous line start, LEB128
+ * encoded, so typical source lines cost one byte each. Every FILE_LINE_INDEX_CHECKPOINT
+ * lines an absolute offset and its position in the delta stream are kept in memory,
+ * bounding a lookup to that many decodes:
+ * @code
+ * | Sidecar (PROG.LIX)                     | Memory only                          |
+ * |----------------------------------------|--------------------------------------|
+ * | header | delta[1] delta[2] ... delta[n]| checkpoints[] checkpoint_positions[] |
+ * @endcode
+ * The sidecar is only trusted when the file's size and last-write date/time still match
+ * and its deltas decode to exactly line_count lines inside the file.
+ */
+typedef struct {
+    file_line_index_header_t header;
+    uint8_t* deltas;
+    uint32_t* checkpoints;              ///< Offset of line k * FILE_LINE_INDEX_CHECKPOINT
+    uint32_t* checkpoint_positions;     ///< Delta stream position of the line after it
+} file_line_index_t;
+
+/**
+ * @brief Indexes a file in one pass
+ * @param arena Arena for the index and its two read buffers
+ * @param path_name File to index
+ * @return Index or NULL if the file cannot be read (see dos_last_error())
+ *
+ * @details Reads through file_prefetch, so on host builds the newline scan of one
+ * buffer runs while the next is read.
+ */
+file_line_index_t* file_line_index_build(mem_arena_t* arena, const char* path_name);
+
+/**
+ * @brief Loads the sidecar index of a file if it is still current
+ * @param arena Arena for the index
+ * @param path_name Indexed file (not the sidecar)
+ * @return Index or NULL if there is no sidecar, it is stale or damaged, or the arena is
+ *         full; nothing stays allocated then
+ */
+file_line_index_t* file_line_index_load(mem_arena_t* arena, const char* path_name);
+
+/**
+ * @brief Saves an index beside its file
+ * @param index Index to save
+ * @param path_name Indexed file (not the sidecar)
+ * @return DOS_SUCCESS or the failing call's error code
+ */
+dos_error_code_t file_line_index_save(const file_line_index_t* index, const char* path_name);
+
+/**
+ * @brief Loads a current sidecar, or builds the index and saves the sidecar
+ * @param arena Arena for the index
+ * @param path_name File to index
+ * @return Index or NULL if the file cannot be read
+ *
+ * @note A sidecar that cannot be written (read-only media) is not an error
+ */
+file_line_index_t* file_line_index_open(mem_arena_t* arena, const char* path_name);
+
+/**
+ * @brief Makes the sidecar path of a file: PROG.DOP -> PROG.LIX
+ * @param path_name Indexed file
+ * @param sidecar Receives the sidecar path (FILE_LINE_INDEX_MAX_PATH bytes)
+ */
+void file_line_index_sidecar_path(const char* path_name, char* sidecar);
+
+/**
+ * @brief Gets the byte offset of a line
+ * @param index Line index
+ * @param line 0-based line number (< line_count)
+ * @return Offset of the first byte of the line
+ */
+dos_file_position_t file_line_index_offset(const file_line_index_t* index, uint32_t line);
+
+/**
+ * @brief Reads one line with a single seek and a single read
+ * @param index Index of the open file
+ * @param fhandle Open handle of the indexed file
+ * @param line 0-based line number (< line_count)
+ * @param buffer Receives the line, NUL terminated, without its line ending
+ * @param capacity Size of buffer, longer lines are truncated
+ * @return Length of the line in buffer
+ */
+uint16_t file_line_index_read_line(const file_line_index_t* index, dos_file_handle_t fhandle, uint32_t line, char* buffer, uint16_t capacity);
+
+#endif
+
+/** @} */ // end of file_line_index group
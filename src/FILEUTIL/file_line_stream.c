@@ -0,0 +1,152 @@
+#include "file_line_stream.h"
+#include "../CONTRACT/contract.h"
+#include "../DOS/dos_error_messages.h"
+#include "../DOS/dos_last_error.h"
+#include "../STRUTIL/str_scan.h"
+
+#include <string.h>
+
+typedef struct private_file_line_stream_t {
+    mem_arena_t* arena;
+    file_source_t* source;
+    const char* chunk;          ///< Current read buffer
+    uint16_t chunk_length;
+    uint16_t chunk_position;    ///< Start of the next line in chunk
+    uint32_t line_number;
+    dos_error_code_t err_code;  ///< Why the stream ended early, DOS_SUCCESS at a plain end of file
+    bool eof;
+} file_line_stream_t;
+
+/**
+ * @brief Appends bytes to a line being stitched together in the arena
+ * @details Each append normally lands directly after the previous one. If something
+ *          else allocated from the arena in between - a plugged in source, say - the
+ *          line so far is copied up to join the new bytes, and its old copy stays behind.
+ * @return false if the arena is full: the line is too long to keep
+ */
+static bool file_line_stream_stitch(file_line_stream_t* stream, char** stitched, size_t* length, const char* bytes, size_t nbytes) {
+    if (!nbytes) return true;
+    char* dest = (char*)mem_arena_alloc(stream->arena, (mem_size_t)nbytes);
+    if (dest && *stitched && dest != *stitched + *length) {
+        mem_arena_dealloc(stream->arena, (mem_size_t)nbytes);
+        char* moved = (char*)mem_arena_alloc(stream->arena, (mem_size_t)(*length + nbytes));
+        if (moved) {
+            memcpy(moved, *stitched, *length);
+            *stitched = moved;
+            dest = moved + *length;
+        } else {
+            dest = NULL;
+        }
+    }
+    if (!dest) {
+        stream->err_code = DOS_INSUFFICIENT_MEMORY;
+        dos_last_error_set(DOS_INSUFFICIENT_MEMORY, __func__, NULL, (uint32_t)(*length + nbytes));
+        return false;
+    }
+    if (!*stitched) {
+        *stitched = dest;
+    }
+    memcpy(dest, bytes, nbytes);
+    *length += nbytes;
+    return true;
+}
+
+static void file_line_stream_view(file_line_stream_t* stream, file_line_view_t* line, const char* ptr, size_t length) {
+    if (length && ptr[length - 1] == '\r') {
+        --length;
+    }
+    line->ptr = ptr;
+    line->length = length;
+    ++stream->line_number;
+}
+
+file_line_stream_t* file_line_stream_create(mem_arena_t* arena, file_source_t* source) {
+    require_address(arena, "NULL memory arena!");
+    require_address(source, "NULL file source!");
+
+    file_line_stream_t* stream = (file_line_stream_t*)mem_arena_calloc(arena, sizeof(file_line_stream_t));
+    if (!stream) {
+        dos_last_error_set(DOS_INSUFFICIENT_MEMORY, __func__, NULL, sizeof(file_line_stream_t));
+        return NULL;
+    }
+    stream->arena = arena;
+    stream->source = source;
+    return stream;
+}
+
+file_line_stream_t* file_line_stream_open(mem_arena_t* arena, const char* path_name, uint16_t buffer_size) {
+    require_address(arena, "NULL memory arena!");
+    require_address(path_name, "NULL path name!");
+
+    file_source_t* source = file_source_dos(arena, path_name, buffer_size);
+    if (!source) {
+        return NULL;
+    }
+    file_line_stream_t* stream = file_line_stream_create(arena, source);
+    if (!stream) {
+        file_source_close(source);
+    }
+    return stream;
+}
+
+bool file_line_stream_next(file_line_stream_t* stream, file_line_view_t* line) {
+    require_address(stream, "NULL line stream!");
+    require_address(line, "NULL line view!");
+
+    char* stitched = NULL;
+    size_t stitched_length = 0;
+    while (!stream->eof) {
+        const char* start = stream->chunk + stream->chunk_position;
+        size_t available = stream->chunk_length - stream->chunk_position;
+        const char* newline = available ? str_scan_byte(start, available, '\n') : NULL;
+
+        if (newline) {
+            size_t length = (size_t)(newline - start);
+            stream->chunk_position += (uint16_t)(length + 1);
+            if (!stitched) {                                // the common case: no copy at all
+                file_line_stream_view(stream, line, start, length);
+            } else if (file_line_stream_stitch(stream, &stitched, &stitched_length, start, length)) {
+                file_line_stream_view(stream, line, stitched, stitched_length);
+            } else {
+                break;
+            }
+            return true;
+        }
+
+        // the line runs off the end of this buffer: keep what we have before the buffer is recycled
+        if (!file_line_stream_stitch(stream, &stitched, &stitched_length, start, available)) {
+            break;
+        }
+        stream->chunk = file_source_next(stream->source, &stream->chunk_length);
+        stream->chunk_position = 0;
+        if (!stream->chunk) {
+            stream->err_code = file_source_error(stream->source);
+            stream->eof = true;
+            stream->chunk_length = 0;
+        }
+    }
+    if (stream->err_code) {                                 // a line cut short is no line
+        stream->eof = true;
+        return false;
+    }
+    if (stitched) {                                         // last line without a line ending
+        file_line_stream_view(stream, line, stitched, stitched_length);
+        return true;
+    }
+    return false;
+}
+
+dos_error_code_t file_line_stream_error(const file_line_stream_t* stream) {
+    require_address(stream, "NULL line stream!");
+    return stream->err_code;
+}
+
+uint32_t file_line_stream_line_number(file_line_stream_t* stream) {
+    require_address(stream, "NULL line stream!");
+    return stream->line_number;
+}
+
+void file_line_stream_close(file_line_stream_t* stream) {
+    require_address(stream, "NULL line stream!");
+    file_source_close(stream->source);
+}
@@ -0,0 +1,87 @@
+/**
+ * @file file_line_stream.h
+ * @brief Unbounded streaming line reader returning zero-copy line views
+ * @defgroup file_line_stream File Line Stream
+ * @{
+ */
+#ifndef FILE_LINE_STREAM_H
+#define FILE_LINE_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "file_source.h"
+#include "file_types.h"
+#include "../MEM/mem_arena.h"
+
+/**
+ * @brief Opaque line stream
+ *
+ * @details Unlike file_read_line() there is no per-line copy, no length cap and no page cap:
+ * @code
+ * | Line                            | View points into                         |
+ * |---------------------------------|------------------------------------------|
+ * | inside one read buffer          | the read buffer (no copy)                |
+ * | spanning a buffer boundary      | the arena, stitched from both buffers    |
+ * | longer than a whole buffer      | the arena, stitched from every buffer    |
+ * @endcode
+ *
+ * Input comes from any file_source_t. file_line_stream_open() uses file_source_dos,
+ * so on host builds the next buffer is read while the current one is parsed.
+ */
+typedef struct private_file_line_stream_t file_line_stream_t;
+
+/**
+ * @brief Streams lines from any input source
+ * @param arena Arena for the stream and any stitched lines
+ * @param source Open source, closed by file_line_stream_close()
+ * @return Stream or NULL if the arena is full (see dos_last_error())
+ */
+file_line_stream_t* file_line_stream_create(mem_arena_t* arena, file_source_t* source);
+
+/**
+ * @brief Opens a file for line streaming
+ * @param arena Arena for the stream, its read buffers and any stitched lines
+ * @param path_name File to read
+ * @param buffer_size Bytes per read buffer (> 0)
+ * @return Stream or NULL if the file cannot be opened or the arena is full (see dos_last_error())
+ */
+file_line_stream_t* file_line_stream_open(mem_arena_t* arena, const char* path_name, uint16_t buffer_size);
+
+/**
+ * @brief Gets the next line
+ * @param stream Open stream
+ * @param line Receives the line view (line endings "\n" or "\r\n" excluded)
+ * @return true if a line was returned, false at end of file or when the stream broke
+ *         off (see file_line_stream_error())
+ *
+ * @note Blank lines are returned as zero length views
+ * @warning A view into the read buffer is only valid until the next call - copy it or
+ *          its fields if it must live longer. Stitched lines live as long as the arena.
+ */
+bool file_line_stream_next(file_line_stream_t* stream, file_line_view_t* line);
+
+/**
+ * @brief Gets why the stream ended early
+ * @param stream Stream
+ * @return DOS_SUCCESS at a plain end of file, the source's read error, or
+ *         DOS_INSUFFICIENT_MEMORY for a line longer than the arena could stitch
+ */
+dos_error_code_t file_line_stream_error(const file_line_stream_t* stream);
+
+/**
+ * @brief Gets the 1-based number of the line last returned
+ * @param stream Open stream
+ * @return Line number (0 before the first line)
+ */
+uint32_t file_line_stream_line_number(file_line_stream_t* stream);
+
+/**
+ * @brief Closes the stream's source
+ * @param stream Open stream
+ */
+void file_line_stream_close(file_line_stream_t* stream);
+
+#endif
+
+/** @} */ // end of file_line_stream group
@@ -0,0 +1,152 @@
+#include "file_map.h"
+#include "../CONTRACT/contract.h"
+#include "../DOS/dos_error_messages.h"
+#include "../DOS/dos_last_error.h"
+#include "../DOS/dos_services_files.h"
+#include "../STRUTIL/str_scan.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef __DOS__
+#include <i86.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../DOS/dos_services_host.h"
+#endif
+
+/**
+ * @brief Records line starts: str_scan sizes the table, then fills it in one pass
+ * @return false if the arena has no room for the table
+ */
+static bool file_map_index(mem_arena_t* arena, file_map_t* map, const char* path_name) {
+    uint32_t count = str_scan_line_offsets(map->data, map->size, NULL, 0);
+    map->line_offsets = (uint32_t*)mem_arena_alloc_aligned(arena, (count + 1) * sizeof(uint32_t), sizeof(uint32_t));
+    if (!map->line_offsets) {
+        dos_last_error_set(DOS_INSUFFICIENT_MEMORY, __func__, path_name, (count + 1) * sizeof(uint32_t));
+        return false;
+    }
+    map->line_count = str_scan_line_offsets(map->data, map->size, map->line_offsets, count);
+    map->line_offsets[count] = map->size;
+    return true;
+}
+
+#ifndef __DOS__
+
+static const char* file_map_load(mem_arena_t* arena, file_map_t* map, const char* path_name) {
+    (void)arena;
+    int fd = open(path_name, O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0) {
+        dos_last_error_set(dos_host_error_code(errno), __func__, path_name, 0);
+        if (fd >= 0) close(fd);
+        return NULL;
+    }
+    if ((uint64_t)status.st_size > UINT32_MAX) {            // offsets are 32 bit
+        dos_last_error_set(DOS_INSUFFICIENT_MEMORY, __func__, path_name, UINT32_MAX);
+        close(fd);
+        return NULL;
+    }
+    map->size = (uint32_t)status.st_size;
+    if (!map->size) {                                       // mmap refuses zero lengths
+        close(fd);
+        return "";
+    }
+    void* data = mmap(NULL, map->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int err = errno;
+    close(fd);                                              // the mapping keeps its own reference
+    if (data == MAP_FAILED) {
+        dos_last_error_set(dos_host_error_code(err), __func__, path_name, map->size);
+        return NULL;
+    }
+    madvise(data, map->size, MADV_SEQUENTIAL);              // advisory only, failure is harmless
+    map->mapped = 1;
+    return (const char*)data;
+}
+
+#else
+
+static const char* file_map_load(mem_arena_t* arena, file_map_t* map, const char* path_name) {
+    dos_file_handle_t fhandle = dos_open_file(path_name, ACCESS_READ_ONLY | DENY_WRITE);
+    if (!fhandle) {
+        return NULL;
+    }
+    map->size = (uint32_t)dos_move_file_pointer(fhandle, 0, FSEEK_END);
+    dos_move_file_pointer(fhandle, 0, FSEEK_SET);
+
+    char* data = map->size <= FILE_MAP_DOS_MAX_SIZE ? (char*)mem_arena_alloc(arena, map->size ? map->size : 1) : NULL;
+    if (!data) {
+        dos_last_error_set(DOS_INSUFFICIENT_MEMORY, __func__, path_name, map->size);
+        dos_close_file(fhandle);
+        return NULL;
+    }
+    // far pointer arithmetic wraps at the end of the segment: normalize the offset below 16,
+    // so data + size stays within the segment for every size up to FILE_MAP_DOS_MAX_SIZE
+    data = (char*)MK_FP(FP_SEG(data) + (FP_OFF(data) >> 4), FP_OFF(data) & 0x0F);
+    uint32_t loaded = 0;
+    while (loaded < map->size) {
+        uint32_t remaining = map->size - loaded;
+        uint16_t nbytes = remaining < FILE_MAP_CHUNK_SIZE ? (uint16_t)remaining : FILE_MAP_CHUNK_SIZE;
+        uint16_t bytes_read = dos_read_file(fhandle, data + loaded, nbytes);
+        if (bytes_read != nbytes) {
+            if (!dos_last_error_code()) {
+                dos_last_error_set(DOS_READ_FAULT, __func__, path_name, loaded + bytes_read);
+            }
+            dos_close_file(fhandle);
+            return NULL;
+        }
+        loaded += bytes_read;
+    }
+    dos_close_file(fhandle);
+    return data;
+}
+
+#endif
+
+file_map_t* file_map_readonly(mem_arena_t* arena, const char* path_name) {
+    require_address(arena, "NULL memory arena!");
+    require_address(path_name, "NULL path name!");
+
+    dos_last_error_clear();
+    file_map_t* map = (file_map_t*)mem_arena_calloc(arena, sizeof(file_map_t));
+    if (!map) {
+        dos_last_error_set(DOS_INSUFFICIENT_MEMORY, __func__, path_name, sizeof(file_map_t));
+        return NULL;
+    }
+    map->data = file_map_load(arena, map, path_name);
+    if (!map->data) {
+        return NULL;
+    }
+    if (!file_map_index(arena, map, path_name)) {
+        file_map_close(map);
+        return NULL;
+    }
+    return map;
+}
+
+file_line_view_t file_map_line(const file_map_t* map, uint32_t index) {
+    require_address(map, "NULL file map!");
+    require(index < map->line_count, "Line index out of range!");
+
+    uint32_t start = map->line_offsets[index];
+    uint32_t end = map->line_offsets[index + 1];
+    if (end > start && map->data[end - 1] == '\n') --end;
+    if (end > start && map->data[end - 1] == '\r') --end;
+    file_line_view_t line = { map->data + start, end - start };
+    return line;
+}
+
+void file_map_close(file_map_t* map) {
+    require_address(map, "NULL file map!");
+#ifndef __DOS__
+    if (map->mapped) {
+        munmap((void*)map->data, map->size);
+    }
+#endif
+    map->data = NULL;
+    map->mapped = 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file file_map.h
+ * @brief Whole-file read-only views with a line index
+ * @defgroup file_map File Map
+ * @{
+ */
+#ifndef FILE_MAP_H
+#define FILE_MAP_H
+
+#include <stdint.h>
+
+#include "file_types.h"
+#include "../MEM/mem_arena.h"
+#include "../MEM/mem_constants.h"
+
+#define FILE_MAP_CHUNK_SIZE     MEM_SIZE_32K    ///< DOS loader read size
+#define FILE_MAP_DOS_MAX_SIZE   0xFFF0U         ///< DOS maps one far segment, less the normalized offset
+
+/**
+ * @brief Read-only view of a whole file
+ *
+ * @details An alternative to file_read_page() for one-pass parses:
+ * @code
+ * | Build  | data comes from                                   | Copies |
+ * |--------|---------------------------------------------------|--------|
+ * | host   | mmap(PROT_READ) + madvise(MADV_SEQUENTIAL)        | none   |
+ * | DOS    | arena buffer filled by FILE_MAP_CHUNK_SIZE reads  | one    |
+ * @endcode
+ *
+ * line_offsets holds the start of every line plus a sentinel at size, so line i
+ * spans [line_offsets[i], line_offsets[i + 1]) including its line ending.
+ */
+typedef struct {
+    const char* data;
+    uint32_t size;
+    uint32_t* line_offsets;     ///< line_count + 1 entries
+    uint32_t line_count;
+    uint8_t mapped;             ///< 1 = data must be unmapped on close
+} file_map_t;
+
+/**
+ * @brief Maps or loads a whole file and indexes its lines
+ * @param arena Arena for the map, its line index and (DOS) the file contents
+ * @param path_name File to map
+ * @return Map or NULL if the file cannot be opened or read, or it and its index do not
+ *         fit in the arena (DOS_INSUFFICIENT_MEMORY; see dos_last_error())
+ *
+ * @note Files over 4 GB, and under DOS over FILE_MAP_DOS_MAX_SIZE, do not fit either
+ */
+file_map_t* file_map_readonly(mem_arena_t* arena, const char* path_name);
+
+/**
+ * @brief Gets a line without its line ending
+ * @param map Open map
+ * @param index 0-based line index (< line_count)
+ * @return View into the map data, valid until file_map_close()
+ */
+file_line_view_t file_map_line(const file_map_t* map, uint32_t index);
+
+/**
+ * @brief Releases the mapping (arena memory is released with the arena)
+ * @param map Open map
+ */
+void file_map_close(file_map_t* map);
+
+#endif
+
+/** @} */ // end of file_map group
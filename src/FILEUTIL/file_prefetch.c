@@ -0,0 +1,235 @@
+#include "file_prefetch.h"
+#include "../CONTRACT/contract.h"
+#include "../DOS/dos_error_messages.h"
+#include "../DOS/dos_last_error.h"
+#include "../DOS/dos_services_files.h"
+#include "../STRUTIL/str_scan.h"
+
+#include <string.h>
+
+#ifndef __DOS__
+#include <pthread.h>
+#endif
+
+typedef struct private_file_prefetch_t {
+    dos_file_handle_t fhandle;
+    uint16_t buffer_size;
+    char* buffers[2];
+    uint16_t lengths[2];            ///< Valid bytes, 0 marks end of file
+    uint8_t filled[2];              ///< 1 = owned by the consumer side, 0 = free for the filler
+    uint8_t current;                ///< Buffer the consumer holds
+    uint8_t started;                ///< Consumer has taken its first buffer
+    uint8_t eof;
+    dos_error_code_t err_code;      ///< Written by the filler, read once it has handed over the end of file
+    dos_error_code_t line_error;    ///< Line reader side: read error seen or arena full, no more lines
+    const char* chunk;              ///< Line reader cursor over the current buffer
+    uint16_t chunk_length;
+    uint16_t chunk_position;
+#ifndef __DOS__
+    pthread_t filler;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    uint8_t stop;
+#endif
+} file_prefetch_t;
+
+/**
+ * @brief Reads into one buffer, recording the first error
+ */
+static uint16_t file_prefetch_fill(file_prefetch_t* prefetch, uint8_t index) {
+    dos_last_error_clear();
+    uint16_t bytes_read = dos_read_file(prefetch->fhandle, prefetch->buffers[index], prefetch->buffer_size);
+    if (dos_last_error_code()) {
+        prefetch->err_code = dos_last_error_code();
+        return 0;
+    }
+    return bytes_read;
+}
+
+#ifndef __DOS__
+
+/**
+ * @brief Background filler: alternates buffers, waiting while the consumer still holds the next one
+ */
+static void* file_prefetch_filler(void* context) {
+    file_prefetch_t* prefetch = (file_prefetch_t*)context;
+    uint8_t index = 0;
+    for (;;) {
+        pthread_mutex_lock(&prefetch->lock);
+        while (prefetch->filled[index] && !prefetch->stop) {
+            pthread_cond_wait(&prefetch->changed, &prefetch->lock);
+        }
+        uint8_t stop = prefetch->stop;
+        pthread_mutex_unlock(&prefetch->lock);
+        if (stop) break;
+
+        uint16_t bytes_read = file_prefetch_fill(prefetch, index);   // the slow part runs unlocked
+
+        pthread_mutex_lock(&prefetch->lock);
+        prefetch->lengths[index] = bytes_read;
+        prefetch->filled[index] = 1;
+        pthread_cond_broadcast(&prefetch->changed);
+        pthread_mutex_unlock(&prefetch->lock);
+        if (!bytes_read) break;
+        index ^= 1;
+    }
+    return NULL;
+}
+
+#endif
+
+file_prefetch_t* file_prefetch_open(mem_arena_t* arena, const char* path_name, uint16_t buffer_size) {
+    require_address(arena, "NULL memory arena!");
+    require_address(path_name, "NULL path name!");
+    require(buffer_size > 0, "ZERO buffer size!");
+
+    file_prefetch_t* prefetch = (file_prefetch_t*)mem_arena_alloc_aligned(arena, sizeof(file_prefetch_t), sizeof(void*) * 2);
+    if (!prefetch) {
+        dos_last_error_set(DOS_INSUFFICIENT_MEMORY, __func__, path_name, sizeof(file_prefetch_t));
+        return NULL;
+    }
+    memset(prefetch, 0, sizeof(file_prefetch_t));
+    prefetch->buffers[0] = (char*)mem_arena_alloc(arena, buffer_size);
+    prefetch->buffers[1] = (char*)mem_arena_alloc(arena, buffer_size);
+    if (!prefetch->buffers[0] || !prefetch->buffers[1]) {
+        dos_last_error_set(DOS_INSUFFICIENT_MEMORY, __func__, path_name, (uint32_t)buffer_size * 2);
+        return NULL;
+    }
+    prefetch->buffer_size = buffer_size;
+
+    prefetch->fhandle = dos_open_file(path_name, ACCESS_READ_ONLY);
+    if (!prefetch->fhandle) {
+        return NULL;
+    }
+#ifndef __DOS__
+    pthread_mutex_init(&prefetch->lock, NULL);
+    pthread_cond_init(&prefetch->changed, NULL);
+    require_not_busy(pthread_create(&prefetch->filler, NULL, file_prefetch_filler, prefetch) == 0,
+                               "Prefetch thread create fail!");
+#endif
+    return prefetch;
+}
+
+const char* file_prefetch_next(file_prefetch_t* prefetch, uint16_t* nbytes) {
+    require_address(prefetch, "NULL prefetch!");
+    require_address(nbytes, "NULL byte count!");
+
+    *nbytes = 0;
+    if (prefetch->eof) {
+        return NULL;
+    }
+#ifndef __DOS__
+    pthread_mutex_lock(&prefetch->lock);
+    if (prefetch->started) {                        // hand the parsed buffer back to the filler
+        prefetch->filled[prefetch->current] = 0;
+        prefetch->current ^= 1;
+        pthread_cond_broadcast(&prefetch->changed);
+    }
+    prefetch->started = 1;
+    while (!prefetch->filled[prefetch->current]) {
+        pthread_cond_wait(&prefetch->changed, &prefetch->lock);
+    }
+    *nbytes = prefetch->lengths[prefetch->current];
+    pthread_mutex_unlock(&prefetch->lock);
+#else
+    *nbytes = file_prefetch_fill(prefetch, prefetch->current);    // one large synchronous read
+#endif
+    if (!*nbytes) {
+        prefetch->eof = 1;
+        return NULL;
+    }
+    return prefetch->buffers[prefetch->current];
+}
+
+dos_error_code_t file_prefetch_error(file_prefetch_t* prefetch) {
+    require_address(prefetch, "NULL prefetch!");
+    return prefetch->line_error ? prefetch->line_error : prefetch->err_code;
+}
+
+void file_prefetch_close(file_prefetch_t* prefetch) {
+    require_address(prefetch, "NULL prefetch!");
+#ifndef __DOS__
+    pthread_mutex_lock(&prefetch->lock);
+    prefetch->stop = 1;
+    pthread_cond_broadcast(&prefetch->changed);
+    pthread_mutex_unlock(&prefetch->lock);
+    pthread_join(prefetch->filler, NULL);
+    pthread_cond_destroy(&prefetch->changed);
+    pthread_mutex_destroy(&prefetch->lock);
+#endif
+    dos_close_file(prefetch->fhandle);
+    prefetch->fhandle = 0;
+}
+
+line_t* file_prefetch_next_line(mem_arena_t* arena, file_prefetch_t* prefetch) {
+    require_address(arena, "NULL memory arena!");
+    require_address(prefetch, "NULL prefetch!");
+
+    if (prefetch->line_error) {
+        return NULL;
+    }
+    if (prefetch->chunk_position == prefetch->chunk_length) {  // end of file first: a full arena is no error there
+        prefetch->chunk = file_prefetch_next(prefetch, &prefetch->chunk_length);
+        prefetch->chunk_position = 0;
+        if (!prefetch->chunk) {
+            prefetch->line_error = prefetch->err_code;
+            return NULL;
+        }
+    }
+    line_t* line = mem_arena_alloc(arena, sizeof(line_t));
+    if (!line) {
+        prefetch->line_error = DOS_INSUFFICIENT_MEMORY; // nothing consumed, the file stops here
+        return NULL;
+    }
+
+    size_t length = 0;
+    while (length < FILE_MAX_LINE_SIZE - 1) {      // fgets() semantics: stop after '\n' or n - 1 chars
+        if (prefetch->chunk_position == prefetch->chunk_length) {
+            prefetch->chunk = file_prefetch_next(prefetch, &prefetch->chunk_length);
+            prefetch->chunk_position = 0;
+            if (!prefetch->chunk) {
+                prefetch->line_error = prefetch->err_code;  // the filler has stopped
+                break;
+            }
+        }
+        char c = prefetch->chunk[prefetch->chunk_position++];
+        (*line)[length++] = c;
+        if (c == '\n') {
+            break;
+        }
+    }
+    if (prefetch->line_error || !length) {
+        return NULL;  // EOF or read error
+    }
+    const char* ending = str_scan_line_end(*line, length);
+    (*line)[ending ? (size_t)(ending - *line) : length] = '\0';  // a blank line stays, as ""
+    return line;
+}
+
+line_t* file_prefetch_read_line(mem_arena_t* arena, file_prefetch_t* prefetch) {
+    line_t* line = file_prefetch_next_line(arena, prefetch);
+
+    require_mem(prefetch->line_error != DOS_INSUFFICIENT_MEMORY, "NULL line - arena alloc fail!");
+    require_not_canceled(!prefetch->line_error, "READ error occurred!");
+
+    return line;
+}
+
+page_t file_prefetch_read_page(mem_arena_t* arena, file_prefetch_t* prefetch) {
+    require_address(arena, "NULL memory arena!");
+    require_address(prefetch, "NULL prefetch!");
+
+    page_t page = {0};
+
+    while (page.line_count < FILE_MAX_PAGE_SIZE) {
+        line_t* line = file_prefetch_read_line(arena, prefetch);
+        if (!line) {
+            break;
+        }
+        page.lines[page.line_count++] = line;
+    }
+
+    require_io_success(page.line_count > 0, "EMPTY file!");
+
+    return page;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file file_prefetch.h
+ * @brief Double-buffered file reader that overlaps disk reads with parsing
+ * @defgroup file_prefetch File Prefetch
+ * @{
+ */
+#ifndef FILE_PREFETCH_H
+#define FILE_PREFETCH_H
+
+#include <stdint.h>
+
+#include "file_constants.h"
+#include "file_types.h"
+#include "../DOS/dos_services_types.h"
+#include "../MEM/mem_arena.h"
+
+#define FILE_PREFETCH_BUFFER_SIZE   MEM_SIZE_32K   // per buffer, two are allocated
+
+/**
+ * @brief Opaque double-buffered reader
+ * @dot
+ * digraph prefetch {
+ *     rankdir=LR;
+ *     node [shape=box, fontname="Courier New"];
+ *     disk [label="dos_read_file"];
+ *     A [label="buffer A\n(consumer parses)"];
+ *     B [label="buffer B\n(filler reads)"];
+ *     disk -> B;
+ *     A -> B [label="swap on next", style=dashed];
+ * }
+ * @enddot
+ *
+ * @details Host builds fill the idle buffer on a background thread while the consumer
+ *          works through the other one. DOS has no threads, so file_prefetch_next()
+ *          degrades to one large synchronous read per buffer.
+ */
+typedef struct private_file_prefetch_t file_prefetch_t;
+
+/**
+ * @brief Opens a file and starts filling the first buffer
+ * @param arena Arena the reader and both buffers are allocated from
+ * @param path_name File to read
+ * @param buffer_size Bytes per buffer (> 0)
+ * @return Reader or NULL if the file cannot be opened or the arena is full (see dos_last_error())
+ */
+file_prefetch_t* file_prefetch_open(mem_arena_t* arena, const char* path_name, uint16_t buffer_size);
+
+/**
+ * @brief Hands the current buffer back and takes the next filled one
+ * @param prefetch Open reader
+ * @param nbytes Receives the number of valid bytes
+ * @return Buffer contents (valid until the next call) or NULL at end of file
+ */
+const char* file_prefetch_next(file_prefetch_t* prefetch, uint16_t* nbytes);
+
+/**
+ * @brief Gets the error code of the first failed background read
+ * @param prefetch Open reader
+ * @return DOS_SUCCESS or the DOS error code that ended the file early,
+ *         DOS_INSUFFICIENT_MEMORY if file_prefetch_next_line() ran out of arena
+ */
+dos_error_code_t file_prefetch_error(file_prefetch_t* prefetch);
+
+/**
+ * @brief Stops the filler and closes the file
+ * @param prefetch Open reader
+ *
+ * @note The memory stays in the arena until the arena is deleted
+ */
+void file_prefetch_close(file_prefetch_t* prefetch);
+
+/**
+ * @brief Reads a single line without aborting on errors
+ * @param arena Arena the line_t is allocated from
+ * @param prefetch Open reader
+ * @return Line without its ending, "" for a blank line, or NULL at end of file, on a read
+ *         error or when the arena is full; file_prefetch_error() tells them apart and
+ *         every later call returns NULL
+ *
+ * @details A worker pool reads with this so one bad file ends only that file.
+ */
+line_t* file_prefetch_next_line(mem_arena_t* arena, file_prefetch_t* prefetch);
+
+/**
+ * @brief Reads a single line, aborting on errors like file_read_line()
+ * @param arena Arena the line_t is allocated from
+ * @param prefetch Open reader
+ * @return Trimmed line, "" for a blank line, or NULL at end of file
+ *
+ * @note Lines longer than FILE_MAX_LINE_SIZE - 1 are split exactly as fgets() splits them
+ */
+line_t* file_prefetch_read_line(mem_arena_t* arena, file_prefetch_t* prefetch);
+
+/**
+ * @brief Reads up to FILE_MAX_PAGE_SIZE lines, same contract as file_read_page()
+ * @param arena Arena the lines are allocated from
+ * @param prefetch Open reader
+ * @return Page of lines
+ */
+page_t file_prefetch_read_page(mem_arena_t* arena, file_prefetch_t* prefetch);
+
+#endif
+
+/** @} */ // end of file_prefetch group
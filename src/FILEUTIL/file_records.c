@@ -0,0 +1,156 @@
+#include "file_records.h"
+#include "../CONTRACT/contract.h"
+#include "../DOS/dos_error_messages.h"
+#include "../DOS/dos_last_error.h"
+#include "../DOS/dos_services_files.h"
+#include "../DOS/dos_services_3x.h"
+
+#ifdef __DOS__
+#include <i86.h>
+#else
+#include <time.h>
+#endif
+
+#define FILE_RECORDS_BIOS_TICKS_SEGMENT 0x0040  // BIOS data area: ticks since midnight at 0040:006C
+#define FILE_RECORDS_BIOS_TICKS_OFFSET  0x006C
+#define FILE_RECORDS_TICK_NANOSECONDS   54925439L
+
+static dos_file_position_t file_records_offset(const file_records_t* records, uint32_t record) {
+    return (dos_file_position_t)record * records->record_size;
+}
+
+/**
+ * @brief Waits before the next attempt on a violation
+ * @param records Record file, its retry_ticks is the first wait
+ * @param attempt 0 for the wait after the first failure
+ *
+ * @details DOS polls the BIOS tick count; a wait spanning midnight, when the count
+ *          wraps to 0, ends early. The host sleeps for the same time.
+ */
+static void file_records_backoff(const file_records_t* records, uint16_t attempt) {
+    uint32_t ticks = (uint32_t)records->retry_ticks << (attempt < FILE_RECORDS_MAX_DOUBLINGS ? attempt : FILE_RECORDS_MAX_DOUBLINGS);
+    if (!ticks) {
+        return;
+    }
+#ifdef __DOS__
+    volatile uint32_t __far* bios_ticks = (volatile uint32_t __far*)MK_FP(FILE_RECORDS_BIOS_TICKS_SEGMENT, FILE_RECORDS_BIOS_TICKS_OFFSET);
+    uint32_t start = *bios_ticks;
+    while (*bios_ticks - start < ticks) {
+    }
+#else
+    struct timespec delay;
+    uint64_t nanoseconds = (uint64_t)ticks * FILE_RECORDS_TICK_NANOSECONDS;
+    delay.tv_sec = (time_t)(nanoseconds / 1000000000u);
+    delay.tv_nsec = (long)(nanoseconds % 1000000000u);
+    while (nanosleep(&delay, &delay) != 0) {       // resume after a signal
+    }
+#endif
+}
+
+dos_error_code_t file_records_open(file_records_t* records, const char* path_name, uint16_t record_size, dos_file_access_attributes_t sharing) {
+    require_address(records, "NULL records!");
+    require_address(path_name, "NULL path name!");
+    require(record_size > 0, "ZERO record size!");
+
+    records->record_size = record_size;
+    records->retries = FILE_RECORDS_DEFAULT_RETRIES;
+    records->retry_ticks = FILE_RECORDS_DEFAULT_RETRY_TICKS;
+
+    uint16_t attempt = 0;
+    for (;;) {
+        dos_last_error_clear();
+        records->fhandle = dos_open_file(path_name, (dos_file_access_attributes_t)(ACCESS_READ_WRITE | sharing));
+        if (records->fhandle || dos_last_error_code() != DOS_SHARING_VIOLATION || attempt + 1 >= records->retries) {
+            break;
+        }
+        file_records_backoff(records, attempt++);
+    }
+
+    return records->fhandle ? DOS_SUCCESS : dos_last_error_code();
+}
+
+dos_error_code_t file_records_close(file_records_t* records) {
+    require_address(records, "NULL records!");
+    require_fd(records->fhandle, "Record file not open!");
+
+    dos_error_code_t err_code = dos_close_file(records->fhandle);
+    records->fhandle = 0;
+    return err_code;
+}
+
+dos_error_code_t file_records_lock(file_records_t* records, uint32_t record, uint16_t count) {
+    require_address(records, "NULL records!");
+    require_fd(records->fhandle, "Record file not open!");
+    require(count > 0, "ZERO record count!");
+
+    dos_file_size_t nbytes = (dos_file_size_t)count * records->record_size;
+    uint16_t attempt = 0;
+    for (;;) {  // lock violations are expected under contention so they are retried, not reported
+        dos_error_code_t err_code = dos3x_lock_file_region(records->fhandle, file_records_offset(records, record), nbytes);
+        if (err_code != DOS_LOCK_VIOLATION || attempt + 1 >= records->retries) {
+            return err_code;
+        }
+        file_records_backoff(records, attempt++);
+    }
+}
+
+dos_error_code_t file_records_unlock(file_records_t* records, uint32_t record, uint16_t count) {
+    require_address(records, "NULL records!");
+    require_fd(records->fhandle, "Record file not open!");
+    require(count > 0, "ZERO record count!");
+
+    return dos3x_unlock_file_region(records->fhandle, file_records_offset(records, record),
+                                    (dos_file_size_t)count * records->record_size);
+}
+
+dos_error_code_t file_records_read_locked(file_records_t* records, uint32_t record, char* buffer) {
+    require_address(records, "NULL records!");
+    require_address(buffer, "NULL record buffer!");
+
+    dos_last_error_clear();
+    dos_move_file_pointer(records->fhandle, file_records_offset(records, record), FSEEK_SET);
+    if (dos_last_error_code()) {
+        return dos_last_error_code();
+    }
+    uint16_t bytes_read = dos_read_file(records->fhandle, buffer, records->record_size);
+    if (dos_last_error_code()) {
+        return dos_last_error_code();
+    }
+    return (bytes_read == records->record_size) ? DOS_SUCCESS : DOS_INVALID_DATA;
+}
+
+dos_error_code_t file_records_write_locked(file_records_t* records, uint32_t record, const char* buffer) {
+    require_address(records, "NULL records!");
+    require_address(buffer, "NULL record buffer!");
+
+    dos_last_error_clear();
+    dos_move_file_pointer(records->fhandle, file_records_offset(records, record), FSEEK_SET);
+    if (dos_last_error_code()) {
+        return dos_last_error_code();
+    }
+    uint16_t bytes_written = dos_write_file(records->fhandle, buffer, records->record_size);
+    if (dos_last_error_code()) {
+        return dos_last_error_code();
+    }
+    return (bytes_written == records->record_size) ? DOS_SUCCESS : DOS_INSUFFICIENT_DISK_SPACE;
+}
+
+dos_error_code_t file_records_read(file_records_t* records, uint32_t record, char* buffer) {
+    dos_error_code_t err_code = file_records_lock(records, record, 1);
+    if (err_code) {
+        return err_code;
+    }
+    err_code = file_records_read_locked(records, record, buffer);
+    dos_error_code_t unlock_code = file_records_unlock(records, record, 1);
+    return err_code ? err_code : unlock_code;
+}
+
+dos_error_code_t file_records_write(file_records_t* records, uint32_t record, const char* buffer) {
+    dos_error_code_t err_code = file_records_lock(records, record, 1);
+    if (err_code) {
+        return err_code;
+    }
+    err_code = file_records_write_locked(records, record, buffer);
+    dos_error_code_t unlock_code = file_records_unlock(records, record, 1);
+    return err_code ? err_code : unlock_code;
+}
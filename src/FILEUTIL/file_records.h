@@ -0,0 +1,133 @@
+/**
+ * @file file_records.h
+ * @brief Fixed-size record access with byte-range locking for files shared between processes
+ * @defgroup file_records File Records
+ * @{
+ */
+#ifndef FILE_RECORDS_H
+#define FILE_RECORDS_H
+
+#include <stdint.h>
+
+#include "../DOS/dos_services_types.h"
+#include "../DOS/dos_services_files_types.h"
+
+#define FILE_RECORDS_DEFAULT_RETRIES    16  // attempts on a lock or sharing violation before giving up
+#define FILE_RECORDS_DEFAULT_RETRY_TICKS 1  // first wait between attempts, in 55 ms BIOS timer ticks
+#define FILE_RECORDS_MAX_DOUBLINGS      2   // the wait doubles per attempt, at most this many times
+
+/**
+ * @brief Open file of fixed-size records
+ *
+ * @details Concurrency model:
+ * @code
+ * | Sharing mode    | Other openers may      | Use for                          |
+ * |-----------------|------------------------|----------------------------------|
+ * | SHARE_FULL      | read and write         | disjoint record updates (locked) |
+ * | DENY_WRITE      | read only              | shared readers, single writer    |
+ * | SHARE_EXCLUSIVE | nothing                | whole file rebuilds              |
+ * @endcode
+ *
+ * With SHARE_FULL every record read or write holds an exclusive INT 21,5C lock over
+ * just that record, so several processes update disjoint records concurrently
+ * instead of serialising on an exclusive open.
+ *
+ * A violation means another process holds the record, so attempts are spaced out:
+ * the wait starts at retry_ticks and doubles FILE_RECORDS_MAX_DOUBLINGS times at
+ * most, giving the holder time to finish instead of spinning on INT 21h.
+ */
+typedef struct {
+    dos_file_handle_t fhandle;      ///< DOS handle, 0 when closed
+    uint16_t record_size;           ///< Bytes per record
+    uint16_t retries;               ///< Attempts on a lock violation before failing
+    uint16_t retry_ticks;           ///< First wait between attempts in BIOS ticks (55 ms), 0 = no wait
+} file_records_t;
+
+/**
+ * @brief Opens a record file for read/write with the given sharing mode
+ * @param records Record file to initialise
+ * @param path_name Existing file to open
+ * @param record_size Bytes per record (> 0)
+ * @param sharing Sharing mode bits (SHARE_FULL, DENY_WRITE, ...)
+ * @return DOS_SUCCESS or the DOS error code (see dos_last_error())
+ *
+ * @note Retries, with backoff, while the open fails with a sharing violation.
+ *       Sets retries and retry_ticks to their defaults; change them after the open.
+ */
+dos_error_code_t file_records_open(file_records_t* records, const char* path_name, uint16_t record_size, dos_file_access_attributes_t sharing);
+
+/**
+ * @brief Closes the record file
+ * @param records Open record file
+ * @return DOS_SUCCESS or the DOS error code
+ *
+ * @warning All record locks must have been released first
+ */
+dos_error_code_t file_records_close(file_records_t* records);
+
+/**
+ * @brief Locks a run of records against other processes
+ * @param records Open record file
+ * @param record First record number
+ * @param count Number of records
+ * @return DOS_SUCCESS, DOS_LOCK_VIOLATION once retries are exhausted, or the DOS error code
+ *
+ * @details Use around a read-modify-write sequence:
+ * @code
+ * file_records_lock(&records, n, 1);
+ * file_records_read_locked(&records, n, buffer);
+ * ... update buffer ...
+ * file_records_write_locked(&records, n, buffer);
+ * file_records_unlock(&records, n, 1);
+ * @endcode
+ */
+dos_error_code_t file_records_lock(file_records_t* records, uint32_t record, uint16_t count);
+
+/**
+ * @brief Releases a lock taken by file_records_lock()
+ * @param records Open record file
+ * @param record First record number (as locked)
+ * @param count Number of records (as locked)
+ * @return DOS_SUCCESS or the DOS error code
+ */
+dos_error_code_t file_records_unlock(file_records_t* records, uint32_t record, uint16_t count);
+
+/**
+ * @brief Reads one record the caller has already locked
+ * @param records Open record file
+ * @param record Record number
+ * @param buffer Destination of record_size bytes
+ * @return DOS_SUCCESS, DOS_INVALID_DATA on a short read, or the DOS error code
+ */
+dos_error_code_t file_records_read_locked(file_records_t* records, uint32_t record, char* buffer);
+
+/**
+ * @brief Writes one record the caller has already locked
+ * @param records Open record file
+ * @param record Record number
+ * @param buffer Source of record_size bytes
+ * @return DOS_SUCCESS, DOS_INSUFFICIENT_DISK_SPACE on a short write, or the DOS error code
+ */
+dos_error_code_t file_records_write_locked(file_records_t* records, uint32_t record, const char* buffer);
+
+/**
+ * @brief Locks, reads and unlocks one record
+ * @param records Open record file
+ * @param record Record number
+ * @param buffer Destination of record_size bytes
+ * @return DOS_SUCCESS or the DOS error code
+ */
+dos_error_code_t file_records_read(file_records_t* records, uint32_t record, char* buffer);
+
+/**
+ * @brief Locks, writes and unlocks one record
+ * @param records Open record file
+ * @param record Record number
+ * @param buffer Source of record_size bytes
+ * @return DOS_SUCCESS or the DOS error code
+ */
+dos_error_code_t file_records_write(file_records_t* records, uint32_t record, const char* buffer);
+
+#endif
+
+/** @} */ // end of file_records group
@@ -0,0 +1,247 @@
+#include "file_source.h"
+#include "file_constants.h"
+#include "file_map.h"
+#include "file_prefetch.h"
+#include "../CONTRACT/contract.h"
+#include "../DOS/dos_error_messages.h"
+#include "../DOS/dos_last_error.h"
+#include "../STRUTIL/str_scan.h"
+
+#include <string.h>
+
+#ifndef __DOS__
+#include <errno.h>
+#include <unistd.h>
+#include "../DOS/dos_services_host.h"
+#endif
+
+/**
+ * @brief Allocates a source and its zeroed state
+ * @return Source or NULL if the arena is full (DOS_INSUFFICIENT_MEMORY recorded)
+ */
+static file_source_t* file_source_create(mem_arena_t* arena, const file_source_vtable_t* vtable, mem_size_t state_size) {
+    require_address(arena, "NULL memory arena!");
+
+    file_source_t* source = (file_source_t*)mem_arena_calloc(arena, sizeof(file_source_t));
+    if (source) {
+        source->state = mem_arena_alloc_aligned(arena, state_size, sizeof(void*));
+    }
+    if (!source || !source->state) {
+        dos_last_error_set(DOS_INSUFFICIENT_MEMORY, __func__, NULL, sizeof(file_source_t) + state_size);
+        return NULL;
+    }
+    memset(source->state, 0, state_size);
+    source->vtable = vtable;
+    return source;
+}
+
+const char* file_source_next(file_source_t* source, uint16_t* nbytes) {
+    require_address(source, "NULL file source!");
+    require_address(nbytes, "NULL byte count!");
+
+    *nbytes = 0;
+    if (source->err_code) {
+        return NULL;
+    }
+    return source->vtable->next(source, nbytes);
+}
+
+dos_error_code_t file_source_error(const file_source_t* source) {
+    require_address(source, "NULL file source!");
+    return source->err_code;
+}
+
+void file_source_close(file_source_t* source) {
+    require_address(source, "NULL file source!");
+    if (source->vtable->close) {
+        source->vtable->close(source);
+    }
+}
+
+/* ----------------- Memory ----------------- */
+
+typedef struct {
+    const char* data;
+    uint32_t size;
+    uint32_t position;
+    uint32_t lines;         ///< Replay only
+} file_source_memory_t;
+
+static const char* file_source_memory_next(file_source_t* source, uint16_t* nbytes) {
+    file_source_memory_t* memory = (file_source_memory_t*)source->state;
+    uint32_t remaining = memory->size - memory->position;
+    if (!remaining) {
+        return NULL;
+    }
+    *nbytes = remaining < FILE_SOURCE_MEMORY_CHUNK ? (uint16_t)remaining : FILE_SOURCE_MEMORY_CHUNK;
+    const char* chunk = memory->data + memory->position;
+    memory->position += *nbytes;
+    return chunk;
+}
+
+static const file_source_vtable_t file_source_memory_vtable = { file_source_memory_next, NULL };
+
+file_source_t* file_source_memory(mem_arena_t* arena, const char* data, uint32_t size) {
+    require_address(data, "NULL source data!");
+
+    file_source_t* source = file_source_create(arena, &file_source_memory_vtable, sizeof(file_source_memory_t));
+    if (!source) {
+        return NULL;
+    }
+    file_source_memory_t* memory = (file_source_memory_t*)source->state;
+    memory->data = data;
+    memory->size = size;
+    return source;
+}
+
+/* ----------------- DOS handle ----------------- */
+
+static const char* file_source_dos_next(file_source_t* source, uint16_t* nbytes) {
+    file_prefetch_t* prefetch = (file_prefetch_t*)source->state;
+    const char* chunk = file_prefetch_next(prefetch, nbytes);
+    if (!chunk) {
+        source->err_code = file_prefetch_error(prefetch);
+    }
+    return chunk;
+}
+
+static void file_source_dos_close(file_source_t* source) {
+    file_prefetch_close((file_prefetch_t*)source->state);
+}
+
+static const file_source_vtable_t file_source_dos_vtable = { file_source_dos_next, file_source_dos_close };
+
+file_source_t* file_source_dos(mem_arena_t* arena, const char* path_name, uint16_t buffer_size) {
+    require_address(arena, "NULL memory arena!");
+
+    file_prefetch_t* prefetch = file_prefetch_open(arena, path_name, buffer_size);
+    if (!prefetch) {
+        return NULL;
+    }
+    file_source_t* source = (file_source_t*)mem_arena_calloc(arena, sizeof(file_source_t));
+    if (!source) {
+        file_prefetch_close(prefetch);
+        dos_last_error_set(DOS_INSUFFICIENT_MEMORY, __func__, path_name, sizeof(file_source_t));
+        return NULL;
+    }
+    source->vtable = &file_source_dos_vtable;
+    source->state = prefetch;
+    return source;
+}
+
+/* ----------------- Host fd ----------------- */
+
+#ifndef __DOS__
+
+typedef struct {
+    int fd;
+    char* buffer;
+    uint16_t buffer_size;
+    uint8_t console;        ///< Ctrl-Z ends input
+    uint8_t eof;
+} file_source_fd_t;
+
+static const char* file_source_fd_next(file_source_t* source, uint16_t* nbytes) {
+    file_source_fd_t* host = (file_source_fd_t*)source->state;
+    if (host->eof) {
+        return NULL;
+    }
+    ssize_t bytes_read;
+    do {
+        bytes_read = read(host->fd, host->buffer, host->buffer_size);
+    } while (bytes_read < 0 && errno == EINTR);
+    if (bytes_read < 0) {
+        source->err_code = dos_host_error_code(errno);
+        return NULL;
+    }
+    if (host->console) {
+        const char* ctrl_z = str_scan_byte(host->buffer, (size_t)bytes_read, CTRL_Z);
+        if (ctrl_z) {
+            bytes_read = ctrl_z - host->buffer;
+            host->eof = 1;
+        }
+    }
+    if (!bytes_read) {
+        host->eof = 1;
+        return NULL;
+    }
+    *nbytes = (uint16_t)bytes_read;
+    return host->buffer;
+}
+
+static const file_source_vtable_t file_source_fd_vtable = { file_source_fd_next, NULL };
+
+file_source_t* file_source_fd(mem_arena_t* arena, int fd, uint16_t buffer_size) {
+    require_fd(fd >= 0, "Invalid file descriptor!");
+    require(buffer_size > 0, "ZERO buffer size!");
+
+    file_source_t* source = file_source_create(arena, &file_source_fd_vtable, sizeof(file_source_fd_t));
+    if (!source) {
+        return NULL;
+    }
+    file_source_fd_t* host = (file_source_fd_t*)source->state;
+    host->fd = fd;
+    host->buffer = (char*)mem_arena_alloc(arena, buffer_size);
+    if (!host->buffer) {
+        dos_last_error_set(DOS_INSUFFICIENT_MEMORY, __func__, NULL, buffer_size);
+        return NULL;
+    }
+    host->buffer_size = buffer_size;
+    host->console = (uint8_t)isatty(fd);
+    return source;
+}
+
+#endif
+
+/* ----------------- Scripted replay ----------------- */
+
+typedef struct {
+    file_source_memory_t script;    ///< Must stay first, file_source_replayed() reads it as memory
+    file_map_t* map;
+} file_source_replay_t;
+
+static const char* file_source_replay_next(file_source_t* source, uint16_t* nbytes) {
+    file_source_memory_t* script = (file_source_memory_t*)source->state;
+    uint32_t remaining = script->size - script->position;
+    if (!remaining) {
+        return NULL;
+    }
+    const char* chunk = script->data + script->position;
+    const char* newline = str_scan_byte(chunk, remaining < FILE_SOURCE_MEMORY_CHUNK ? remaining : FILE_SOURCE_MEMORY_CHUNK, '\n');
+    uint32_t length = newline ? (uint32_t)(newline - chunk) + 1 : remaining;
+    *nbytes = length < FILE_SOURCE_MEMORY_CHUNK ? (uint16_t)length : FILE_SOURCE_MEMORY_CHUNK;
+    script->position += *nbytes;
+    ++script->lines;
+    return chunk;
+}
+
+static void file_source_replay_close(file_source_t* source) {
+    file_map_close(((file_source_replay_t*)source->state)->map);
+}
+
+static const file_source_vtable_t file_source_replay_vtable = { file_source_replay_next, file_source_replay_close };
+
+file_source_t* file_source_replay(mem_arena_t* arena, const char* path_name) {
+    require_address(arena, "NULL memory arena!");
+
+    file_map_t* map = file_map_readonly(arena, path_name);
+    if (!map) {
+        return NULL;
+    }
+    file_source_t* source = file_source_create(arena, &file_source_replay_vtable, sizeof(file_source_replay_t));
+    if (!source) {
+        file_map_close(map);
+        return NULL;
+    }
+    file_source_replay_t* replay = (file_source_replay_t*)source->state;
+    replay->map = map;
+    replay->script.data = map->data;
+    replay->script.size = map->size;
+    return source;
+}
+
+uint32_t file_source_replayed(const file_source_t* source) {
+    require_address(source, "NULL file source!");
+    require(source->vtable == &file_source_replay_vtable, "Not a replay source!");
+    return ((const file_source_memory_t*)source->state)->lines;
+}
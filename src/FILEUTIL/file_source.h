@@ -0,0 +1,120 @@
+/**
+ * @file file_source.h
+ * @brief Pluggable byte sources for the line reader
+ * @defgroup file_source File Source
+ * @{
+ */
+#ifndef FILE_SOURCE_H
+#define FILE_SOURCE_H
+
+#include <stdint.h>
+
+#include "../DOS/dos_services_types.h"
+#include "../MEM/mem_arena.h"
+
+#define FILE_SOURCE_MEMORY_CHUNK    0xFFF0U     ///< Largest chunk a memory source hands out
+
+typedef struct file_source_t file_source_t;
+
+/**
+ * @brief Source operations
+ */
+typedef struct {
+    /**
+     * @brief Gets the next chunk of input
+     * @return Bytes valid until the next call, or NULL at end of input (nbytes = 0)
+     */
+    const char* (*next)(file_source_t* source, uint16_t* nbytes);
+    /**
+     * @brief Releases the source's handle or mapping (arena memory stays)
+     */
+    void (*close)(file_source_t* source);
+} file_source_vtable_t;
+
+/**
+ * @brief Input source: a vtable plus its state
+ *
+ * @details The built in sources:
+ * @code
+ * | Constructor          | Reads from                      | Chunk handed out             |
+ * |----------------------|---------------------------------|------------------------------|
+ * | file_source_memory   | caller's buffer                 | the buffer itself (no copy)  |
+ * | file_source_dos      | DOS handle via file_prefetch    | one prefetch buffer          |
+ * | file_source_fd       | host fd (0 = stdin), host only  | one read(2)                  |
+ * | file_source_replay   | answer file loaded up front     | one line per call            |
+ * @endcode
+ * Anything else - a socket, a decompressor - plugs in by filling in a vtable.
+ */
+struct file_source_t {
+    const file_source_vtable_t* vtable;
+    void* state;
+    dos_error_code_t err_code;      ///< First error, sources stop at it
+};
+
+/**
+ * @brief Gets the next chunk of input
+ * @param source Open source
+ * @param nbytes Receives the chunk length
+ * @return Bytes valid until the next call, or NULL at end of input or error
+ */
+const char* file_source_next(file_source_t* source, uint16_t* nbytes);
+
+/**
+ * @brief Gets the first error the source hit
+ * @return DOS_SUCCESS if none
+ */
+dos_error_code_t file_source_error(const file_source_t* source);
+
+/**
+ * @brief Closes the source
+ */
+void file_source_close(file_source_t* source);
+
+/**
+ * @brief Serves a caller-owned buffer at memory speed
+ * @param arena Arena for the source
+ * @param data Input bytes, must outlive the source
+ * @param size Number of bytes
+ * @return Source or NULL if the arena is full (see dos_last_error())
+ */
+file_source_t* file_source_memory(mem_arena_t* arena, const char* data, uint32_t size);
+
+/**
+ * @brief Reads a file through a double-buffered DOS handle
+ * @param arena Arena for the source and its buffers
+ * @param path_name File to read
+ * @param buffer_size Bytes per buffer
+ * @return Source or NULL if the file cannot be opened or the arena is full (see dos_last_error())
+ */
+file_source_t* file_source_dos(mem_arena_t* arena, const char* path_name, uint16_t buffer_size);
+
+#ifndef __DOS__
+/**
+ * @brief Reads a host file descriptor, e.g. 0 for stdin
+ * @param arena Arena for the source and its buffer
+ * @param fd Open descriptor, not closed by file_source_close()
+ * @param buffer_size Bytes per read
+ * @return Source or NULL if the arena is full (see dos_last_error())
+ *
+ * @note On a terminal a Ctrl-Z ends the input, as it does for file_read_line() on stdin
+ */
+file_source_t* file_source_fd(mem_arena_t* arena, int fd, uint16_t buffer_size);
+#endif
+
+/**
+ * @brief Replays a pre-loaded answer script one line per call, the way a console delivers input
+ * @param arena Arena for the source (and the script on DOS)
+ * @param path_name Answer file
+ * @return Source or NULL if the file cannot be read or does not fit in the arena
+ *         (DOS_INSUFFICIENT_MEMORY; see dos_last_error())
+ */
+file_source_t* file_source_replay(mem_arena_t* arena, const char* path_name);
+
+/**
+ * @brief Gets how many script lines a replay source has delivered
+ */
+uint32_t file_source_replayed(const file_source_t* source);
+
+#endif
+
+/** @} */ // end of file_source group
@@ -0,0 +1,107 @@
+#include "file_stream.h"
+#include "file_utils.h"
+#include "../CONTRACT/contract.h"
+#include <errno.h>
+#include <string.h>
+
+void file_stream_attach(file_stream_t* stream, FILE* file) {
+    require_address(stream, "NULL file stream!");
+    require_fd(file, "NULL file handle!");
+
+    stream->file = file;
+    stream->position = ftell(file);
+    require_io_success(stream->position != -1L, strerror(errno));
+    stream->size = file_get_size(file);
+    stream->size_known = true;
+    stream->hit_eof = false;
+}
+
+size_t file_stream_read(file_stream_t* stream, void* buffer, size_t size, size_t count) {
+    require_address(stream, "NULL file stream!");
+    require_address(buffer, "NULL buffer!");
+
+    size_t elements = fread(buffer, size, count, stream->file);
+    stream->position += (long)(elements * size);
+    if (elements < count) {
+        require_io_success(!ferror(stream->file), strerror(errno));
+        stream->hit_eof = true;
+        // a partial trailing element was consumed too, stdio cannot tell us how much of it
+        if (stream->size_known) {
+            stream->position = stream->size;
+        }
+    }
+    return elements;
+}
+
+char* file_stream_gets(file_stream_t* stream, char* line, int line_size) {
+    require_address(stream, "NULL file stream!");
+    require_address(line, "NULL line!");
+
+    if (!fgets(line, line_size, stream->file)) {
+        require_io_success(!ferror(stream->file), strerror(errno));
+        stream->hit_eof = true;
+        return NULL;
+    }
+    stream->position += (long)strlen(line);
+    return line;
+}
+
+int file_stream_getc(file_stream_t* stream) {
+    require_address(stream, "NULL file stream!");
+
+    int byte = fgetc(stream->file);
+    if (byte == EOF) {
+        require_io_success(!ferror(stream->file), strerror(errno));
+        stream->hit_eof = true;
+    } else {
+        ++stream->position;
+    }
+    return byte;
+}
+
+size_t file_stream_write(file_stream_t* stream, const void* buffer, size_t size, size_t count) {
+    require_address(stream, "NULL file stream!");
+    require_address(buffer, "NULL buffer!");
+
+    size_t elements = fwrite(buffer, size, count, stream->file);
+    require_io_success(elements == count, strerror(errno));
+    stream->position += (long)(elements * size);
+    stream->size_known = false;         // the only thing that can change the size under us
+    stream->hit_eof = false;
+    return elements;
+}
+
+long file_stream_seek(file_stream_t* stream, long offset, int origin) {
+    require_address(stream, "NULL file stream!");
+    require_arg_list(origin == SEEK_SET || origin == SEEK_CUR || origin == SEEK_END, "INVALID origin!");
+
+    long prev_pos = stream->position;
+    long target = origin == SEEK_SET ? offset
+                : origin == SEEK_CUR ? stream->position + offset
+                : file_stream_size(stream) + offset;
+    require_io_success(fseek(stream->file, target, SEEK_SET) == 0, strerror(errno));
+    stream->position = target;
+    stream->hit_eof = false;
+    return prev_pos;
+}
+
+long file_stream_position(const file_stream_t* stream) {
+    require_address(stream, "NULL file stream!");
+    return stream->position;
+}
+
+long file_stream_size(file_stream_t* stream) {
+    require_address(stream, "NULL file stream!");
+
+    if (!stream->size_known) {
+        require_io_success(fflush(stream->file) == 0, strerror(errno));
+        stream->size = file_get_size(stream->file);
+        stream->size_known = true;
+    }
+    return stream->size;
+}
+
+bool file_stream_is_eof(file_stream_t* stream) {
+    require_address(stream, "NULL file stream!");
+    return stream->hit_eof || stream->position >= file_stream_size(stream);
+}
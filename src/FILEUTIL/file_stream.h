@@ -0,0 +1,99 @@
+/**
+ * @file file_stream.h
+ * @brief FILE wrapper with cached size and O(1) EOF
+ * @defgroup file_stream File Stream
+ * @{
+ */
+#ifndef FILE_STREAM_H
+#define FILE_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * @brief Stream state, embed or allocate freely - it owns nothing
+ *
+ * @details file_get_size() and file_position_indicator_is_eof() each cost
+ * ftell + fseek(END) + ftell + fseek and the seeks discard the stdio buffer.
+ * Here the size is learned once and the position is tracked by arithmetic:
+ * @code
+ * | Call                   | stdio calls                                  |
+ * |------------------------|----------------------------------------------|
+ * | file_stream_attach     | ftell, fseek, ftell, fseek (once)            |
+ * | file_stream_read/gets  | fread/fgets only                             |
+ * | file_stream_seek       | fseek only                                   |
+ * | file_stream_size/eof   | none (size relearned once after a write)     |
+ * @endcode
+ *
+ * @warning Open the file in binary mode: positions count delivered bytes, which
+ *          text mode "\r\n" translation would make drift. A short read still ends
+ *          the stream correctly either way.
+ */
+typedef struct {
+    FILE* file;
+    long size;                  ///< Valid while size_known
+    long position;              ///< Logical position of the next read or write
+    bool size_known;            ///< Cleared by writes
+    bool hit_eof;               ///< A read came up short
+} file_stream_t;
+
+/**
+ * @brief Starts tracking an open file at its current position
+ * @param stream Stream to initialise
+ * @param file Open FILE pointer (binary mode)
+ */
+void file_stream_attach(file_stream_t* stream, FILE* file);
+
+/**
+ * @brief fread() with position tracking
+ * @return Number of complete elements read
+ */
+size_t file_stream_read(file_stream_t* stream, void* buffer, size_t size, size_t count);
+
+/**
+ * @brief fgets() with position tracking
+ * @return line or NULL at end of file
+ */
+char* file_stream_gets(file_stream_t* stream, char* line, int line_size);
+
+/**
+ * @brief fgetc() with position tracking
+ * @return Byte read or EOF
+ */
+int file_stream_getc(file_stream_t* stream);
+
+/**
+ * @brief fwrite() with position tracking, invalidates the cached size
+ * @return Number of complete elements written
+ */
+size_t file_stream_write(file_stream_t* stream, const void* buffer, size_t size, size_t count);
+
+/**
+ * @brief Moves the position, resolving SEEK_END from the cached size
+ * @param stream Tracked stream
+ * @param offset Byte offset to move
+ * @param origin Starting position (SEEK_SET/SEEK_CUR/SEEK_END)
+ * @return Previous position
+ */
+long file_stream_seek(file_stream_t* stream, long offset, int origin);
+
+/**
+ * @brief Gets the position without ftell()
+ */
+long file_stream_position(const file_stream_t* stream);
+
+/**
+ * @brief Gets the file size, relearning it only after a write
+ */
+long file_stream_size(file_stream_t* stream);
+
+/**
+ * @brief Checks for end of file without any seek
+ * @return True if at end of file, false otherwise
+ */
+bool file_stream_is_eof(file_stream_t* stream);
+
+#endif
+
+/** @} */ // end of file_stream group
@@ -4,6 +4,7 @@
 #include <stddef.h>
 
 #include "file_constants.h"
+#include "../STRUTIL/str_view.h"
 
 typedef char line_t[FILE_MAX_LINE_SIZE];
 
@@ -12,4 +13,7 @@ typedef struct {
     size_t line_count;
 } page_t;
 
+// zero-copy view of one line, not NUL terminated and without its line ending
+typedef str_view_t file_line_view_t;
+
 #endif
@@ -22,6 +22,27 @@ const char* file_get_extension(const char* file_path) {
     return last_dot + 1;  // Skip the dot
 }
 
+void file_replace_extension(const char* path_name, const char* extension, char* sidecar, size_t capacity) {
+    require_address(path_name, "NULL path name!");
+    require_address(extension, "NULL extension!");
+    require_address(sidecar, "NULL sidecar path!");
+
+    size_t length = strlen(path_name);
+    require_range(length + strlen(extension) + 2 <= capacity, "Path too long for sidecar!");
+    memcpy(sidecar, path_name, length + 1);
+
+    // only a dot in the last path component starts an extension
+    char* dot = strrchr(sidecar, FILE_EXTENSION_DELIM);
+    if (dot && (strchr(dot, '\\') || strchr(dot, '/') || dot == sidecar)) {
+        dot = NULL;
+    }
+    if (!dot) {
+        dot = sidecar + length;
+        *dot = FILE_EXTENSION_DELIM;
+    }
+    strcpy(dot + 1, extension);
+}
+
 long file_get_size(FILE* file) {
     require_fd(file, "NULL file handle!");
 
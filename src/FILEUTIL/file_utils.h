@@ -25,6 +25,18 @@
  */
 const char* file_get_extension(const char* file_path);
 
+/**
+ * @brief Makes the path of a sidecar file by replacing or adding an extension
+ * @param path_name File the sidecar belongs to
+ * @param extension New extension, without the dot
+ * @param sidecar Receives the sidecar path
+ * @param capacity Size of sidecar
+ *
+ * @retval file_replace_extension("A:\\PROG.DOP", "LIX", ...) → "A:\\PROG.LIX"
+ * file_replace_extension("DIR.V2\\PROG", "DPC", ...) → "DIR.V2\\PROG.DPC"
+ */
+void file_replace_extension(const char* path_name, const char* extension, char* sidecar, size_t capacity);
+
 /**
  * @brief Gets file size without modifying position
  * @param fhandle Valid DOS file handle
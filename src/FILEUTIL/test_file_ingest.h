@@ -0,0 +1,138 @@
+/**
+ * @file test_file_ingest.h
+ * @brief Test suite for the multi-file ingest pool
+ * @ingroup tdd_framework
+ */
+#ifndef TEST_FILE_INGEST_H
+#define TEST_FILE_INGEST_H
+
+#include "file_ingest.h"
+#include "../TDD/tdd_macros.h"
+#include "../DOS/dos_error_messages.h"
+#include "../DOS/dos_services_files.h"
+#include "../MEM/mem_arena.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define FILE_INGEST_TESTS &test_ingest_files,               \
+    &test_ingest_full_lines_arena
+
+#define TEST_INGEST_ARENA_SIZE      (MEM_SIZE_16K)
+#define TEST_INGEST_LONG_LINES      120                 /* more than a page */
+
+/* scratch files in the current directory */
+static const char* test_ingest_paths[] = { "TSTING1.TXT", "TSTING2.TXT", "TSTING3.TXT", "TSTING4.TXT" };
+
+/* ----------------- Helpers ----------------- */
+
+/**
+ * @brief Writes the scratch files: blank lines, missing, empty, longer than a page
+ */
+static int test_ingest_write(void) {
+    FILE* file = fopen(test_ingest_paths[0], "wb");
+    int written = file && fputs("a\n\nb\r\n\r\nc", file) >= 0;
+    written = file && fclose(file) == 0 && written;
+    dos_delete_file(test_ingest_paths[1]);
+    file = fopen(test_ingest_paths[2], "wb");
+    written = file && fclose(file) == 0 && written;
+    file = fopen(test_ingest_paths[3], "wb");
+    uint16_t i;
+    for (i = 0; file && i < TEST_INGEST_LONG_LINES; ++i) {
+        fprintf(file, "line %u\n", (unsigned)i);
+    }
+    return file && fclose(file) == 0 && written;
+}
+
+static void test_ingest_remove(void) {
+    uint8_t i;
+    for (i = 0; i < sizeof(test_ingest_paths) / sizeof(test_ingest_paths[0]); ++i) {
+        dos_delete_file(test_ingest_paths[i]);
+    }
+}
+
+/* ----------------- Ingest Tests ----------------- */
+
+/**
+ * @brief Every file gets its own result, in submission order
+ * @details Three workers read, twice with a reset in between:
+ * - a file with blank LF and CRLF lines: every line, blank ones as ""
+ * - a missing file: DOS_FILE_NOT_FOUND and no lines
+ * - an empty file: DOS_INVALID_DATA
+ * - a file longer than a page: the first FILE_MAX_PAGE_SIZE lines, truncated
+ */
+TEST(test_ingest_files)
+{
+    static const char* lines[] = { "a", "", "b", "", "c" };
+    ASSERT(test_ingest_write());
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_INGEST_ARENA_SIZE);
+    ASSERT(arena != NULL);
+    file_ingest_t* ingest = file_ingest_create(arena, 3, TEST_INGEST_ARENA_SIZE);
+
+    uint8_t run;
+    for (run = 0; run < 2; ++run) {
+        file_ingest_result_t* results = file_ingest_run(ingest, test_ingest_paths, 4);
+        uint8_t i;
+        for (i = 0; i < 4; ++i) {
+            EXPECT(results[i].path_name == test_ingest_paths[i]);
+            V(printf("%s: %lu lines, %s\n", results[i].path_name, (unsigned long)results[i].page.line_count,
+                     dos_error_messages[results[i].err_code]););
+        }
+        ASSERT(results[0].page.line_count == sizeof(lines) / sizeof(lines[0]));
+        for (i = 0; i < sizeof(lines) / sizeof(lines[0]); ++i) {
+            EXPECT(strcmp(*results[0].page.lines[i], lines[i]) == 0);
+        }
+        EXPECT(results[0].err_code == DOS_SUCCESS && !results[0].truncated);
+        EXPECT(results[1].err_code == DOS_FILE_NOT_FOUND && results[1].page.line_count == 0);
+        EXPECT(results[2].err_code == DOS_INVALID_DATA && results[2].page.line_count == 0);
+        EXPECT(results[3].err_code == DOS_SUCCESS && results[3].truncated);
+        ASSERT(results[3].page.line_count == FILE_MAX_PAGE_SIZE);
+        EXPECT(strcmp(*results[3].page.lines[FILE_MAX_PAGE_SIZE - 1], "line 98") == 0);
+        file_ingest_reset(ingest);
+    }
+
+    file_ingest_delete(ingest);
+    mem_arena_delete(arena);
+    test_ingest_remove();
+}
+
+/**
+ * @brief A full lines arena ends its files, not the run
+ * @details One worker with room for three lines reads the blank line file and
+ *          keeps its first three lines with DOS_INSUFFICIENT_MEMORY. The files
+ *          after it still get their own results: the missing one still reports
+ *          DOS_FILE_NOT_FOUND. The arena stays full for the next run until
+ *          file_ingest_reset(), after which three blank lines fit again.
+ */
+TEST(test_ingest_full_lines_arena)
+{
+    ASSERT(test_ingest_write());
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_INGEST_ARENA_SIZE);
+    ASSERT(arena != NULL);
+    file_ingest_t* ingest = file_ingest_create(arena, 1, 3 * sizeof(line_t) + sizeof(line_t) / 2);
+
+    file_ingest_result_t* results = file_ingest_run(ingest, test_ingest_paths, 2);
+    EXPECT(results[0].err_code == DOS_INSUFFICIENT_MEMORY);
+    ASSERT(results[0].page.line_count == 3);
+    EXPECT(strcmp(*results[0].page.lines[0], "a") == 0);
+    EXPECT(strcmp(*results[0].page.lines[1], "") == 0);
+    EXPECT(strcmp(*results[0].page.lines[2], "b") == 0);
+    EXPECT(results[1].err_code == DOS_FILE_NOT_FOUND);
+
+    /* the arena is still full until it is reset */
+    results = file_ingest_run(ingest, test_ingest_paths, 1);
+    EXPECT(results[0].err_code == DOS_INSUFFICIENT_MEMORY && results[0].page.line_count == 0);
+    file_ingest_reset(ingest);
+    FILE* file = fopen(test_ingest_paths[0], "wb");
+    ASSERT(file != NULL);
+    fputs("\n\n\n", file);
+    fclose(file);
+    results = file_ingest_run(ingest, test_ingest_paths, 1);
+    EXPECT(results[0].err_code == DOS_SUCCESS && results[0].page.line_count == 3);
+
+    file_ingest_delete(ingest);
+    mem_arena_delete(arena);
+    test_ingest_remove();
+}
+
+#endif
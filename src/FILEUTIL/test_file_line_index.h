@@ -0,0 +1,278 @@
+/**
+ * @file test_file_line_index.h
+ * @brief Test suite for the line offset index and its sidecar
+ * @ingroup tdd_framework
+ */
+#ifndef TEST_FILE_LINE_INDEX_H
+#define TEST_FILE_LINE_INDEX_H
+
+#include "file_line_index.h"
+#include "../TDD/tdd_macros.h"
+#include "../DOS/dos_services_files.h"
+#include "../DOS/dos_services_files_constants.h"
+#include "../MEM/mem_arena.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define FILE_LINE_INDEX_TESTS &test_line_index_offsets,     \
+    &test_line_index_sidecar,                               \
+    &test_line_index_damaged_sidecar,                       \
+    &test_line_index_checkpoints
+
+#define TEST_LIX_FILE           "TSTLIX.TXT"    /* scratch files in the current directory */
+#define TEST_LIX_SIDECAR        "TSTLIX.LIX"
+#define TEST_LIX_ARENA_SIZE     (MEM_SIZE_64K - 16)
+#define TEST_LIX_LINES          200
+#define TEST_LIX_LINE_SIZE      160
+#define TEST_LIX_SIDECAR_SIZE   1024
+
+/* ----------------- Helpers ----------------- */
+
+/**
+ * @brief Replaces a file with the given bytes
+ */
+static int test_lix_write(const char* path_name, const void* data, size_t nbytes) {
+    FILE* file = fopen(path_name, "wb");
+    if (!file) {
+        return 0;
+    }
+    size_t written = fwrite(data, 1, nbytes, file);
+    return fclose(file) == 0 && written == nbytes;
+}
+
+/**
+ * @brief Text of a test line: lengths vary from 0 to over 127 bytes, for two byte deltas
+ */
+static size_t test_lix_line(uint32_t line, char* text) {
+    size_t length = (size_t)sprintf(text, "%lu", (unsigned long)line);
+    size_t pad = (line * 37) % (TEST_LIX_LINE_SIZE - 16);
+    memset(text + length, line % 2 ? '-' : '=', pad);
+    length += pad;
+    text[length] = '\0';
+    return length;
+}
+
+/**
+ * @brief Writes TEST_LIX_LINES test lines with CRLF endings
+ */
+static int test_lix_write_lines(void) {
+    FILE* file = fopen(TEST_LIX_FILE, "wb");
+    if (!file) {
+        return 0;
+    }
+    char text[TEST_LIX_LINE_SIZE];
+    uint32_t line;
+    for (line = 0; line < TEST_LIX_LINES; ++line) {
+        test_lix_line(line, text);
+        fprintf(file, "%s\r\n", text);
+    }
+    return fclose(file) == 0;
+}
+
+/* ----------------- Build Tests ----------------- */
+
+/**
+ * @brief Offsets of the first byte of every line
+ * @details Verifies CRLF lines, a last line without a line ending, blank lines,
+ *          and an empty file, which has no lines. read_line() strips the ending.
+ */
+TEST(test_line_index_offsets)
+{
+    static const struct {
+        const char* text;
+        uint32_t line_count;
+        uint32_t offsets[4];
+        const char* last;
+    } cases[] = {
+        { "ab\r\ncd\r\n",       2, { 0, 4 },        "cd" },
+        { "a\nbc\nd",           3, { 0, 2, 5 },     "d" },
+        { "\n\r\n\nx\n",        4, { 0, 1, 3, 4 },  "x" },
+        { "\n",                 1, { 0 },           "" },
+        { "",                   0, { 0 },           NULL }
+    };
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_LIX_ARENA_SIZE);
+    ASSERT(arena != NULL);
+
+    uint8_t i;
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        mem_size_t used = mem_arena_used(arena);
+        ASSERT(test_lix_write(TEST_LIX_FILE, cases[i].text, strlen(cases[i].text)));
+        file_line_index_t* index = file_line_index_build(arena, TEST_LIX_FILE);
+        ASSERT(index != NULL);
+        EXPECT(index->header.line_count == cases[i].line_count);
+        EXPECT(index->header.file_size == strlen(cases[i].text));
+        uint32_t line;
+        for (line = 0; line < cases[i].line_count && line < index->header.line_count; ++line) {
+            EXPECT(file_line_index_offset(index, line) == (dos_file_position_t)cases[i].offsets[line]);
+        }
+        if (cases[i].last && index->header.line_count == cases[i].line_count) {
+            char buffer[TEST_LIX_LINE_SIZE];
+            dos_file_handle_t fhandle = dos_open_file(TEST_LIX_FILE, ACCESS_READ_ONLY);
+            ASSERT(fhandle);
+            EXPECT(file_line_index_read_line(index, fhandle, cases[i].line_count - 1, buffer, sizeof(buffer)) == strlen(cases[i].last));
+            EXPECT(strcmp(buffer, cases[i].last) == 0);
+            dos_close_file(fhandle);
+        }
+        mem_arena_dealloc(arena, mem_arena_used(arena) - used);
+    }
+
+    dos_last_error_clear();
+    dos_delete_file(TEST_LIX_FILE);
+    EXPECT(file_line_index_build(arena, TEST_LIX_FILE) == NULL);
+    EXPECT(dos_last_error_code() == DOS_FILE_NOT_FOUND);
+
+    mem_arena_delete(arena);
+}
+
+/* ----------------- Sidecar Tests ----------------- */
+
+/**
+ * @brief The sidecar round trip and a stale sidecar
+ * @details open() builds and saves the sidecar, which then loads with the same
+ *          lines and offsets. After an edit the sidecar is stale: load() refuses
+ *          it and open() indexes the edited file and saves a current sidecar.
+ */
+TEST(test_line_index_sidecar)
+{
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_LIX_ARENA_SIZE);
+    ASSERT(arena != NULL);
+    dos_delete_file(TEST_LIX_SIDECAR);
+    ASSERT(test_lix_write_lines());
+
+    EXPECT(file_line_index_load(arena, TEST_LIX_FILE) == NULL);
+    file_line_index_t* built = file_line_index_open(arena, TEST_LIX_FILE);
+    ASSERT(built != NULL);
+    file_line_index_t* loaded = file_line_index_load(arena, TEST_LIX_FILE);
+    ASSERT(loaded != NULL);
+    EXPECT(memcmp(&loaded->header, &built->header, sizeof(file_line_index_header_t)) == 0);
+    EXPECT(memcmp(loaded->deltas, built->deltas, built->header.delta_bytes) == 0);
+    uint32_t line;
+    for (line = 0; line < TEST_LIX_LINES; ++line) {
+        EXPECT(file_line_index_offset(loaded, line) == file_line_index_offset(built, line));
+    }
+    V(printf("%lu lines in %lu delta bytes\n", (unsigned long)loaded->header.line_count, (unsigned long)loaded->header.delta_bytes););
+
+    mem_arena_dealloc(arena, mem_arena_used(arena));
+
+    ASSERT(test_lix_write(TEST_LIX_FILE, "edited\nfile\n", 12));
+    EXPECT(file_line_index_load(arena, TEST_LIX_FILE) == NULL);
+    file_line_index_t* edited = file_line_index_open(arena, TEST_LIX_FILE);
+    ASSERT(edited != NULL);
+    EXPECT(edited->header.line_count == 2);
+    EXPECT(file_line_index_offset(edited, 1) == 7);
+    loaded = file_line_index_load(arena, TEST_LIX_FILE);
+    EXPECT(loaded != NULL && loaded->header.line_count == 2);
+
+    dos_delete_file(TEST_LIX_SIDECAR);
+    dos_delete_file(TEST_LIX_FILE);
+    mem_arena_delete(arena);
+}
+
+/**
+ * @brief A damaged sidecar of an unchanged file is never used
+ * @details The sidecar keeps the file's size and stamp but has too many or too
+ *          few lines, a wrong delta byte count, a cut off or overlong delta
+ *          stream, or deltas that run past the end of the file. load() must
+ *          refuse each without aborting and leave the arena as it found it,
+ *          and open() must index the file again.
+ */
+TEST(test_line_index_damaged_sidecar)
+{
+    static uint8_t sidecar[TEST_LIX_SIDECAR_SIZE];
+    static uint8_t damaged[TEST_LIX_SIDECAR_SIZE];
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_LIX_ARENA_SIZE);
+    ASSERT(arena != NULL);
+    dos_delete_file(TEST_LIX_SIDECAR);
+    ASSERT(test_lix_write_lines());
+    ASSERT(file_line_index_open(arena, TEST_LIX_FILE) != NULL);
+    mem_arena_dealloc(arena, mem_arena_used(arena));
+
+    FILE* file = fopen(TEST_LIX_SIDECAR, "rb");
+    ASSERT(file != NULL);
+    size_t size = fread(sidecar, 1, sizeof(sidecar), file);
+    fclose(file);
+    ASSERT(size > sizeof(file_line_index_header_t) && size < sizeof(sidecar));
+    file_line_index_header_t header;
+    memcpy(&header, sidecar, sizeof(header));
+
+    const size_t deltas = sizeof(file_line_index_header_t);
+    uint8_t i;
+    for (i = 0; i < 8; ++i) {
+        file_line_index_header_t patched = header;
+        size_t damaged_size = size;
+        memcpy(damaged, sidecar, size);
+        switch (i) {
+        case 0: patched.line_count += 1; break;                             /* one line more than the deltas */
+        case 1: patched.line_count -= 1; break;                             /* the last delta is left over */
+        case 2: patched.line_count = 0xFFFFFFFFUL; break;
+        case 3: patched.delta_bytes -= 1; break;                            /* does not match the sidecar */
+        case 4: patched.delta_bytes += 1; damaged[damaged_size++] = 1; break;   /* a delta too many */
+        case 5: damaged_size -= 1; patched.delta_bytes -= 1; break;         /* stream cut off */
+        case 6: damaged[size - 1] |= 0x80; break;                           /* last delta never ends */
+        default: damaged[deltas] = 0x7F; break;                             /* line 1 moves, the last past the end */
+        }
+        memcpy(damaged, &patched, sizeof(patched));
+        ASSERT(test_lix_write(TEST_LIX_SIDECAR, damaged, damaged_size));
+        EXPECT(file_line_index_load(arena, TEST_LIX_FILE) == NULL);
+        EXPECT(mem_arena_used(arena) == 0);
+        file_line_index_t* index = file_line_index_open(arena, TEST_LIX_FILE);
+        ASSERT(index != NULL);
+        EXPECT(memcmp(&index->header, &header, sizeof(header)) == 0);
+        mem_arena_dealloc(arena, mem_arena_used(arena));
+        EXPECT(file_line_index_load(arena, TEST_LIX_FILE) != NULL);     /* open() saved a good one */
+        mem_arena_dealloc(arena, mem_arena_used(arena));
+    }
+
+    dos_delete_file(TEST_LIX_SIDECAR);
+    dos_delete_file(TEST_LIX_FILE);
+    mem_arena_delete(arena);
+}
+
+/* ----------------- Lookup Tests ----------------- */
+
+/**
+ * @brief Every line reads back through the checkpoints
+ * @details 200 CRLF lines of 1 to 146 bytes span four checkpoints, with one and
+ *          two byte deltas. Every line, those on either side of a checkpoint
+ *          included, reads back as written, and a short buffer truncates it.
+ */
+TEST(test_line_index_checkpoints)
+{
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_LIX_ARENA_SIZE);
+    ASSERT(arena != NULL);
+    ASSERT(test_lix_write_lines());
+    file_line_index_t* index = file_line_index_build(arena, TEST_LIX_FILE);
+    ASSERT(index != NULL);
+    ASSERT(index->header.line_count == TEST_LIX_LINES);
+    EXPECT(index->header.delta_bytes > TEST_LIX_LINES - 1);       /* some deltas took two bytes */
+
+    dos_file_handle_t fhandle = dos_open_file(TEST_LIX_FILE, ACCESS_READ_ONLY);
+    ASSERT(fhandle);
+    char expected[TEST_LIX_LINE_SIZE];
+    char buffer[TEST_LIX_LINE_SIZE];
+    uint32_t offset = 0;
+    uint32_t line;
+    for (line = 0; line < TEST_LIX_LINES; ++line) {
+        size_t length = test_lix_line(line, expected);
+        EXPECT(file_line_index_offset(index, line) == (dos_file_position_t)offset);
+        EXPECT(file_line_index_read_line(index, fhandle, line, buffer, sizeof(buffer)) == length);
+        EXPECT(strcmp(buffer, expected) == 0);
+        offset += (uint32_t)length + 2;
+    }
+    static const uint32_t around[] = { 63, 64, 65, 127, 128, 199 };
+    for (line = 0; line < sizeof(around) / sizeof(around[0]); ++line) {
+        test_lix_line(around[line], expected);
+        EXPECT(file_line_index_read_line(index, fhandle, around[line], buffer, sizeof(buffer)) == strlen(expected));
+        EXPECT(strcmp(buffer, expected) == 0);
+        EXPECT(file_line_index_read_line(index, fhandle, around[line], buffer, 3) == 2);
+        EXPECT(strncmp(buffer, expected, 2) == 0 && buffer[2] == '\0');
+    }
+    dos_close_file(fhandle);
+
+    dos_delete_file(TEST_LIX_FILE);
+    mem_arena_delete(arena);
+}
+
+#endif
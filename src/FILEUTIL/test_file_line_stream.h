@@ -0,0 +1,292 @@
+/**
+ * @file test_file_line_stream.h
+ * @brief Test suite for the streaming line reader
+ * @ingroup tdd_framework
+ */
+#ifndef TEST_FILE_LINE_STREAM_H
+#define TEST_FILE_LINE_STREAM_H
+
+#include "file_line_stream.h"
+#include "file_source.h"
+#include "../TDD/tdd_macros.h"
+#include "../DOS/dos_error_messages.h"
+#include "../DOS/dos_last_error.h"
+#include "../DOS/dos_services_files.h"
+#include "../MEM/mem_arena.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define FILE_LINE_STREAM_TESTS &test_line_stream_chunk_boundaries, \
+    &test_line_stream_long_lines,                           \
+    &test_line_stream_foreign_allocation,                   \
+    &test_line_stream_source_error,                         \
+    &test_line_stream_open
+
+#define TEST_STREAM_FILE        "TSTSTRM.TXT"   /* scratch file in the current directory */
+#define TEST_STREAM_ARENA_SIZE  (MEM_SIZE_16K)
+#define TEST_STREAM_LONG_LINE   3000
+
+/* ----------------- Helpers ----------------- */
+
+/**
+ * @brief Test source: a buffer handed out chunk_size bytes at a time
+ */
+typedef struct {
+    const char* data;
+    uint32_t size;
+    uint32_t position;
+    uint16_t chunk_size;
+    mem_arena_t* arena;         ///< Allocated from on every chunk when set
+    uint16_t fail_after;        ///< Chunks before DOS_READ_FAULT, 0 = never
+    uint16_t chunks;
+} test_stream_chunks_t;
+
+static const char* test_stream_chunks_next(file_source_t* source, uint16_t* nbytes) {
+    test_stream_chunks_t* chunks = (test_stream_chunks_t*)source->state;
+    if (chunks->fail_after && chunks->chunks == chunks->fail_after) {
+        source->err_code = DOS_READ_FAULT;
+        return NULL;
+    }
+    uint32_t remaining = chunks->size - chunks->position;
+    if (!remaining) {
+        return NULL;
+    }
+    if (chunks->arena) {
+        mem_arena_alloc(chunks->arena, 8);  /* lands between two stitched pieces */
+    }
+    *nbytes = remaining < chunks->chunk_size ? (uint16_t)remaining : chunks->chunk_size;
+    const char* chunk = chunks->data + chunks->position;
+    chunks->position += *nbytes;
+    ++chunks->chunks;
+    return chunk;
+}
+
+static const file_source_vtable_t test_stream_chunks_vtable = { test_stream_chunks_next, NULL };
+
+/**
+ * @brief Makes a chunked source over text
+ */
+static void test_stream_chunks(file_source_t* source, test_stream_chunks_t* chunks, const char* text, uint16_t chunk_size) {
+    memset(chunks, 0, sizeof(test_stream_chunks_t));
+    chunks->data = text;
+    chunks->size = (uint32_t)strlen(text);
+    chunks->chunk_size = chunk_size;
+    memset(source, 0, sizeof(file_source_t));
+    source->vtable = &test_stream_chunks_vtable;
+    source->state = chunks;
+}
+
+/**
+ * @brief Whether a view holds exactly text
+ */
+static int test_stream_equals(file_line_view_t line, const char* text) {
+    return line.length == strlen(text) && memcmp(line.ptr, text, line.length) == 0;
+}
+
+/* ----------------- Line Tests ----------------- */
+
+/**
+ * @brief Lines come out the same whatever the chunk boundaries
+ * @details Every chunk size from 1 byte to the whole text puts line endings, and
+ *          the '\r' and '\n' of CRLF pairs, on either side of a boundary. Each
+ *          must give the same lines, blank ones as zero length views, numbered
+ *          from 1, and end cleanly. A final line ending adds no blank line, a
+ *          last line without one is still a line.
+ */
+TEST(test_line_stream_chunk_boundaries)
+{
+    static const struct {
+        const char* text;
+        const char* lines[6];
+        uint8_t count;
+    } cases[] = {
+        { "alpha\nbeta\r\n\r\ngamma delta\r\nlast",     { "alpha", "beta", "", "gamma delta", "last" },  5 },
+        { "\r\n\n\r\nx\r\n",                            { "", "", "", "x" },                             4 },
+        { "one line without an ending\r",               { "one line without an ending" },                1 },
+        { "",                                           { "" },                                          0 }
+    };
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_STREAM_ARENA_SIZE);
+    ASSERT(arena != NULL);
+
+    uint8_t c;
+    for (c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+        uint16_t chunk_size;
+        uint16_t size = (uint16_t)strlen(cases[c].text);
+        for (chunk_size = 1; chunk_size <= (size ? size : 1); ++chunk_size) {
+            mem_size_t used = mem_arena_used(arena);
+            file_source_t source;
+            test_stream_chunks_t chunks;
+            test_stream_chunks(&source, &chunks, cases[c].text, chunk_size);
+            file_line_stream_t* stream = file_line_stream_create(arena, &source);
+            ASSERT(stream != NULL);
+            file_line_view_t line;
+            uint8_t i;
+            for (i = 0; i < cases[c].count; ++i) {
+                ASSERT(file_line_stream_next(stream, &line));
+                EXPECT(test_stream_equals(line, cases[c].lines[i]));
+                EXPECT(file_line_stream_line_number(stream) == (uint32_t)i + 1);
+            }
+            EXPECT(!file_line_stream_next(stream, &line));
+            EXPECT(!file_line_stream_next(stream, &line));
+            EXPECT(file_line_stream_error(stream) == DOS_SUCCESS);
+            file_line_stream_close(stream);
+            mem_arena_dealloc(arena, mem_arena_used(arena) - used);
+        }
+    }
+
+    mem_arena_delete(arena);
+}
+
+/**
+ * @brief Lines longer than a chunk are stitched, lines longer than the arena end the stream
+ * @details A 3000 byte line read in 16 byte chunks comes back whole between two
+ *          short lines. In a 2K arena the same line breaks the stream off with
+ *          DOS_INSUFFICIENT_MEMORY: the lines before it are returned, the cut
+ *          line and everything after it are not.
+ */
+TEST(test_line_stream_long_lines)
+{
+    static char text[TEST_STREAM_LONG_LINE + 16];
+    strcpy(text, "first\r\n");
+    size_t length = strlen(text);
+    memset(text + length, 'y', TEST_STREAM_LONG_LINE);
+    length += TEST_STREAM_LONG_LINE;
+    strcpy(text + length, "\r\nafter\n");
+
+    uint8_t small;
+    for (small = 0; small < 2; ++small) {
+        mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, small ? MEM_SIZE_2K : TEST_STREAM_ARENA_SIZE);
+        ASSERT(arena != NULL);
+        file_source_t source;
+        test_stream_chunks_t chunks;
+        test_stream_chunks(&source, &chunks, text, 16);
+        file_line_stream_t* stream = file_line_stream_create(arena, &source);
+        ASSERT(stream != NULL);
+        file_line_view_t line;
+        ASSERT(file_line_stream_next(stream, &line));
+        EXPECT(test_stream_equals(line, "first"));
+        if (small) {
+            EXPECT(!file_line_stream_next(stream, &line));
+            EXPECT(file_line_stream_error(stream) == DOS_INSUFFICIENT_MEMORY);
+            EXPECT(!file_line_stream_next(stream, &line));
+            EXPECT(file_line_stream_line_number(stream) == 1);
+        } else {
+            ASSERT(file_line_stream_next(stream, &line));
+            EXPECT(line.length == TEST_STREAM_LONG_LINE);
+            EXPECT(line.ptr[0] == 'y' && line.ptr[TEST_STREAM_LONG_LINE - 1] == 'y');
+            ASSERT(file_line_stream_next(stream, &line));
+            EXPECT(test_stream_equals(line, "after"));
+            EXPECT(!file_line_stream_next(stream, &line));
+            EXPECT(file_line_stream_error(stream) == DOS_SUCCESS);
+        }
+        file_line_stream_close(stream);
+        mem_arena_delete(arena);
+    }
+}
+
+/**
+ * @brief A source that allocates from the stream's arena does not break stitching
+ * @details The source takes 8 bytes of the arena on every chunk, so each piece of
+ *          a stitched line lands apart from the one before. Lines still come back
+ *          whole, for chunk sizes 1 to 8.
+ */
+TEST(test_line_stream_foreign_allocation)
+{
+    static const char text[] = "stitched across chunks\r\nagain\r\n";
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_STREAM_ARENA_SIZE);
+    ASSERT(arena != NULL);
+
+    uint16_t chunk_size;
+    for (chunk_size = 1; chunk_size <= 8; ++chunk_size) {
+        mem_size_t used = mem_arena_used(arena);
+        file_source_t source;
+        test_stream_chunks_t chunks;
+        test_stream_chunks(&source, &chunks, text, chunk_size);
+        chunks.arena = arena;
+        file_line_stream_t* stream = file_line_stream_create(arena, &source);
+        ASSERT(stream != NULL);
+        file_line_view_t line;
+        ASSERT(file_line_stream_next(stream, &line));
+        EXPECT(test_stream_equals(line, "stitched across chunks"));
+        ASSERT(file_line_stream_next(stream, &line));
+        EXPECT(test_stream_equals(line, "again"));
+        EXPECT(!file_line_stream_next(stream, &line));
+        EXPECT(file_line_stream_error(stream) == DOS_SUCCESS);
+        mem_arena_dealloc(arena, mem_arena_used(arena) - used);
+    }
+
+    mem_arena_delete(arena);
+}
+
+/**
+ * @brief A read error ends the stream with the source's error
+ * @details The source fails after two 4 byte chunks, in the middle of the second
+ *          line: the first line is returned, the cut one is not, and the error
+ *          is the source's.
+ */
+TEST(test_line_stream_source_error)
+{
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_STREAM_ARENA_SIZE);
+    ASSERT(arena != NULL);
+    file_source_t source;
+    test_stream_chunks_t chunks;
+    test_stream_chunks(&source, &chunks, "ab\ncdefgh\n", 4);
+    chunks.fail_after = 2;
+    file_line_stream_t* stream = file_line_stream_create(arena, &source);
+    ASSERT(stream != NULL);
+
+    file_line_view_t line;
+    ASSERT(file_line_stream_next(stream, &line));
+    EXPECT(test_stream_equals(line, "ab"));
+    EXPECT(!file_line_stream_next(stream, &line));
+    EXPECT(file_line_stream_error(stream) == DOS_READ_FAULT);
+    EXPECT(file_line_stream_line_number(stream) == 1);
+    EXPECT(!file_line_stream_next(stream, &line));
+
+    mem_arena_delete(arena);
+}
+
+/**
+ * @brief Streaming a file through small prefetch buffers
+ * @details Buffers of 1, 2, 3 and 512 bytes give the same lines. A missing file
+ *          does not open, with DOS_FILE_NOT_FOUND recorded.
+ */
+TEST(test_line_stream_open)
+{
+    static const uint16_t buffer_sizes[] = { 1, 2, 3, 512 };
+    static const char text[] = "10'P'1\r\n\r\n20'N\r\n";
+    FILE* file = fopen(TEST_STREAM_FILE, "wb");
+    ASSERT(file != NULL);
+    fputs(text, file);
+    fclose(file);
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_STREAM_ARENA_SIZE);
+    ASSERT(arena != NULL);
+
+    uint8_t b;
+    for (b = 0; b < sizeof(buffer_sizes) / sizeof(buffer_sizes[0]); ++b) {
+        mem_size_t used = mem_arena_used(arena);
+        file_line_stream_t* stream = file_line_stream_open(arena, TEST_STREAM_FILE, buffer_sizes[b]);
+        ASSERT(stream != NULL);
+        file_line_view_t line;
+        ASSERT(file_line_stream_next(stream, &line));
+        EXPECT(test_stream_equals(line, "10'P'1"));
+        ASSERT(file_line_stream_next(stream, &line));
+        EXPECT(line.length == 0);
+        ASSERT(file_line_stream_next(stream, &line));
+        EXPECT(test_stream_equals(line, "20'N"));
+        EXPECT(!file_line_stream_next(stream, &line));
+        EXPECT(file_line_stream_error(stream) == DOS_SUCCESS);
+        file_line_stream_close(stream);
+        mem_arena_dealloc(arena, mem_arena_used(arena) - used);
+    }
+
+    dos_delete_file(TEST_STREAM_FILE);
+    dos_last_error_clear();
+    EXPECT(file_line_stream_open(arena, TEST_STREAM_FILE, 64) == NULL);
+    EXPECT(dos_last_error_code() == DOS_FILE_NOT_FOUND);
+
+    mem_arena_delete(arena);
+}
+
+#endif
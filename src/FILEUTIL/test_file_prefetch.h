@@ -0,0 +1,224 @@
+/**
+ * @file test_file_prefetch.h
+ * @brief Test suite for the double-buffered file prefetcher
+ * @ingroup tdd_framework
+ */
+#ifndef TEST_FILE_PREFETCH_H
+#define TEST_FILE_PREFETCH_H
+
+#include "file_prefetch.h"
+#include "../TDD/tdd_macros.h"
+#include "../DOS/dos_error_messages.h"
+#include "../DOS/dos_last_error.h"
+#include "../DOS/dos_services_files.h"
+#include "../MEM/mem_arena.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define FILE_PREFETCH_TESTS &test_prefetch_buffers,         \
+    &test_prefetch_lines_match_fgets,                       \
+    &test_prefetch_errors
+
+#define TEST_PREFETCH_FILE          "TSTPRE.TXT"    /* scratch file in the current directory */
+#define TEST_PREFETCH_ARENA_SIZE    (MEM_SIZE_16K)
+#define TEST_PREFETCH_FILE_SIZE     5000
+
+/* ----------------- Helpers ----------------- */
+
+/**
+ * @brief Replaces the scratch file with the given bytes
+ */
+static int test_prefetch_write(const char* data, size_t nbytes) {
+    FILE* file = fopen(TEST_PREFETCH_FILE, "wb");
+    if (!file) {
+        return 0;
+    }
+    size_t written = fwrite(data, 1, nbytes, file);
+    return fclose(file) == 0 && written == nbytes;
+}
+
+/* ----------------- Buffer Tests ----------------- */
+
+/**
+ * @brief The buffers hand over the whole file, in order, then end
+ * @details Reads a 5000 byte file through buffers of 1, 7, 512 and 4096 bytes:
+ *          the buffers joined must be the file, no buffer may be longer than the
+ *          buffer size, and after the end every call returns NULL with no error.
+ *          An empty file ends on the first call.
+ */
+TEST(test_prefetch_buffers)
+{
+    static const uint16_t buffer_sizes[] = { 1, 7, 512, 4096 };
+    static char data[TEST_PREFETCH_FILE_SIZE];
+    static char joined[TEST_PREFETCH_FILE_SIZE];
+    uint16_t i;
+    for (i = 0; i < sizeof(data); ++i) {
+        data[i] = (char)('a' + (i * 7 + i / 26) % 26);
+    }
+    ASSERT(test_prefetch_write(data, sizeof(data)));
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_PREFETCH_ARENA_SIZE);
+    ASSERT(arena != NULL);
+
+    uint8_t b;
+    for (b = 0; b < sizeof(buffer_sizes) / sizeof(buffer_sizes[0]); ++b) {
+        mem_size_t used = mem_arena_used(arena);
+        file_prefetch_t* prefetch = file_prefetch_open(arena, TEST_PREFETCH_FILE, buffer_sizes[b]);
+        ASSERT(prefetch != NULL);
+        const char* buffer;
+        uint16_t nbytes;
+        uint32_t total = 0;
+        int fits = 1;
+        while ((buffer = file_prefetch_next(prefetch, &nbytes)) != NULL) {
+            fits = fits && nbytes <= buffer_sizes[b] && total + nbytes <= sizeof(joined);
+            if (fits) {
+                memcpy(joined + total, buffer, nbytes);
+            }
+            total += nbytes;
+        }
+        EXPECT(fits);
+        EXPECT(total == sizeof(data));
+        EXPECT(memcmp(joined, data, sizeof(data)) == 0);
+        EXPECT(nbytes == 0);
+        EXPECT(file_prefetch_next(prefetch, &nbytes) == NULL);
+        EXPECT(file_prefetch_error(prefetch) == DOS_SUCCESS);
+        V(printf("%u byte buffers: %lu bytes\n", (unsigned)buffer_sizes[b], (unsigned long)total););
+        file_prefetch_close(prefetch);
+        mem_arena_dealloc(arena, mem_arena_used(arena) - used);
+    }
+
+    ASSERT(test_prefetch_write("", 0));
+    file_prefetch_t* prefetch = file_prefetch_open(arena, TEST_PREFETCH_FILE, 64);
+    ASSERT(prefetch != NULL);
+    uint16_t nbytes;
+    EXPECT(file_prefetch_next(prefetch, &nbytes) == NULL && nbytes == 0);
+    EXPECT(file_prefetch_next_line(arena, prefetch) == NULL);
+    EXPECT(file_prefetch_error(prefetch) == DOS_SUCCESS);
+    file_prefetch_close(prefetch);
+
+    dos_delete_file(TEST_PREFETCH_FILE);
+    mem_arena_delete(arena);
+}
+
+/* ----------------- Line Tests ----------------- */
+
+/**
+ * @brief Lines split exactly as fgets() splits them
+ * @details The file has blank LF and CRLF lines, a line three times longer than a
+ *          line_t and a last line without a line ending. fgets() into a line_t,
+ *          cut at the first '\r' or '\n', is the reference. Buffers of 1, 7 and
+ *          4096 bytes put line endings, CRLF pairs included, across buffer
+ *          boundaries. file_prefetch_read_line() and file_prefetch_next_line()
+ *          must both return the reference lines, blank ones as "", then NULL.
+ */
+TEST(test_prefetch_lines_match_fgets)
+{
+    static const uint16_t buffer_sizes[] = { 1, 7, 4096 };
+    static char data[4 * FILE_MAX_LINE_SIZE];
+    static line_t expected[FILE_MAX_PAGE_SIZE];
+    size_t length = 0;
+    length += sprintf(data + length, "first\n\nsecond\r\n\r\n");
+    memset(data + length, 'x', 3 * FILE_MAX_LINE_SIZE);
+    length += 3 * FILE_MAX_LINE_SIZE;
+    length += sprintf(data + length, "\nlast");
+    ASSERT(test_prefetch_write(data, length));
+
+    FILE* file = fopen(TEST_PREFETCH_FILE, "rb");
+    ASSERT(file != NULL);
+    size_t count = 0;
+    while (count < FILE_MAX_PAGE_SIZE && fgets(expected[count], FILE_MAX_LINE_SIZE, file)) {
+        expected[count][strcspn(expected[count], "\r\n")] = '\0';
+        ++count;
+    }
+    fclose(file);
+    ASSERT(count == 9);     /* 4 short ones, the x line as 79 + 79 + 79 + 3, the last */
+
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_PREFETCH_ARENA_SIZE);
+    ASSERT(arena != NULL);
+    uint8_t b;
+    for (b = 0; b < sizeof(buffer_sizes) / sizeof(buffer_sizes[0]); ++b) {
+        uint8_t checked;
+        for (checked = 0; checked < 2; ++checked) {
+            mem_size_t used = mem_arena_used(arena);
+            file_prefetch_t* prefetch = file_prefetch_open(arena, TEST_PREFETCH_FILE, buffer_sizes[b]);
+            ASSERT(prefetch != NULL);
+            size_t i;
+            line_t* line;
+            for (i = 0; i < count; ++i) {
+                line = checked ? file_prefetch_read_line(arena, prefetch) : file_prefetch_next_line(arena, prefetch);
+                ASSERT(line != NULL);
+                EXPECT(strcmp(*line, expected[i]) == 0);
+            }
+            line = checked ? file_prefetch_read_line(arena, prefetch) : file_prefetch_next_line(arena, prefetch);
+            EXPECT(line == NULL);
+            EXPECT(file_prefetch_error(prefetch) == DOS_SUCCESS);
+            file_prefetch_close(prefetch);
+            mem_arena_dealloc(arena, mem_arena_used(arena) - used);
+        }
+    }
+
+    dos_delete_file(TEST_PREFETCH_FILE);
+    mem_arena_delete(arena);
+}
+
+/* ----------------- Error Tests ----------------- */
+
+/**
+ * @brief Failures come back as NULL and an error code, never as an abort
+ * @details Verifies:
+ * - A missing file does not open, with DOS_FILE_NOT_FOUND recorded
+ * - An arena too small for the buffers does not open, with DOS_INSUFFICIENT_MEMORY
+ * - An arena that fills mid-file ends the lines with DOS_INSUFFICIENT_MEMORY,
+ *   keeping the ones read, and every later call returns NULL
+ * - A read error in the filler ends the file with that error (hosts that can
+ *   open a directory fail to read it; DOS refuses to open it)
+ */
+TEST(test_prefetch_errors)
+{
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_PREFETCH_ARENA_SIZE);
+    ASSERT(arena != NULL);
+
+    dos_delete_file(TEST_PREFETCH_FILE);
+    dos_last_error_clear();
+    EXPECT(file_prefetch_open(arena, TEST_PREFETCH_FILE, 64) == NULL);
+    EXPECT(dos_last_error_code() == DOS_FILE_NOT_FOUND);
+
+    ASSERT(test_prefetch_write("one\ntwo\nthree\nfour\n", 19));
+    dos_last_error_clear();
+    EXPECT(file_prefetch_open(arena, TEST_PREFETCH_FILE, TEST_PREFETCH_ARENA_SIZE) == NULL);
+    EXPECT(dos_last_error_code() == DOS_INSUFFICIENT_MEMORY);
+    mem_arena_dealloc(arena, mem_arena_used(arena));
+
+    /* the lines get an arena of their own with room for two */
+    mem_arena_t* lines = mem_arena_create(MEM_ARENA_POLICY_C, 2 * sizeof(line_t) + sizeof(line_t) / 2);
+    ASSERT(lines != NULL);
+    file_prefetch_t* prefetch = file_prefetch_open(arena, TEST_PREFETCH_FILE, 4);
+    ASSERT(prefetch != NULL);
+    line_t* line = file_prefetch_next_line(lines, prefetch);
+    EXPECT(line != NULL && strcmp(*line, "one") == 0);
+    line = file_prefetch_next_line(lines, prefetch);
+    EXPECT(line != NULL && strcmp(*line, "two") == 0);
+    EXPECT(file_prefetch_next_line(lines, prefetch) == NULL);
+    EXPECT(file_prefetch_error(prefetch) == DOS_INSUFFICIENT_MEMORY);
+    mem_arena_dealloc(lines, mem_arena_used(lines));
+    EXPECT(file_prefetch_next_line(lines, prefetch) == NULL);
+    file_prefetch_close(prefetch);
+    mem_arena_delete(lines);
+    mem_arena_dealloc(arena, mem_arena_used(arena));
+
+    dos_last_error_clear();
+    prefetch = file_prefetch_open(arena, ".", 64);
+    if (prefetch) {
+        EXPECT(file_prefetch_next_line(arena, prefetch) == NULL);
+        EXPECT(file_prefetch_error(prefetch) != DOS_SUCCESS);
+        V(printf("Directory read: %s\n", dos_error_messages[file_prefetch_error(prefetch)]););
+        file_prefetch_close(prefetch);
+    } else {
+        EXPECT(dos_last_error_code() != DOS_SUCCESS);
+    }
+
+    dos_delete_file(TEST_PREFETCH_FILE);
+    mem_arena_delete(arena);
+}
+
+#endif
@@ -0,0 +1,217 @@
+/**
+ * @file test_file_source.h
+ * @brief Test suite for the built in input sources
+ * @ingroup tdd_framework
+ */
+#ifndef TEST_FILE_SOURCE_H
+#define TEST_FILE_SOURCE_H
+
+#include "file_source.h"
+#include "../TDD/tdd_macros.h"
+#include "../DOS/dos_error_messages.h"
+#include "../DOS/dos_last_error.h"
+#include "../DOS/dos_services_files.h"
+#include "../MEM/mem_arena.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef __DOS__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define FILE_SOURCE_TESTS &test_source_memory,              \
+    &test_source_replay,                                    \
+    &test_source_dos,                                       \
+    &test_source_fd
+
+#define TEST_SOURCE_FILE        "TSTSRC.TXT"    /* scratch file in the current directory */
+#define TEST_SOURCE_ARENA_SIZE  (MEM_SIZE_16K)
+
+/* ----------------- Helpers ----------------- */
+
+/**
+ * @brief Replaces the scratch file with text
+ */
+static int test_source_write(const char* text) {
+    FILE* file = fopen(TEST_SOURCE_FILE, "wb");
+    if (!file) {
+        return 0;
+    }
+    size_t written = fwrite(text, 1, strlen(text), file);
+    return fclose(file) == 0 && written == strlen(text);
+}
+
+/**
+ * @brief Joins every chunk of a source into buffer
+ * @return Bytes joined, or capacity + 1 if a chunk was empty or longer than max_chunk
+ */
+static size_t test_source_drain(file_source_t* source, char* buffer, size_t capacity, uint16_t max_chunk) {
+    size_t total = 0;
+    const char* chunk;
+    uint16_t nbytes;
+    while ((chunk = file_source_next(source, &nbytes)) != NULL) {
+        if (!nbytes || nbytes > max_chunk || total + nbytes > capacity) {
+            return capacity + 1;
+        }
+        memcpy(buffer + total, chunk, nbytes);
+        total += nbytes;
+    }
+    return nbytes == 0 ? total : capacity + 1;
+}
+
+/* ----------------- Source Tests ----------------- */
+
+/**
+ * @brief The memory source hands out the caller's buffer itself
+ * @details The first chunk is the buffer, then the source ends for good. An empty
+ *          buffer ends at once. Hosts also check that a buffer over
+ *          FILE_SOURCE_MEMORY_CHUNK bytes comes in chunks no bigger than that.
+ */
+TEST(test_source_memory)
+{
+    static const char text[] = "1'P'1\n2'N\n";
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_SOURCE_ARENA_SIZE);
+    ASSERT(arena != NULL);
+
+    file_source_t* source = file_source_memory(arena, text, sizeof(text) - 1);
+    ASSERT(source != NULL);
+    uint16_t nbytes;
+    EXPECT(file_source_next(source, &nbytes) == text && nbytes == sizeof(text) - 1);
+    EXPECT(file_source_next(source, &nbytes) == NULL && nbytes == 0);
+    EXPECT(file_source_next(source, &nbytes) == NULL);
+    EXPECT(file_source_error(source) == DOS_SUCCESS);
+    file_source_close(source);
+
+    source = file_source_memory(arena, text, 0);
+    ASSERT(source != NULL);
+    EXPECT(file_source_next(source, &nbytes) == NULL && nbytes == 0);
+
+#ifndef __DOS__
+    static char large[FILE_SOURCE_MEMORY_CHUNK + 100];
+    static char joined[FILE_SOURCE_MEMORY_CHUNK + 100];
+    memset(large, 'm', sizeof(large));
+    source = file_source_memory(arena, large, sizeof(large));
+    ASSERT(source != NULL);
+    EXPECT(test_source_drain(source, joined, sizeof(joined), FILE_SOURCE_MEMORY_CHUNK) == sizeof(large));
+    EXPECT(memcmp(joined, large, sizeof(large)) == 0);
+#endif
+
+    mem_arena_delete(arena);
+}
+
+/**
+ * @brief A replay source delivers one script line per call, like a console
+ * @details Each chunk is one line with its ending, the last one without, and
+ *          file_source_replayed() counts them. A missing script does not open.
+ */
+TEST(test_source_replay)
+{
+    static const char* lines[] = { "3\r\n", "\n", "4\n", "last" };
+    ASSERT(test_source_write("3\r\n\n4\nlast"));
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_SOURCE_ARENA_SIZE);
+    ASSERT(arena != NULL);
+
+    file_source_t* source = file_source_replay(arena, TEST_SOURCE_FILE);
+    ASSERT(source != NULL);
+    uint8_t i;
+    for (i = 0; i < sizeof(lines) / sizeof(lines[0]); ++i) {
+        uint16_t nbytes;
+        const char* chunk = file_source_next(source, &nbytes);
+        ASSERT(chunk != NULL);
+        EXPECT(nbytes == strlen(lines[i]) && memcmp(chunk, lines[i], nbytes) == 0);
+        EXPECT(file_source_replayed(source) == (uint32_t)i + 1);
+    }
+    uint16_t nbytes;
+    EXPECT(file_source_next(source, &nbytes) == NULL);
+    EXPECT(file_source_replayed(source) == sizeof(lines) / sizeof(lines[0]));
+    file_source_close(source);
+
+    dos_delete_file(TEST_SOURCE_FILE);
+    dos_last_error_clear();
+    EXPECT(file_source_replay(arena, TEST_SOURCE_FILE) == NULL);
+    EXPECT(dos_last_error_code() == DOS_FILE_NOT_FOUND);
+
+    mem_arena_delete(arena);
+}
+
+/**
+ * @brief The DOS handle source hands out prefetch buffers
+ * @details Buffers of 1, 5 and 512 bytes join up to the file. A missing file does
+ *          not open. A read error sticks: the source keeps returning NULL with it
+ *          (hosts that can open a directory fail to read it; DOS refuses to open it).
+ */
+TEST(test_source_dos)
+{
+    static const uint16_t buffer_sizes[] = { 1, 5, 512 };
+    static const char text[] = "10'J'A\r\n20'P'A\r\n";
+    char joined[sizeof(text)];
+    ASSERT(test_source_write(text));
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_SOURCE_ARENA_SIZE);
+    ASSERT(arena != NULL);
+
+    uint8_t b;
+    for (b = 0; b < sizeof(buffer_sizes) / sizeof(buffer_sizes[0]); ++b) {
+        mem_size_t used = mem_arena_used(arena);
+        file_source_t* source = file_source_dos(arena, TEST_SOURCE_FILE, buffer_sizes[b]);
+        ASSERT(source != NULL);
+        EXPECT(test_source_drain(source, joined, sizeof(joined), buffer_sizes[b]) == sizeof(text) - 1);
+        EXPECT(memcmp(joined, text, sizeof(text) - 1) == 0);
+        EXPECT(file_source_error(source) == DOS_SUCCESS);
+        file_source_close(source);
+        mem_arena_dealloc(arena, mem_arena_used(arena) - used);
+    }
+
+    dos_delete_file(TEST_SOURCE_FILE);
+    dos_last_error_clear();
+    EXPECT(file_source_dos(arena, TEST_SOURCE_FILE, 64) == NULL);
+    EXPECT(dos_last_error_code() == DOS_FILE_NOT_FOUND);
+
+    dos_last_error_clear();
+    file_source_t* source = file_source_dos(arena, ".", 64);
+    if (source) {
+        uint16_t nbytes;
+        EXPECT(file_source_next(source, &nbytes) == NULL);
+        EXPECT(file_source_error(source) != DOS_SUCCESS);
+        EXPECT(file_source_next(source, &nbytes) == NULL && nbytes == 0);
+        file_source_close(source);
+    } else {
+        EXPECT(dos_last_error_code() != DOS_SUCCESS);
+    }
+
+    mem_arena_delete(arena);
+}
+
+/**
+ * @brief The host fd source reads a descriptor in buffer_size reads
+ * @details A file that is not a terminal reads whole, a Ctrl-Z in it included,
+ *          and the descriptor stays open after file_source_close(). DOS builds
+ *          have no fd source.
+ */
+TEST(test_source_fd)
+{
+#ifndef __DOS__
+    static const char text[] = "typed\r\n\x1A" "after\n";
+    char joined[sizeof(text)];
+    ASSERT(test_source_write(text));
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, TEST_SOURCE_ARENA_SIZE);
+    ASSERT(arena != NULL);
+    int fd = open(TEST_SOURCE_FILE, O_RDONLY);
+    ASSERT(fd >= 0);
+
+    file_source_t* source = file_source_fd(arena, fd, 4);
+    ASSERT(source != NULL);
+    EXPECT(test_source_drain(source, joined, sizeof(joined), 4) == sizeof(text) - 1);
+    EXPECT(memcmp(joined, text, sizeof(text) - 1) == 0);
+    EXPECT(file_source_error(source) == DOS_SUCCESS);
+    file_source_close(source);
+    EXPECT(lseek(fd, 0, SEEK_SET) == 0);
+
+    close(fd);
+    dos_delete_file(TEST_SOURCE_FILE);
+    mem_arena_delete(arena);
+#endif
+}
+
+#endif
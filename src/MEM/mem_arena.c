@@ -75,14 +75,15 @@ mem_arena_t* private_mem_arena_dos_new(mem_size_t byte_count) {
     assert(arena != NULL);
     *arena = default_dos_mem_arena_t;
     mem_size_t paragraphs = (byte_count / MEM_SIZE_PARAGRAPH) + ((byte_count % MEM_SIZE_PARAGRAPH) ? 1 : 0);
-    arena->start.segoff.segment = dos_allocate_memory_blocks(paragraphs);
-    if (arena->start.segoff.segment) {
+    uint16_t segment = dos_allocate_memory_blocks(paragraphs);
+    if (segment) {
+        arena->start.ptr = mem_segment_to_pointer(segment);
         arena->free = arena->start.ptr;
         arena->end = arena->start.ptr + (paragraphs * MEM_SIZE_PARAGRAPH);
     }
 #ifndef NDEBUG
     else {
-        fprintf(stderr, "DOS allocation failed: Requested %lu bytes (%u paragraphs)\n", byte_count, paragraphs);
+        fprintf(stderr, "DOS allocation failed: Requested %lu bytes (%lu paragraphs)\n", (unsigned long)byte_count, (unsigned long)paragraphs);
     }
 #endif
     return arena;
@@ -100,7 +101,7 @@ mem_arena_t* private_mem_arena_dos_new(mem_size_t byte_count) {
 mem_size_t private_mem_arena_dos_delete(mem_arena_t* arena) {
 	assert(arena);
     mem_size_t freed = mem_arena_capacity(arena);
-    dos_free_allocated_memory_blocks(arena->start.segoff.segment);
+    dos_free_allocated_memory_blocks(mem_pointer_to_segment(arena->start.ptr));
     free(arena);
     return freed;
 }
@@ -188,9 +189,7 @@ char* mem_arena_dos_mcb(mem_arena_t* arena) {
 	if(!arena || arena->policy != MEM_ARENA_POLICY_DOS) {
 	    return NULL;
 	}
-	mem_address_t m = arena->start;
-	--m.segoff.segment;
-	return m.ptr;
+	return mem_segment_to_pointer(mem_pointer_to_segment(arena->start.ptr) - 1);
 }
 
 mem_size_t mem_arena_size(mem_arena_t* arena) {
@@ -227,11 +226,27 @@ void* mem_arena_alloc(mem_arena_t* arena, mem_size_t byte_request) {
     }
 #ifndef NDEBUG
     fprintf(stderr, "Allocation failed: Requested %lu, Available %lu\n",
-           byte_request, mem_arena_size(arena));
+           (unsigned long)byte_request, arena ? (unsigned long)mem_arena_size(arena) : 0UL);
 #endif
     return NULL;
 }
 
+void* mem_arena_alloc_aligned(mem_arena_t* arena, mem_size_t byte_request, mem_size_t alignment) {
+    assert(alignment && !(alignment & (alignment - 1)));
+    if (!arena) {
+        return NULL;
+    }
+    mem_size_t padding = (mem_size_t)(-(uintptr_t)arena->free) & (alignment - 1);
+    if (padding && !mem_arena_alloc(arena, padding)) {
+        return NULL;
+    }
+    void* ptr = mem_arena_alloc(arena, byte_request);
+    if (!ptr && padding) {
+        arena->free -= padding;     // give the padding back
+    }
+    return ptr;
+}
+
 void* mem_arena_calloc(mem_arena_t* arena, mem_size_t byte_request) {
     void* ptr = mem_arena_alloc(arena, byte_request);
     if (ptr) {
@@ -250,7 +265,7 @@ void* mem_arena_dealloc(mem_arena_t* arena, mem_size_t byte_request) {
         return arena->free;
     }
 #ifndef NDEBUG
-    fprintf(stderr, "Deallocation failed: Requested %lu, Used %lu\n", byte_request, mem_arena_used(arena));
+    fprintf(stderr, "Deallocation failed: Requested %lu, Used %lu\n", (unsigned long)byte_request, arena ? (unsigned long)mem_arena_used(arena) : 0UL);
 #endif
     return NULL;
 }
@@ -271,9 +286,9 @@ void mem_arena_dump(FILE* output_stream, mem_arena_t* arena) {
            mem_policy_info[arena->policy],
            arena->start.ptr,
            arena->end,
-           mem_arena_capacity(arena),
-           mem_arena_used(arena),
-           mem_arena_size(arena));
+           (unsigned long)mem_arena_capacity(arena),
+           (unsigned long)mem_arena_used(arena),
+           (unsigned long)mem_arena_size(arena));
 
     if (arena->policy == MEM_ARENA_POLICY_DOS) {
         fprintf(output_stream, "MCB: %p\n", mem_arena_dos_mcb(arena));
@@ -152,6 +152,19 @@ void* mem_arena_free_address(mem_arena_t* arena);
  */
 void* mem_arena_alloc(mem_arena_t* arena, mem_size_t byte_request);
 
+/**
+ * @brief Allocates memory from arena on an alignment boundary
+ * @param arena Valid arena handle
+ * @param byte_request Size needed
+ * @param alignment Power of two boundary (e.g. sizeof(double))
+ * @return Aligned pointer to memory or NULL if full
+ *
+ * @details Skips up to alignment - 1 bytes of padding before the block, which is
+ *          required for anything the CPU or OS insists on aligning (doubles on the
+ *          host, pthread objects)
+ */
+void* mem_arena_alloc_aligned(mem_arena_t* arena, mem_size_t byte_request, mem_size_t alignment);
+
 /**
  * @brief Allocates and zero-initializes memory from arena
  * @param arena Valid arena handle
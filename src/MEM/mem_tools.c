@@ -5,8 +5,13 @@
 #include <assert.h>
 #include <string.h>
 
+#include "../DOS/dos_error_messages.h"
 #include "../DOS/dos_services_files.h"
+#ifndef __DOS__
+#include "../DOS/dos_services_host.h"
+#endif
 
+#ifdef __DOS__
 uint16_t mem_max_paragraphs() {
     uint16_t paragraphs, err_code;
     paragraphs = err_code = 0;
@@ -24,6 +29,32 @@ uint16_t mem_max_paragraphs() {
     return paragraphs;
 }
 
+char* mem_segment_to_pointer(uint16_t segment) {
+    mem_address_t address;
+    address.segoff.offset = 0;
+    address.segoff.segment = segment;
+    return address.ptr;
+}
+
+uint16_t mem_pointer_to_segment(const void* ptr) {
+    mem_address_t address;
+    address.ptr = (char*)ptr;
+    return address.segoff.segment;
+}
+#else
+uint16_t mem_max_paragraphs() {
+    return dos_host_largest_free_block();
+}
+
+char* mem_segment_to_pointer(uint16_t segment) {
+    return dos_host_segment_to_pointer(segment);
+}
+
+uint16_t mem_pointer_to_segment(const void* ptr) {
+    return dos_host_pointer_to_segment(ptr);
+}
+#endif
+
 mem_diff_t mem_diff_pointers(const void* p1, const void* p2) {
     const uintptr_t addr1 = (uintptr_t)p1;  // uintptr_t is more portable than uint32_t
     const uintptr_t addr2 = (uintptr_t)p2;
@@ -73,7 +104,10 @@ dos_file_size_t mem_save_to_file(const char* path_name, char* start, uint16_t nb
     dos_file_size_t bytes_saved = 0;
     dos_file_handle_t fhandle = dos_open_file(path_name, ACCESS_WRITE_ONLY);
     if (fhandle) {
-        bytes_saved = dos_write_file(fhandle, start, nbytes);
+        // final size known up front so grow the FAT chain once; no room means nothing is written
+        if (dos_file_preallocate(fhandle, nbytes) == DOS_SUCCESS) {
+            bytes_saved = dos_write_file(fhandle, start, nbytes);
+        }
         dos_close_file(fhandle);
     }
     return bytes_saved;
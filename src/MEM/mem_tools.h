@@ -30,6 +30,24 @@
  */
 uint16_t mem_max_paragraphs();
 
+/**
+ * @brief Converts a paragraph segment to a pointer to segment:0000
+ * @param segment Segment, e.g. as returned by dos_allocate_memory_blocks()
+ * @return Far pointer (DOS) or host address inside simulated memory (host builds)
+ *
+ * @see mem_pointer_to_segment()
+ */
+char* mem_segment_to_pointer(uint16_t segment);
+
+/**
+ * @brief Extracts the segment of a paragraph aligned pointer
+ * @param ptr Pointer with a zero offset, e.g. an arena base address
+ * @return Segment (0 on host builds if ptr is not in simulated memory)
+ *
+ * @see mem_segment_to_pointer()
+ */
+uint16_t mem_pointer_to_segment(const void* ptr);
+
 /**
  * @brief Calculates the byte difference between two memory addresses
  * @ingroup memory_management
@@ -111,12 +129,14 @@ dos_file_size_t mem_load_from_file(const char* path_name, char* start, uint16_t
  * @param[in] path_name Destination file (must be non-empty)
  * @param[in] start Source memory address
  * @param[in] nbytes Bytes to save (≤64KB, must be >0)
- * @return Actual bytes saved (dos_file_size_t)
+ * @return Actual bytes saved (dos_file_size_t), 0 if the file cannot be opened or
+ *         preallocated (see dos_last_error())
  *
  * @details Features:
  *          - Handles up to one 64K page
  *          - Writes unmodified memory contents
  *          - Creates/overwrites files
+ *          - Preallocates nbytes first so the FAT chain is grown once (dos_file_preallocate)
  *
  * @pre path_name != NULL && strlen(path_name) > 0 (asserted)
  * @pre start != NULL (asserted)
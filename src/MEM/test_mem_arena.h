@@ -18,6 +18,7 @@
                     &test_basic_allocation, \
                     &test_allocation_limits, \
                     &test_deallocation, \
+                    &test_aligned_allocation, \
                     &test_zero_allocation, \
                     &test_null_arena_handling, \
                     &test_arena_dump
@@ -112,6 +113,35 @@ TEST(test_deallocation) {
     teardown();
 }
 
+TEST(test_aligned_allocation) {
+    setup();
+
+    // Odd sized block leaves the free pointer misaligned
+    char* block = (char*)mem_arena_alloc(test_arena, 3);
+    ASSERT(block != NULL);
+
+    // Padding is skipped, never more than alignment - 1 bytes
+    char* aligned = (char*)mem_arena_alloc_aligned(test_arena, 16, 8);
+    ASSERT(aligned != NULL);
+    ASSERT(((uintptr_t)aligned & 7) == 0);
+    ASSERT(aligned >= block + 3 && aligned < block + 3 + 8);
+    ASSERT(mem_arena_free_address(test_arena) == aligned + 16);
+
+    // Already aligned: no padding at all
+    mem_size_t used = mem_arena_used(test_arena);
+    char* next = (char*)mem_arena_alloc_aligned(test_arena, 8, 8);
+    ASSERT(next == aligned + 16);
+    ASSERT(mem_arena_used(test_arena) == used + 8);
+
+    // A request that does not fit gives its padding back
+    mem_arena_alloc(test_arena, 1);
+    used = mem_arena_used(test_arena);
+    ASSERT(mem_arena_alloc_aligned(test_arena, mem_arena_size(test_arena), 8) == NULL);
+    ASSERT(mem_arena_used(test_arena) == used);
+
+    teardown();
+}
+
 /* ----------------- Edge Case Tests ----------------- */
 
 
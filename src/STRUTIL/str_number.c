@@ -0,0 +1,558 @@
+#include "str_number.h"
+#include "../CONTRACT/contract.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// every power of ten up to 1e22 is exactly representable
+static const double str_number_pow10[STR_NUMBER_MAX_POW10 + 1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define STR_NUMBER_IS_DIGIT(c) ((unsigned)((c) - '0') < 10U)
+
+/**
+ * @brief Decimal mantissa: 9 digits in 32 bits so 16-bit targets rarely touch 64-bit math
+ */
+typedef struct {
+    uint32_t low;           ///< First 9 significant digits
+    uint64_t wide;          ///< All significant digits once there are more than 9
+    uint8_t digits;         ///< Significant digits taken, leading zeros excluded
+    uint8_t dropped;        ///< Digits beyond STR_NUMBER_EXACT_DIGITS were seen
+} str_number_mantissa_t;
+
+static void str_number_digit(str_number_mantissa_t* m, uint8_t d) {
+    if (m->digits < 9) {
+        m->low = m->low * 10 + d;
+    } else if (m->digits < STR_NUMBER_EXACT_DIGITS) {
+        if (m->digits == 9) {
+            m->wide = m->low;
+        }
+        m->wide = m->wide * 10 + d;
+    } else {
+        m->dropped = 1;
+        return;
+    }
+    if (m->digits || d) {
+        ++m->digits;
+    }
+}
+
+/**
+ * @brief Correctly rounded fallback for long or far out literals
+ */
+static double str_number_slow(const char* text, size_t length) {
+    char copy[STR_NUMBER_MAX_TEXT + 1];
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return strtod(copy, NULL);
+}
+
+size_t str_number_parse(const char* text, size_t length, double* value) {
+    require_address(text, "NULL number text!");
+    require_address(value, "NULL number value!");
+
+    str_number_mantissa_t m = {0};
+    int exponent = 0;           // power of ten applied to the mantissa
+    size_t i = 0;
+    uint8_t negative = 0;
+    size_t digits = 0;
+
+    if (i < length && (text[i] == '+' || text[i] == '-')) {
+        negative = text[i++] == '-';
+    }
+    while (i < length && STR_NUMBER_IS_DIGIT(text[i])) {
+        uint8_t before = m.digits;
+        str_number_digit(&m, (uint8_t)(text[i++] - '0'));
+        if (m.dropped && before == m.digits) {
+            ++exponent;         // integer digit we could not keep still scales the value
+        }
+        ++digits;
+    }
+    uint8_t integer = 1;
+    if (i < length && text[i] == '.') {
+        integer = 0;
+        ++i;
+        while (i < length && STR_NUMBER_IS_DIGIT(text[i])) {
+            uint8_t before = m.digits;
+            str_number_digit(&m, (uint8_t)(text[i++] - '0'));
+            if (!(m.dropped && before == m.digits)) {
+                --exponent;
+            }
+            ++digits;
+        }
+    }
+    if (!digits) {
+        return 0;               // "", "+", ".", "-."
+    }
+    if (i < length && (text[i] == 'e' || text[i] == 'E')) {
+        size_t j = i + 1;
+        uint8_t exponent_negative = 0;
+        if (j < length && (text[j] == '+' || text[j] == '-')) {
+            exponent_negative = text[j++] == '-';
+        }
+        if (j < length && STR_NUMBER_IS_DIGIT(text[j])) {   // otherwise the 'e' is not ours
+            int written = 0;
+            while (j < length && STR_NUMBER_IS_DIGIT(text[j])) {
+                if (written < 10000) {
+                    written = written * 10 + (text[j] - '0');
+                }
+                ++j;
+            }
+            exponent += exponent_negative ? -written : written;
+            integer = 0;
+            i = j;
+        }
+    }
+
+    double result;
+    if (integer && m.digits <= 9 && !m.dropped) {
+        result = (double)m.low;
+    } else if (!m.dropped && exponent >= -STR_NUMBER_MAX_POW10 && exponent <= STR_NUMBER_MAX_POW10) {
+        // Clinger: mantissa and power are both exact, so one IEEE operation rounds correctly
+        double mantissa = m.digits <= 9 ? (double)m.low : (double)m.wide;
+        result = exponent < 0 ? mantissa / str_number_pow10[-exponent] : mantissa * str_number_pow10[exponent];
+    } else if (!m.digits) {
+        result = 0.0;           // zero with any exponent
+    } else if (i <= STR_NUMBER_MAX_TEXT) {
+        *value = str_number_slow(text, i);
+        return i;
+    } else {
+        return 0;               // longer than any line, not a DOPE literal
+    }
+    *value = negative ? -result : result;
+    return i;
+}
+
+/* ----------------- Formatting ----------------- */
+
+#define STR_NUMBER_HIDDEN_BIT           0x0010000000000000ULL
+#define STR_NUMBER_SIGNIFICAND_MASK     0x000FFFFFFFFFFFFFULL
+#define STR_NUMBER_EXPONENT_BIAS        1075
+#define STR_NUMBER_DENORMAL_EXPONENT    (-1074)
+#define STR_NUMBER_EXACT_INTEGER        9007199254740992.0      // 2^53
+#define STR_NUMBER_MIN_TARGET_EXPONENT  (-60)
+#define STR_NUMBER_MAX_TARGET_EXPONENT  (-32)
+#define STR_NUMBER_POWERS_OFFSET        348
+#define STR_NUMBER_POWERS_DISTANCE      8
+#define STR_NUMBER_D_1_LOG2_10          0.30102999566398114     // 1 / log2(10)
+#define STR_NUMBER_FIXED_MAX_EXPONENT   16                      // "%.16g" switches to e-notation here
+
+/**
+ * @brief Do-it-yourself floating point: f * 2^e with a full 64-bit significand
+ */
+typedef struct {
+    uint64_t f;
+    int e;
+} str_number_diyfp_t;
+
+typedef struct {
+    uint64_t significand;
+    int16_t binary_exponent;
+    int16_t decimal_exponent;
+} str_number_cached_power_t;
+
+// 10^k for k = -348, -340, ..., 340, normalized and rounded to 64 bits
+static const str_number_cached_power_t str_number_cached_powers[] = {
+    { 0xFA8FD5A0081C0288ULL, -1220, -348 },
+    { 0xBAAEE17FA23EBF76ULL, -1193, -340 },
+    { 0x8B16FB203055AC76ULL, -1166, -332 },
+    { 0xCF42894A5DCE35EAULL, -1140, -324 },
+    { 0x9A6BB0AA55653B2DULL, -1113, -316 },
+    { 0xE61ACF033D1A45DFULL, -1087, -308 },
+    { 0xAB70FE17C79AC6CAULL, -1060, -300 },
+    { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+    { 0xBE5691EF416BD60CULL, -1007, -284 },
+    { 0x8DD01FAD907FFC3CULL,  -980, -276 },
+    { 0xD3515C2831559A83ULL,  -954, -268 },
+    { 0x9D71AC8FADA6C9B5ULL,  -927, -260 },
+    { 0xEA9C227723EE8BCBULL,  -901, -252 },
+    { 0xAECC49914078536DULL,  -874, -244 },
+    { 0x823C12795DB6CE57ULL,  -847, -236 },
+    { 0xC21094364DFB5637ULL,  -821, -228 },
+    { 0x9096EA6F3848984FULL,  -794, -220 },
+    { 0xD77485CB25823AC7ULL,  -768, -212 },
+    { 0xA086CFCD97BF97F4ULL,  -741, -204 },
+    { 0xEF340A98172AACE5ULL,  -715, -196 },
+    { 0xB23867FB2A35B28EULL,  -688, -188 },
+    { 0x84C8D4DFD2C63F3BULL,  -661, -180 },
+    { 0xC5DD44271AD3CDBAULL,  -635, -172 },
+    { 0x936B9FCEBB25C996ULL,  -608, -164 },
+    { 0xDBAC6C247D62A584ULL,  -582, -156 },
+    { 0xA3AB66580D5FDAF6ULL,  -555, -148 },
+    { 0xF3E2F893DEC3F126ULL,  -529, -140 },
+    { 0xB5B5ADA8AAFF80B8ULL,  -502, -132 },
+    { 0x87625F056C7C4A8BULL,  -475, -124 },
+    { 0xC9BCFF6034C13053ULL,  -449, -116 },
+    { 0x964E858C91BA2655ULL,  -422, -108 },
+    { 0xDFF9772470297EBDULL,  -396, -100 },
+    { 0xA6DFBD9FB8E5B88FULL,  -369,  -92 },
+    { 0xF8A95FCF88747D94ULL,  -343,  -84 },
+    { 0xB94470938FA89BCFULL,  -316,  -76 },
+    { 0x8A08F0F8BF0F156BULL,  -289,  -68 },
+    { 0xCDB02555653131B6ULL,  -263,  -60 },
+    { 0x993FE2C6D07B7FACULL,  -236,  -52 },
+    { 0xE45C10C42A2B3B06ULL,  -210,  -44 },
+    { 0xAA242499697392D3ULL,  -183,  -36 },
+    { 0xFD87B5F28300CA0EULL,  -157,  -28 },
+    { 0xBCE5086492111AEBULL,  -130,  -20 },
+    { 0x8CBCCC096F5088CCULL,  -103,  -12 },
+    { 0xD1B71758E219652CULL,   -77,   -4 },
+    { 0x9C40000000000000ULL,   -50,    4 },
+    { 0xE8D4A51000000000ULL,   -24,   12 },
+    { 0xAD78EBC5AC620000ULL,     3,   20 },
+    { 0x813F3978F8940984ULL,    30,   28 },
+    { 0xC097CE7BC90715B3ULL,    56,   36 },
+    { 0x8F7E32CE7BEA5C70ULL,    83,   44 },
+    { 0xD5D238A4ABE98068ULL,   109,   52 },
+    { 0x9F4F2726179A2245ULL,   136,   60 },
+    { 0xED63A231D4C4FB27ULL,   162,   68 },
+    { 0xB0DE65388CC8ADA8ULL,   189,   76 },
+    { 0x83C7088E1AAB65DBULL,   216,   84 },
+    { 0xC45D1DF942711D9AULL,   242,   92 },
+    { 0x924D692CA61BE758ULL,   269,  100 },
+    { 0xDA01EE641A708DEAULL,   295,  108 },
+    { 0xA26DA3999AEF774AULL,   322,  116 },
+    { 0xF209787BB47D6B85ULL,   348,  124 },
+    { 0xB454E4A179DD1877ULL,   375,  132 },
+    { 0x865B86925B9BC5C2ULL,   402,  140 },
+    { 0xC83553C5C8965D3DULL,   428,  148 },
+    { 0x952AB45CFA97A0B3ULL,   455,  156 },
+    { 0xDE469FBD99A05FE3ULL,   481,  164 },
+    { 0xA59BC234DB398C25ULL,   508,  172 },
+    { 0xF6C69A72A3989F5CULL,   534,  180 },
+    { 0xB7DCBF5354E9BECEULL,   561,  188 },
+    { 0x88FCF317F22241E2ULL,   588,  196 },
+    { 0xCC20CE9BD35C78A5ULL,   614,  204 },
+    { 0x98165AF37B2153DFULL,   641,  212 },
+    { 0xE2A0B5DC971F303AULL,   667,  220 },
+    { 0xA8D9D1535CE3B396ULL,   694,  228 },
+    { 0xFB9B7CD9A4A7443CULL,   720,  236 },
+    { 0xBB764C4CA7A44410ULL,   747,  244 },
+    { 0x8BAB8EEFB6409C1AULL,   774,  252 },
+    { 0xD01FEF10A657842CULL,   800,  260 },
+    { 0x9B10A4E5E9913129ULL,   827,  268 },
+    { 0xE7109BFBA19C0C9DULL,   853,  276 },
+    { 0xAC2820D9623BF429ULL,   880,  284 },
+    { 0x80444B5E7AA7CF85ULL,   907,  292 },
+    { 0xBF21E44003ACDD2DULL,   933,  300 },
+    { 0x8E679C2F5E44FF8FULL,   960,  308 },
+    { 0xD433179D9C8CB841ULL,   986,  316 },
+    { 0x9E19DB92B4E31BA9ULL,  1013,  324 },
+    { 0xEB96BF6EBADF77D9ULL,  1039,  332 },
+    { 0xAF87023B9BF0EE6BULL,  1066,  340 }
+};
+
+static str_number_diyfp_t str_number_diyfp_multiply(str_number_diyfp_t x, str_number_diyfp_t y) {
+    const uint64_t mask32 = 0xFFFFFFFFULL;
+    uint64_t a = x.f >> 32, b = x.f & mask32;
+    uint64_t c = y.f >> 32, d = y.f & mask32;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t middle = (bd >> 32) + (ad & mask32) + (bc & mask32) + (1ULL << 31);  // round the dropped half
+    str_number_diyfp_t product = { ac + (ad >> 32) + (bc >> 32) + (middle >> 32), x.e + y.e + 64 };
+    return product;
+}
+
+static str_number_diyfp_t str_number_diyfp_normalize(str_number_diyfp_t x) {
+    while (!(x.f & 0xFFC0000000000000ULL)) {
+        x.f <<= 10;
+        x.e -= 10;
+    }
+    while (!(x.f & 0x8000000000000000ULL)) {
+        x.f <<= 1;
+        x.e -= 1;
+    }
+    return x;
+}
+
+/**
+ * @brief Cached 10^-k that scales a binary exponent into [min_exponent, min_exponent + 28]
+ */
+static str_number_diyfp_t str_number_cached_power(int min_exponent, int* decimal_exponent) {
+    double estimate = (min_exponent + 63) * STR_NUMBER_D_1_LOG2_10;
+    int k = (int)estimate;
+    if (estimate > k) {
+        ++k;                                            // ceil
+    }
+    int index = (STR_NUMBER_POWERS_OFFSET + k - 1) / STR_NUMBER_POWERS_DISTANCE + 1;
+    const str_number_cached_power_t* cached = &str_number_cached_powers[index];
+    str_number_diyfp_t power = { cached->significand, cached->binary_exponent };
+    *decimal_exponent = cached->decimal_exponent;
+    return power;
+}
+
+/**
+ * @brief Moves the last digit towards w while that stays inside the safe interval,
+ *        then reports whether the result is provably the closest shortest one
+ */
+static int str_number_round_weed(char* digits, int length, uint64_t distance_too_high_w, uint64_t unsafe_interval,
+                                 uint64_t rest, uint64_t ten_kappa, uint64_t unit) {
+    uint64_t small_distance = distance_too_high_w - unit;
+    uint64_t big_distance = distance_too_high_w + unit;
+    while (rest < small_distance && unsafe_interval - rest >= ten_kappa
+           && (rest + ten_kappa < small_distance || small_distance - rest >= rest + ten_kappa - small_distance)) {
+        digits[length - 1]--;
+        rest += ten_kappa;
+    }
+    if (rest < big_distance && unsafe_interval - rest >= ten_kappa
+        && (rest + ten_kappa < big_distance || big_distance - rest > rest + ten_kappa - big_distance)) {
+        return 0;
+    }
+    return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+}
+
+/**
+ * @brief Grisu3 digit generation, 0 when the result cannot be proven shortest and closest
+ */
+static int str_number_grisu3_digits(str_number_diyfp_t low, str_number_diyfp_t w, str_number_diyfp_t high,
+                                    char* digits, int* length, int* kappa) {
+    uint64_t unit = 1;
+    str_number_diyfp_t too_low = { low.f - unit, low.e };
+    str_number_diyfp_t too_high = { high.f + unit, high.e };
+    uint64_t unsafe_interval = too_high.f - too_low.f;
+    int shift = -w.e;
+    uint64_t one = 1ULL << shift;
+    uint32_t integrals = (uint32_t)(too_high.f >> shift);
+    uint64_t fractionals = too_high.f & (one - 1);
+
+    uint32_t divisor = 0;
+    *kappa = 0;
+    if (integrals) {
+        divisor = 1;
+        *kappa = 1;
+        while (integrals / divisor >= 10) {
+            divisor *= 10;
+            ++*kappa;
+        }
+    }
+    *length = 0;
+    while (*kappa > 0) {
+        digits[(*length)++] = (char)('0' + integrals / divisor);
+        integrals %= divisor;
+        --*kappa;
+        uint64_t rest = ((uint64_t)integrals << shift) + fractionals;
+        if (rest < unsafe_interval) {
+            return str_number_round_weed(digits, *length, too_high.f - w.f, unsafe_interval, rest,
+                                         (uint64_t)divisor << shift, unit);
+        }
+        divisor /= 10;
+    }
+    for (;;) {
+        fractionals *= 10;
+        unit *= 10;
+        unsafe_interval *= 10;
+        digits[(*length)++] = (char)('0' + (fractionals >> shift));
+        fractionals &= one - 1;
+        --*kappa;
+        if (*length > STR_NUMBER_MAX_DIGITS) {
+            return 0;
+        }
+        if (fractionals < unsafe_interval) {
+            return str_number_round_weed(digits, *length, (too_high.f - w.f) * unit, unsafe_interval, fractionals, one, unit);
+        }
+    }
+}
+
+/**
+ * @brief Shortest digits of a positive finite double via Grisu3
+ * @return Digit count, 0 if the fallback must decide
+ */
+static int str_number_grisu3(double value, char* digits, int* exponent) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int biased = (int)((bits >> 52) & 0x7FF);
+    uint64_t significand = bits & STR_NUMBER_SIGNIFICAND_MASK;
+    if (!significand && biased > 1) {
+        return 0;                                       // lower neighbour closer: asymmetric interval
+    }
+    str_number_diyfp_t v = biased ? (str_number_diyfp_t){ significand | STR_NUMBER_HIDDEN_BIT, biased - STR_NUMBER_EXPONENT_BIAS }
+                                  : (str_number_diyfp_t){ significand, STR_NUMBER_DENORMAL_EXPONENT };
+
+    str_number_diyfp_t plus = str_number_diyfp_normalize((str_number_diyfp_t){ (v.f << 1) + 1, v.e - 1 });
+    str_number_diyfp_t minus = { (v.f << 1) - 1, v.e - 1 };
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+    str_number_diyfp_t w = str_number_diyfp_normalize(v);
+
+    int mk;
+    str_number_diyfp_t ten_mk = str_number_cached_power(STR_NUMBER_MIN_TARGET_EXPONENT - (w.e + 64), &mk);
+    int kappa;
+    int length;
+    if (!str_number_grisu3_digits(str_number_diyfp_multiply(minus, ten_mk), str_number_diyfp_multiply(w, ten_mk),
+                                  str_number_diyfp_multiply(plus, ten_mk), digits, &length, &kappa)) {
+        return 0;
+    }
+    *exponent = kappa - mk;                             // value = digits * 10^exponent
+    return length;
+}
+
+/**
+ * @brief Reference digits: the smallest "%.*e" precision that reads back exactly
+ */
+static int str_number_shortest_printf(double value, char* digits, int* exponent) {
+    char text[STR_NUMBER_FORMAT_SIZE];
+    int precision;
+    for (precision = 1; precision < STR_NUMBER_MAX_DIGITS; ++precision) {
+        sprintf(text, "%.*e", precision - 1, value);
+        if (strtod(text, NULL) == value) {
+            break;
+        }
+    }
+    sprintf(text, "%.*e", precision - 1, value);
+    int length = 0;
+    const char* c;
+    for (c = text; *c != 'e'; ++c) {
+        if (*c != '.') {
+            digits[length++] = *c;
+        }
+    }
+    *exponent = atoi(c + 1) - (length - 1);
+    return length;
+}
+
+/**
+ * @brief Lays digits * 10^exponent out as "%g" does, with the fixed range of "%.16g"
+ */
+static size_t str_number_layout(char* buffer, int negative, const char* digits, int length, int exponent) {
+    while (length > 1 && digits[length - 1] == '0') {
+        --length;                                       // trailing zeros only shift the exponent
+        ++exponent;
+    }
+    char* out = buffer;
+    if (negative) {
+        *out++ = '-';
+    }
+    int point = length + exponent;                      // digits before the decimal point
+    int leading = point - 1;                            // exponent of the first digit
+    int i;
+    if (leading < -4 || leading >= STR_NUMBER_FIXED_MAX_EXPONENT) {
+        *out++ = digits[0];
+        if (length > 1) {
+            *out++ = '.';
+            memcpy(out, digits + 1, (size_t)(length - 1));
+            out += length - 1;
+        }
+        *out++ = 'e';
+        *out++ = leading < 0 ? '-' : '+';
+        int magnitude = leading < 0 ? -leading : leading;
+        if (magnitude >= 100) {
+            *out++ = (char)('0' + magnitude / 100);
+        }
+        *out++ = (char)('0' + magnitude / 10 % 10);
+        *out++ = (char)('0' + magnitude % 10);
+    } else if (point <= 0) {
+        *out++ = '0';
+        *out++ = '.';
+        for (i = point; i < 0; ++i) {
+            *out++ = '0';
+        }
+        memcpy(out, digits, (size_t)length);
+        out += length;
+    } else if (point >= length) {
+        memcpy(out, digits, (size_t)length);
+        out += length;
+        for (i = length; i < point; ++i) {
+            *out++ = '0';
+        }
+    } else {
+        memcpy(out, digits, (size_t)point);
+        out += point;
+        *out++ = '.';
+        memcpy(out, digits + point, (size_t)(length - point));
+        out += length - point;
+    }
+    *out = '\0';
+    return (size_t)(out - buffer);
+}
+
+/**
+ * @brief Writes an unsigned integer, 32-bit divides while it fits
+ * @return Digit count
+ */
+static int str_number_integer_digits(uint64_t integer, char* digits) {
+    char reversed[20];
+    int length = 0;
+    while (integer > 0xFFFFFFFFULL) {
+        reversed[length++] = (char)('0' + integer % 10);
+        integer /= 10;
+    }
+    uint32_t small = (uint32_t)integer;
+    do {
+        reversed[length++] = (char)('0' + small % 10);
+        small /= 10;
+    } while (small);
+    int i;
+    for (i = 0; i < length; ++i) {
+        digits[i] = reversed[length - 1 - i];
+    }
+    return length;
+}
+
+size_t str_number_format(double value, char* buffer, size_t capacity) {
+    require_address(buffer, "NULL number buffer!");
+    require_range(capacity >= STR_NUMBER_FORMAT_SIZE, "Number buffer too small!");
+
+    int negative = signbit(value) != 0;
+    double magnitude = negative ? -value : value;
+    if (isnan(value)) {
+        strcpy(buffer, negative ? "-nan" : "nan");
+        return strlen(buffer);
+    }
+    if (isinf(value)) {
+        strcpy(buffer, negative ? "-inf" : "inf");
+        return strlen(buffer);
+    }
+
+    char digits[STR_NUMBER_MAX_DIGITS + 3];
+    int exponent = 0;
+    int length;
+    if (magnitude < STR_NUMBER_EXACT_INTEGER && magnitude == (double)(uint64_t)magnitude) {
+        length = str_number_integer_digits((uint64_t)magnitude, digits);
+    } else if (!(length = str_number_grisu3(magnitude, digits, &exponent))) {
+        length = str_number_shortest_printf(magnitude, digits, &exponent);
+    }
+    return str_number_layout(buffer, negative, digits, length, exponent);
+}
+
+size_t str_number_format_fixed(double value, uint8_t decimals, char* buffer, size_t capacity) {
+    require_address(buffer, "NULL number buffer!");
+
+    double magnitude = fabs(value);
+    double scaled = decimals <= STR_NUMBER_MAX_POW10 ? magnitude * str_number_pow10[decimals] : STR_NUMBER_EXACT_INTEGER;
+    if (scaled < STR_NUMBER_EXACT_INTEGER) {
+        double whole = floor(scaled);
+        double fraction = scaled - whole;
+        // the multiply rounded by at most half an ulp, so only a near tie needs the exact decimal value
+        if (fabs(fraction - 0.5) > scaled * 2.3e-16 + 1e-300) {
+            char digits[20];
+            int length = str_number_integer_digits((uint64_t)whole + (fraction > 0.5), digits);
+            int padded = length > decimals ? length : decimals + 1;
+            size_t needed = 1 + (size_t)padded + (decimals ? 1 : 0);
+            if (needed >= capacity) {
+                return 0;
+            }
+            char* out = buffer;
+            *out++ = signbit(value) ? '-' : '+';
+            int i;
+            for (i = 0; i < padded; ++i) {
+                if (i == padded - decimals) {
+                    *out++ = '.';
+                }
+                *out++ = i < padded - length ? '0' : digits[i - (padded - length)];
+            }
+            *out = '\0';
+            return (size_t)(out - buffer);
+        }
+    }
+    int written = snprintf(buffer, capacity, "%+.*f", decimals, value);
+    if (written < 0 || (size_t)written >= capacity) {
+        if (capacity) {
+            buffer[0] = '\0';
+        }
+        return 0;
+    }
+    return (size_t)written;
+}
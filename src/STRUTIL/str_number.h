@@ -0,0 +1,78 @@
+/**
+ * @file str_number.h
+ * @brief Decimal literal parsing without strtod on the common paths
+ * @defgroup str_number String Numbers
+ * @{
+ */
+#ifndef STR_NUMBER_H
+#define STR_NUMBER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STR_NUMBER_MAX_TEXT         80      ///< Longest literal the strtod fallback copies (one line)
+#define STR_NUMBER_EXACT_DIGITS     15      ///< Decimal digits always exact in a double
+#define STR_NUMBER_MAX_POW10        22      ///< Largest power of ten exact in a double
+#define STR_NUMBER_FORMAT_SIZE      32      ///< Buffer that fits any str_number_format() output
+#define STR_NUMBER_MAX_DIGITS       17      ///< Digits that identify any double
+
+/**
+ * @brief Parses a decimal literal: [+-]digits[.digits][(e|E)[+-]digits]
+ * @param text Literal text, need not be NUL terminated
+ * @param length Bytes available
+ * @param value Receives the correctly rounded value
+ * @return Bytes consumed, 0 if text does not start with a number
+ *
+ * @details Three paths, cheapest first:
+ * @code
+ * | Path     | When                                         | Cost                         |
+ * |----------|----------------------------------------------|------------------------------|
+ * | integer  | no fraction or exponent, <= 9 digits         | uint32_t multiply-adds       |
+ * | Clinger  | <= 15 significant digits, |exponent| <= 22   | one exact multiply or divide |
+ * | fallback | anything else                                | strtod on a bounded copy     |
+ * @endcode
+ * Both fast paths round exactly like strtod. Parsing stops at the first byte that
+ * cannot continue the literal, so a tokenizer can resume there without rescanning.
+ * The decimal point is always '.', whatever the locale.
+ */
+size_t str_number_parse(const char* text, size_t length, double* value);
+
+/**
+ * @brief Formats the shortest text that reads back as exactly the same double
+ * @param value Value to format
+ * @param buffer Receives the NUL terminated text
+ * @param capacity Size of buffer, at least STR_NUMBER_FORMAT_SIZE
+ * @return Length of the text
+ *
+ * @details The output is byte for byte what printf("%.*g", p, value) prints for the
+ * smallest p that round-trips, except that the fixed layout is kept up to 16 integer
+ * digits as "%.16g" would: 0.1 -> "0.1", 100 -> "100", 1e-05 -> "1e-05", 1e+16 -> "1e+16".
+ * Beyond 16 digits a double can no longer hold every integer, so e-notation is the
+ * only layout that does not print digits the value does not have.
+ * @code
+ * | Path     | When                                          | Cost                        |
+ * |----------|-----------------------------------------------|-----------------------------|
+ * | integer  | integral and below 2^53                       | uint32_t/uint64_t divides   |
+ * | Grisu3   | everything else, ~99.5% of doubles            | three 64x64 multiplies      |
+ * | fallback | Grisu3 cannot prove shortest, or 2^k boundary | "%.*e" + strtod per digit   |
+ * @endcode
+ */
+size_t str_number_format(double value, char* buffer, size_t capacity);
+
+/**
+ * @brief Formats LGP-30 style: explicit sign and a fixed number of decimals
+ * @param value Value to format
+ * @param decimals Digits after the point
+ * @param buffer Receives the NUL terminated text
+ * @param capacity Size of buffer
+ * @return Length of the text, 0 if it does not fit
+ *
+ * @details Byte for byte printf("%+.*f", decimals, value), so 0.25 with 4 decimals is
+ * "+0.2500" the way the Flexowriter typed a fixed point word. Values below 2^53 once
+ * scaled are rounded with one multiply; halfway-close cases and huge values use printf.
+ */
+size_t str_number_format_fixed(double value, uint8_t decimals, char* buffer, size_t capacity);
+
+#endif
+
+/** @} */ // end of str_number group
@@ -0,0 +1,157 @@
+#include "str_scan.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__AVX2__)
+#include <immintrin.h>
+#define STR_SCAN_BLOCK 32
+typedef uint32_t str_scan_mask_t;
+#elif defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#define STR_SCAN_BLOCK 16
+typedef uint32_t str_scan_mask_t;
+#elif defined(__I86__)
+#define STR_SCAN_BLOCK 2
+#define STR_SCAN_SWAR
+typedef uint16_t str_scan_word_t;
+#define STR_SCAN_ONES 0x0101U
+#define STR_SCAN_HIGHS 0x8080U
+#else
+#define STR_SCAN_BLOCK 4
+#define STR_SCAN_SWAR
+typedef uint32_t str_scan_word_t;
+#define STR_SCAN_ONES 0x01010101UL
+#define STR_SCAN_HIGHS 0x80808080UL
+#endif
+
+#ifndef STR_SCAN_SWAR
+
+/**
+ * @brief One bit per byte of the block that equals a or b
+ */
+static inline str_scan_mask_t str_scan_block(const char* ptr, char a, char b) {
+#if STR_SCAN_BLOCK == 32
+    __m256i block = _mm256_loadu_si256((const __m256i*)ptr);
+    __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(a)),
+                                   _mm256_cmpeq_epi8(block, _mm256_set1_epi8(b)));
+    return (str_scan_mask_t)_mm256_movemask_epi8(hits);
+#else
+    __m128i block = _mm_loadu_si128((const __m128i*)ptr);
+    __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(a)),
+                                _mm_cmpeq_epi8(block, _mm_set1_epi8(b)));
+    return (str_scan_mask_t)_mm_movemask_epi8(hits);
+#endif
+}
+
+#define STR_SCAN_NEXT_BIT(mask) ((uint32_t)__builtin_ctz(mask))
+
+#else
+
+/**
+ * @brief Nonzero if any byte of the word equals a or b
+ * @details Classic zero-byte test on word ^ pattern. It may flag bytes above a true
+ *          match, so callers confirm hits byte by byte - it only has to be exact about
+ *          "no match", which it is.
+ */
+static str_scan_word_t str_scan_block(const char* ptr, char a, char b) {
+    str_scan_word_t word;
+    memcpy(&word, ptr, sizeof(word));
+    str_scan_word_t xa = word ^ (str_scan_word_t)(STR_SCAN_ONES * (uint8_t)a);
+    str_scan_word_t xb = word ^ (str_scan_word_t)(STR_SCAN_ONES * (uint8_t)b);
+    return (str_scan_word_t)((((xa - STR_SCAN_ONES) & ~xa) | ((xb - STR_SCAN_ONES) & ~xb)) & STR_SCAN_HIGHS);
+}
+
+#endif
+
+/**
+ * @brief First byte equal to a or b
+ */
+static const char* str_scan_first(const char* ptr, size_t length, char a, char b) {
+    size_t i = 0;
+    for (; i + STR_SCAN_BLOCK <= length; i += STR_SCAN_BLOCK) {
+#ifndef STR_SCAN_SWAR
+        str_scan_mask_t mask = str_scan_block(ptr + i, a, b);
+        if (mask) {
+            return ptr + i + STR_SCAN_NEXT_BIT(mask);
+        }
+#else
+        if (str_scan_block(ptr + i, a, b)) {
+            break;                                  // confirm within this block below
+        }
+#endif
+    }
+    for (; i < length; ++i) {
+        if (ptr[i] == a || ptr[i] == b) {
+            return ptr + i;
+        }
+    }
+    return NULL;
+}
+
+const char* str_scan_line_end(const char* ptr, size_t length) {
+    return str_scan_first(ptr, length, '\r', '\n');
+}
+
+const char* str_scan_byte(const char* ptr, size_t length, char byte) {
+    return str_scan_first(ptr, length, byte, byte);
+}
+
+/**
+ * @brief Stores offset + bias of every byte equal to byte, returning the total count
+ */
+static uint32_t str_scan_collect(const char* ptr, uint32_t length, char byte, uint32_t* out, uint32_t capacity, uint32_t bias) {
+    uint32_t count = 0;
+    uint32_t i = 0;
+    for (; i + STR_SCAN_BLOCK <= length; i += STR_SCAN_BLOCK) {
+#ifndef STR_SCAN_SWAR
+        str_scan_mask_t mask = str_scan_block(ptr + i, byte, byte);
+        while (mask) {
+            if (count < capacity) {
+                out[count] = i + STR_SCAN_NEXT_BIT(mask) + bias;
+            }
+            ++count;
+            mask &= mask - 1;
+        }
+#else
+        if (str_scan_block(ptr + i, byte, byte)) {
+            uint32_t j;
+            for (j = i; j < i + STR_SCAN_BLOCK; ++j) {
+                if (ptr[j] == byte) {
+                    if (count < capacity) {
+                        out[count] = j + bias;
+                    }
+                    ++count;
+                }
+            }
+        }
+#endif
+    }
+    for (; i < length; ++i) {
+        if (ptr[i] == byte) {
+            if (count < capacity) {
+                out[count] = i + bias;
+            }
+            ++count;
+        }
+    }
+    return count;
+}
+
+uint32_t str_scan_positions(const char* ptr, uint32_t length, char byte, uint32_t* positions, uint32_t capacity) {
+    return str_scan_collect(ptr, length, byte, positions, capacity, 0);
+}
+
+uint32_t str_scan_line_offsets(const char* data, uint32_t size, uint32_t* offsets, uint32_t capacity) {
+    if (!size) {
+        return 0;
+    }
+    if (capacity) {
+        offsets[0] = 0;
+    }
+    // every '\n' starts a line at the next byte, except a final one
+    uint32_t count = 1 + str_scan_collect(data, size, '\n', offsets ? offsets + 1 : NULL, capacity ? capacity - 1 : 0, 1);
+    if (data[size - 1] == '\n') {
+        --count;
+    }
+    return count;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file str_scan.h
+ * @brief Many-bytes-at-a-time scanning for line endings and DOPE field delimiters
+ * @defgroup str_scan String Scanning
+ * @{
+ */
+#ifndef STR_SCAN_H
+#define STR_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STR_SCAN_DELIMITER  '\''    ///< DOPE field delimiter
+
+/**
+ * @details The block width is chosen at compile time:
+ * @code
+ * | Target                     | Block    | Method                               |
+ * |----------------------------|----------|--------------------------------------|
+ * | host with __AVX2__         | 32 bytes | _mm256_cmpeq_epi8 + movemask         |
+ * | host with __SSE2__ (x86-64)| 16 bytes | _mm_cmpeq_epi8 + movemask            |
+ * | 32-bit (and other hosts)   |  4 bytes | SWAR zero-byte test on uint32_t      |
+ * | 16-bit DOS (__I86__)       |  2 bytes | SWAR zero-byte test on uint16_t      |
+ * @endcode
+ * Blocks without a match are skipped whole; tails shorter than a block are
+ * checked byte by byte.
+ */
+
+/**
+ * @brief Finds the first '\r' or '\n'
+ * @param ptr Bytes to scan
+ * @param length Number of bytes
+ * @return Pointer to the line ending or NULL if there is none
+ */
+const char* str_scan_line_end(const char* ptr, size_t length);
+
+/**
+ * @brief Finds the first occurrence of a byte (memchr)
+ * @param ptr Bytes to scan
+ * @param length Number of bytes
+ * @param byte Byte to find, e.g. '\n' or STR_SCAN_DELIMITER
+ * @return Pointer to the byte or NULL if there is none
+ */
+const char* str_scan_byte(const char* ptr, size_t length, char byte);
+
+/**
+ * @brief Records every occurrence of a byte in one pass
+ * @param ptr Bytes to scan
+ * @param length Number of bytes
+ * @param byte Byte to find, e.g. STR_SCAN_DELIMITER to split a DOPE line into fields
+ * @param positions Receives the first capacity offsets (may be NULL when capacity is 0)
+ * @param capacity Size of positions
+ * @return Total number of occurrences, which may exceed capacity
+ */
+uint32_t str_scan_positions(const char* ptr, uint32_t length, char byte, uint32_t* positions, uint32_t capacity);
+
+/**
+ * @brief Builds the line start table of a whole buffer in one pass
+ * @param data Buffer to index
+ * @param size Number of bytes
+ * @param offsets Receives the first capacity line start offsets (may be NULL when capacity is 0)
+ * @param capacity Size of offsets
+ * @return Total number of lines, which may exceed capacity - a final line without
+ *         '\n' counts, an empty buffer has none
+ *
+ * @code
+ * uint32_t count = str_scan_line_offsets(data, size, NULL, 0);     // size the table
+ * uint32_t* offsets = alloc((count + 1) * sizeof(uint32_t));
+ * str_scan_line_offsets(data, size, offsets, count);
+ * offsets[count] = size;                                            // sentinel
+ * @endcode
+ */
+uint32_t str_scan_line_offsets(const char* data, uint32_t size, uint32_t* offsets, uint32_t capacity);
+
+#endif
+
+/** @} */ // end of str_scan group
@@ -1,16 +1,19 @@
 #include "str_utils.h"
+#include "str_scan.h"
 #include "../CONTRACT/contract.h"
 
+#include <string.h>
+
 // Trims line endings in-place for any line length
 void str_trim_line_endings(char* line) {
     require_address(line, "NULL line!");
 
-    size_t i;
-    for (i = 0; i < STR_MAX_TERMINAL_INPUT && line[i] != '\0'; i++) {
-        if (line[i] == '\r' || line[i] == '\n') {
-            line[i] = '\0';
-            break;
-        }
+    const char* nul = (const char*)memchr(line, '\0', STR_MAX_TERMINAL_INPUT);
+    size_t length = nul ? (size_t)(nul - line) : STR_MAX_TERMINAL_INPUT;
+    const char* ending = str_scan_line_end(line, length);
+    size_t i = ending ? (size_t)(ending - line) : length;
+    if (ending) {
+        line[i] = '\0';
     }
     require(i > 0, "ZERO line length!"); // Reject empty strings
     // Force null-termination if hit limit with no \r or \n or \0
@@ -0,0 +1,111 @@
+#include "str_view.h"
+#include "str_scan.h"
+#include "../CONTRACT/contract.h"
+
+#include <string.h>
+
+#define STR_VIEW_IS_SPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+
+str_view_t str_view_make(const char* ptr, size_t length) {
+    require(ptr || !length, "NULL view bytes!");
+    str_view_t view = { ptr, length };
+    return view;
+}
+
+str_view_t str_view_from_cstr(const char* text) {
+    require_address(text, "NULL string!");
+    return str_view_make(text, strlen(text));
+}
+
+bool str_view_is_blank(str_view_t view) {
+    return str_view_trim_left(view).length == 0;
+}
+
+str_view_t str_view_trim_left(str_view_t view) {
+    while (view.length && STR_VIEW_IS_SPACE(view.ptr[0])) {
+        ++view.ptr;
+        --view.length;
+    }
+    return view;
+}
+
+str_view_t str_view_trim_right(str_view_t view) {
+    while (view.length && STR_VIEW_IS_SPACE(view.ptr[view.length - 1])) {
+        --view.length;
+    }
+    return view;
+}
+
+str_view_t str_view_trim(str_view_t view) {
+    return str_view_trim_right(str_view_trim_left(view));
+}
+
+str_view_t str_view_before(str_view_t view, char byte) {
+    const char* found = view.length ? str_scan_byte(view.ptr, view.length, byte) : NULL;
+    if (found) {
+        view.length = (size_t)(found - view.ptr);
+    }
+    return view;
+}
+
+int str_view_compare(str_view_t a, str_view_t b) {
+    size_t common = a.length < b.length ? a.length : b.length;
+    int order = common ? memcmp(a.ptr, b.ptr, common) : 0;
+    if (order) {
+        return order;
+    }
+    return a.length < b.length ? -1 : a.length > b.length;
+}
+
+bool str_view_equals(str_view_t a, str_view_t b) {
+    return a.length == b.length && (!a.length || memcmp(a.ptr, b.ptr, a.length) == 0);
+}
+
+bool str_view_equals_cstr(str_view_t view, const char* text) {
+    require_address(text, "NULL string!");
+    return str_view_equals(view, str_view_from_cstr(text));
+}
+
+bool str_view_has_prefix(str_view_t view, const char* prefix) {
+    require_address(prefix, "NULL prefix!");
+    size_t length = strlen(prefix);
+    return view.length >= length && memcmp(view.ptr, prefix, length) == 0;
+}
+
+bool str_view_split(str_view_t* rest, char delimiter, str_view_t* field) {
+    require_address(rest, "NULL view!");
+    require_address(field, "NULL field!");
+
+    if (!rest->ptr) {
+        return false;                                   // the last field was already taken
+    }
+    const char* found = rest->length ? str_scan_byte(rest->ptr, rest->length, delimiter) : NULL;
+    if (!found) {
+        *field = *rest;
+        rest->ptr = NULL;
+        rest->length = 0;
+        return true;
+    }
+    field->ptr = rest->ptr;
+    field->length = (size_t)(found - rest->ptr);
+    rest->length -= field->length + 1;
+    rest->ptr = found + 1;
+    return true;
+}
+
+size_t str_view_tokenize(str_view_t line, char delimiter, str_view_t* fields, size_t capacity) {
+    require(fields || !capacity, "NULL fields!");
+
+    if (str_view_is_blank(line)) {
+        return 0;
+    }
+    size_t count = 0;
+    str_view_t field;
+    while (str_view_split(&line, delimiter, &field)) {
+        if (count < capacity) {
+            fields[count] = str_view_trim(field);
+        }
+        ++count;
+    }
+    return count;
+}
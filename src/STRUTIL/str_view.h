@@ -0,0 +1,108 @@
+/**
+ * @file str_view.h
+ * @brief Non-owning string views: split, trim, compare, tokenize without copying
+ * @defgroup str_view String Views
+ * @{
+ */
+#ifndef STR_VIEW_H
+#define STR_VIEW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Pointer and length into someone else's bytes, not NUL terminated
+ *
+ * @details No function here allocates or writes to the viewed bytes, so views over
+ * a read buffer, an arena line or a mapped file are all equally cheap. A view lives
+ * as long as the bytes it points at.
+ */
+typedef struct {
+    const char* ptr;
+    size_t length;
+} str_view_t;
+
+/**
+ * @brief Makes a view
+ */
+str_view_t str_view_make(const char* ptr, size_t length);
+
+/**
+ * @brief Views a NUL terminated string (without the NUL)
+ */
+str_view_t str_view_from_cstr(const char* text);
+
+/**
+ * @brief Checks for a view with nothing but spaces, tabs and line endings
+ */
+bool str_view_is_blank(str_view_t view);
+
+/**
+ * @brief Drops leading spaces, tabs and line endings
+ */
+str_view_t str_view_trim_left(str_view_t view);
+
+/**
+ * @brief Drops trailing spaces, tabs and line endings
+ */
+str_view_t str_view_trim_right(str_view_t view);
+
+/**
+ * @brief Drops both
+ */
+str_view_t str_view_trim(str_view_t view);
+
+/**
+ * @brief Cuts the view before the first occurrence of a byte, e.g. '#' for a trailing comment
+ * @return The view up to the byte, or the whole view if the byte does not occur
+ */
+str_view_t str_view_before(str_view_t view, char byte);
+
+/**
+ * @brief Orders views like strcmp, a shorter view sorting before its extensions
+ * @return < 0, 0 or > 0
+ */
+int str_view_compare(str_view_t a, str_view_t b);
+
+/**
+ * @brief Checks two views for equal bytes
+ */
+bool str_view_equals(str_view_t a, str_view_t b);
+
+/**
+ * @brief Checks a view against a NUL terminated string
+ */
+bool str_view_equals_cstr(str_view_t view, const char* text);
+
+/**
+ * @brief Checks whether a view starts with a NUL terminated prefix
+ */
+bool str_view_has_prefix(str_view_t view, const char* prefix);
+
+/**
+ * @brief Pops the next field off the front of a view
+ * @param rest View to split, advanced past the field and its delimiter
+ * @param delimiter Field separator
+ * @param field Receives the field (may be empty)
+ * @return false once rest was already exhausted
+ *
+ * @code
+ * str_view_t rest = str_view_from_cstr("a''b"), field;
+ * while (str_view_split(&rest, '\'', &field)) { ... }    // "a", "", "b"
+ * @endcode
+ */
+bool str_view_split(str_view_t* rest, char delimiter, str_view_t* field);
+
+/**
+ * @brief Splits a whole line into trimmed fields in one pass
+ * @param line Line to split, e.g. "5'+'A'B'C"
+ * @param delimiter Field separator, STR_SCAN_DELIMITER for DOPE
+ * @param fields Receives the first capacity fields
+ * @param capacity Size of fields
+ * @return Total number of fields, which may exceed capacity; 0 for a blank line
+ */
+size_t str_view_tokenize(str_view_t line, char delimiter, str_view_t* fields, size_t capacity);
+
+#endif
+
+/** @} */ // end of str_view group
@@ -0,0 +1,147 @@
+/**
+ * @file test_str_view.h
+ * @brief Test suite for string views and the field tokenizer
+ * @ingroup tdd_framework
+ */
+#ifndef TEST_STR_VIEW_H
+#define TEST_STR_VIEW_H
+
+#include "str_view.h"
+#include "../TDD/tdd_macros.h"
+#include <stdio.h>
+#include <string.h>
+
+#define STR_VIEW_TESTS &test_str_view_split,                \
+    &test_str_view_tokenize,                                \
+    &test_str_view_trim_compare
+
+#define TEST_STR_VIEW_FIELDS    8
+
+/* ----------------- Split Tests ----------------- */
+
+/**
+ * @brief Fields popped off the front, empty ones included
+ * @details Verifies:
+ * - "a''b" gives "a", "" and "b"; a trailing delimiter gives a last empty field
+ * - a lone delimiter gives two empty fields, an empty view one
+ * - a NULL view, str_view_make(NULL, 0), gives none: it reads as already split
+ * - once split returns false it keeps doing so
+ */
+TEST(test_str_view_split)
+{
+    static const struct {
+        const char* text;
+        const char* fields[4];
+        size_t count;
+    } cases[] = {
+        { "a''b",   { "a", "", "b" },   3 },
+        { "a'",     { "a", "" },        2 },
+        { "'",      { "", "" },         2 },
+        { "",       { "" },             1 },
+        { "whole",  { "whole" },        1 },
+        { NULL,     { NULL },           0 }
+    };
+
+    size_t i;
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        str_view_t rest = cases[i].text ? str_view_from_cstr(cases[i].text) : str_view_make(NULL, 0);
+        str_view_t field;
+        size_t count = 0;
+        while (str_view_split(&rest, '\'', &field)) {
+            if (count < cases[i].count) {
+                EXPECT(str_view_equals_cstr(field, cases[i].fields[count]));
+            }
+            ++count;
+        }
+        EXPECT(count == cases[i].count);
+        EXPECT(!str_view_split(&rest, '\'', &field));
+        V(printf("\"%s\": %u fields\n", cases[i].text ? cases[i].text : "(NULL)", (unsigned)count););
+    }
+}
+
+/* ----------------- Tokenizer Tests ----------------- */
+
+/**
+ * @brief Whole lines split into trimmed fields
+ * @details Verifies:
+ * - DOPE lines split on the delimiter, with spaces around fields trimmed
+ * - empty trailing fields count ("4'E'" has three fields)
+ * - blank lines, NULL ones included, have no fields at all
+ * - the count is the total even when fields has less room, and only capacity
+ *   fields are written; a capacity of 0 with no fields array just counts
+ */
+TEST(test_str_view_tokenize)
+{
+    static const struct {
+        const char* text;
+        const char* fields[6];
+        size_t count;
+    } cases[] = {
+        { "5'+'A'B'C",              { "5", "+", "A", "B", "C" },    5 },
+        { " 60 ' C ' A'0 '70'80 ",  { "60", "C", "A", "0", "70", "80" }, 6 },
+        { "4'E'",                   { "4", "E", "" },               3 },
+        { "''",                     { "", "", "" },                 3 },
+        { "  \t\r\n",               { NULL },                       0 },
+        { "",                       { NULL },                       0 }
+    };
+    str_view_t fields[TEST_STR_VIEW_FIELDS];
+
+    size_t i;
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        size_t count = str_view_tokenize(str_view_from_cstr(cases[i].text), '\'', fields, TEST_STR_VIEW_FIELDS);
+        EXPECT(count == cases[i].count);
+        size_t f;
+        for (f = 0; f < count && f < cases[i].count; ++f) {
+            EXPECT(str_view_equals_cstr(fields[f], cases[i].fields[f]));
+        }
+    }
+    EXPECT(str_view_tokenize(str_view_make(NULL, 0), '\'', fields, TEST_STR_VIEW_FIELDS) == 0);
+
+    /* more fields than room: the total comes back, nothing past capacity is written */
+    str_view_t sentinel = str_view_from_cstr("untouched");
+    fields[2] = sentinel;
+    EXPECT(str_view_tokenize(str_view_from_cstr("1'2'3'4"), '\'', fields, 2) == 4);
+    EXPECT(str_view_equals_cstr(fields[0], "1") && str_view_equals_cstr(fields[1], "2"));
+    EXPECT(fields[2].ptr == sentinel.ptr && fields[2].length == sentinel.length);
+    EXPECT(str_view_tokenize(str_view_from_cstr("1'2'3'4"), '\'', NULL, 0) == 4);
+}
+
+/* ----------------- Trim and Compare Tests ----------------- */
+
+/**
+ * @brief Trimming, cutting and comparing without copies
+ * @details Verifies trim on either side, str_view_before() with and without the
+ *          byte, strcmp order with shorter views first, equality of empty views
+ *          whatever their pointer, prefixes and blank checks.
+ */
+TEST(test_str_view_trim_compare)
+{
+    str_view_t padded = str_view_from_cstr(" \t x y \r\n");
+    EXPECT(str_view_equals_cstr(str_view_trim(padded), "x y"));
+    EXPECT(str_view_equals_cstr(str_view_trim_left(padded), "x y \r\n"));
+    EXPECT(str_view_equals_cstr(str_view_trim_right(padded), " \t x y"));
+    EXPECT(str_view_trim(str_view_from_cstr(" \r\n")).length == 0);
+
+    EXPECT(str_view_equals_cstr(str_view_before(str_view_from_cstr("1'P'1 # note"), '#'), "1'P'1 "));
+    EXPECT(str_view_equals_cstr(str_view_before(str_view_from_cstr("1'P'1"), '#'), "1'P'1"));
+    EXPECT(str_view_before(str_view_from_cstr("#"), '#').length == 0);
+    EXPECT(str_view_before(str_view_make(NULL, 0), '#').length == 0);
+
+    EXPECT(str_view_compare(str_view_from_cstr("ab"), str_view_from_cstr("abc")) < 0);
+    EXPECT(str_view_compare(str_view_from_cstr("abc"), str_view_from_cstr("ab")) > 0);
+    EXPECT(str_view_compare(str_view_from_cstr("abd"), str_view_from_cstr("abc")) > 0);
+    EXPECT(str_view_compare(str_view_from_cstr("abc"), str_view_make("abcdef", 3)) == 0);
+    EXPECT(str_view_compare(str_view_make(NULL, 0), str_view_from_cstr("")) == 0);
+    EXPECT(str_view_equals(str_view_make(NULL, 0), str_view_from_cstr("")));
+    EXPECT(!str_view_equals(str_view_from_cstr("a"), str_view_from_cstr("b")));
+
+    EXPECT(str_view_has_prefix(str_view_from_cstr("SQR'4'X"), "SQR"));
+    EXPECT(!str_view_has_prefix(str_view_from_cstr("SQ"), "SQR"));
+    EXPECT(str_view_has_prefix(str_view_make(NULL, 0), ""));
+
+    EXPECT(str_view_is_blank(str_view_from_cstr(" \t\r\n")));
+    EXPECT(str_view_is_blank(str_view_make(NULL, 0)));
+    EXPECT(!str_view_is_blank(str_view_from_cstr("  x")));
+}
+
+#endif
@@ -1,6 +1,188 @@
-#include "CONTRACT/demo_contracts.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
 
-int main() {
-    demo_contracts();
-    return 0;
+#include "DOPE/dope_batch.h"
+#include "DOPE/dope_cache.h"
+#include "DOPE/dope_exec.h"
+#include "DOS/dos_last_error.h"
+#include "DOS/dos_services_files.h"
+#include "DOS/dos_services_files_constants.h"
+#include "FILEUTIL/file_source.h"
+#include "MEM/mem_arena.h"
+
+#ifdef __DOS__
+#define DOPE_ARENA_POLICY   MEM_ARENA_POLICY_DOS
+#else
+#define DOPE_ARENA_POLICY   MEM_ARENA_POLICY_C
+#endif
+#define DOPE_ARENA_SIZE     MEM_SIZE_32K
+#define DOPE_EXIT_USAGE     0x40    // exit codes below are dope_status_t
+#define DOPE_EXIT_COMPILE   0x41
+#define DOPE_BATCH_SUMMARY  "DOPE.CSV"
+#define DOPE_BATCH_INSTRUCTIONS 100000000UL     // batch budget unless -i/-t say otherwise
+#define DOPE_BATCH_MILLISECONDS 10000UL
+
+/*
+ * dope -b <directory|manifest> [summary]
+ * Runs every program of a directory, or every line of a manifest, on all cores and
+ * writes one CSV row per run to the summary (DOPE.CSV by default).
+ */
+static int dope_batch(const char* jobs_path, const char* summary_path, const dope_budget_t* budget) {
+    mem_arena_t* arena = mem_arena_create(MEM_ARENA_POLICY_C, MEM_SIZE_64K);
+    if (!arena) {
+        dos_last_error_dump(stderr);
+        return DOPE_EXIT_USAGE;
+    }
+    dope_batch_job_t* jobs;
+    dos_file_attributes_t attributes = dos_get_file_attributes(jobs_path);
+    uint16_t count = (attributes & DOS_FILE_ATTRIBUTE_DIRECTORY) ? dope_batch_directory(arena, jobs_path, &jobs)
+                                                                 : dope_batch_manifest(arena, jobs_path, &jobs);
+    if (!count) {
+        fprintf(stderr, "%s: no programs to run\n", jobs_path);
+        dos_last_error_dump(stderr);
+        mem_arena_delete(arena);
+        return DOPE_EXIT_USAGE;
+    }
+
+    dope_batch_t* batch = dope_batch_create(arena, 0, DOPE_ARENA_SIZE);
+    dope_batch_set_budget(batch, budget);
+    dope_batch_result_t* results = dope_batch_run(batch, jobs, count);
+    uint16_t i, ended = 0;
+    for (i = 0; i < count; ++i) {
+        ended += !results[i].err_code && !results[i].error && results[i].status == DOPE_STATUS_END;
+    }
+    printf("%u programs on %u workers, %u ran to the end\n", (unsigned)count, (unsigned)dope_batch_workers(batch), (unsigned)ended);
+    bool written = dope_batch_summary(results, count, summary_path);
+    if (!written) {
+        fprintf(stderr, "%s: cannot write the summary\n", summary_path);
+    }
+    dope_batch_delete(batch);
+    mem_arena_delete(arena);
+    return written ? 0 : DOPE_EXIT_USAGE;
+}
+
+/*
+ * Reads the options in front of the program or -b:
+ *   -i <n>     stop a run after about n instructions
+ *   -t <ms>    stop a run after ms milliseconds
+ *   -m <n>     stop a run whose arena holds more than n bytes
+ *   -p <csv>   profile the run, report the hot lines and write every count to csv
+ *   -b         run a batch
+ * Returns the index of the first argument after them, 0 for an unknown option.
+ */
+static int dope_options(int argc, char* argv[], dope_budget_t* budget, bool* batch, const char** profile) {
+    int i;
+    for (i = 1; i < argc && (argv[i][0] == '-' || argv[i][0] == '/') && argv[i][1] && !argv[i][2]; ++i) {
+        char option = (char)toupper((unsigned char)argv[i][1]);
+        if (option == 'B') {
+            *batch = true;
+            continue;
+        }
+        if (i + 1 == argc) {
+            return 0;
+        }
+        if (option == 'P') {
+            *profile = argv[++i];
+            continue;
+        }
+        unsigned long value = strtoul(argv[++i], NULL, 10);
+        switch (option) {
+        case 'I': budget->instructions = (uint32_t)value; break;
+        case 'T': budget->milliseconds = (uint32_t)value; break;
+        case 'M': budget->arena_bytes = (mem_size_t)value; break;
+        default: return 0;
+        }
+    }
+    return i;
+}
+
+/*
+ * dope [options] <program> [answers]
+ * Compiles the program, or loads it from PROGRAM.DPC if that is current, and runs it.
+ * J and A read the answers file one line per number, or the console if there is none.
+ * A profiled program is compiled as written, neither optimized nor cached, so every
+ * instruction is one source line.
+ */
+int main(int argc, char* argv[]) {
+    dope_budget_t budget = { 0, 0, 0 };
+    bool batch = false;
+    const char* profile_path = NULL;
+    int first = dope_options(argc, argv, &budget, &batch, &profile_path);
+    if (batch && !profile_path && first && argc - first >= 1 && argc - first <= 2) {
+        if (!budget.instructions && !budget.milliseconds) {
+            budget.instructions = DOPE_BATCH_INSTRUCTIONS;
+            budget.milliseconds = DOPE_BATCH_MILLISECONDS;
+        }
+        return dope_batch(argv[first], argc - first == 2 ? argv[first + 1] : DOPE_BATCH_SUMMARY, &budget);
+    }
+    if (batch || !first || argc - first < 1 || argc - first > 2) {
+        fprintf(stderr, "Usage: dope [-i instructions] [-t milliseconds] [-m bytes] [-p profile] <program> [answers]\n"
+                        "       dope [-i instructions] [-t milliseconds] [-m bytes] -b <directory|manifest> [summary]\n");
+        return DOPE_EXIT_USAGE;
+    }
+    const char* program_path = argv[first];
+    const char* answers_path = argc - first == 2 ? argv[first + 1] : NULL;
+    mem_arena_t* arena = mem_arena_create(DOPE_ARENA_POLICY, DOPE_ARENA_SIZE);
+    if (!arena) {
+        dos_last_error_dump(stderr);
+        return DOPE_EXIT_USAGE;
+    }
+
+    dope_diagnostic_t diagnostic;
+    dope_program_t* program = profile_path ? dope_compile_file(arena, program_path, &diagnostic)
+                                           : dope_cache_open(arena, program_path, &diagnostic);
+    if (!program) {
+        fprintf(stderr, "%s:%lu: %s\n", program_path, (unsigned long)diagnostic.source_line, dope_compile_message(diagnostic.error));
+        if (diagnostic.error == DOPE_COMPILE_UNREADABLE) {
+            dos_last_error_dump(stderr);
+        }
+        mem_arena_delete(arena);
+        return DOPE_EXIT_COMPILE;
+    }
+
+#ifdef __DOS__
+    file_source_t* input = answers_path ? file_source_replay(arena, answers_path) : file_source_dos(arena, "CON", DOPE_INPUT_BUFFER);
+#else
+    file_source_t* input = answers_path ? file_source_replay(arena, answers_path) : file_source_fd(arena, 0, DOPE_INPUT_BUFFER);
+#endif
+    if (!input) {
+        dos_last_error_dump(stderr);
+        mem_arena_delete(arena);
+        return DOPE_EXIT_USAGE;
+    }
+
+    dope_machine_t* machine = dope_exec_create(arena, program, input, stdout);
+    if (!machine) {
+        dos_last_error_dump(stderr);
+        file_source_close(input);
+        mem_arena_delete(arena);
+        return DOPE_STATUS_MEMORY_LIMIT;
+    }
+    dope_exec_set_budget(machine, &budget);
+    dope_profile_t* profile = NULL;
+    if (profile_path) {
+        profile = (dope_profile_t*)mem_arena_calloc(arena, sizeof(dope_profile_t));
+        if (!profile) {
+            fprintf(stderr, "No memory left to profile\n");
+            file_source_close(input);
+            mem_arena_delete(arena);
+            return DOPE_EXIT_USAGE;
+        }
+        dope_exec_set_profile(machine, profile);
+    }
+    dope_status_t status = dope_exec_run(machine);
+    putchar('\n');
+    if (status != DOPE_STATUS_END) {
+        fprintf(stderr, "Line %u: %s\n", (unsigned)dope_exec_line(machine), dope_exec_status_message(status));
+    }
+    if (profile) {
+        dope_profile_report(profile, stderr);
+        if (!dope_profile_csv(profile, profile_path)) {
+            fprintf(stderr, "%s: cannot write the profile\n", profile_path);
+        }
+    }
+    file_source_close(input);
+    mem_arena_delete(arena);
+    return (int)status;
 }